@@ -13,9 +13,16 @@ in vec4 in_vertex;
 in vec4 in_normal;
 in vec4 in_texture;
 in vec4 in_biome;
+in vec4 in_lightcolor;
+in uvec4 in_packed;
+uniform bool packedVertices;
+in uvec4 in_instance;
+in uvec4 in_instcolor;
+uniform bool instancedModels;
 
 out vec3 texCoord;
 out vec3 lightdata;
+out vec3 torchcolor;
 out vec4 biomeColor;
 flat out float worldLight;
 out float dist;
@@ -23,9 +30,12 @@ out float dist;
 const float VERTEX_SCALE_INV
 const float ZFAR
 const float WATERLEVEL
+const float BLOCKS_Y
 
 void main(void)
 {
+	#include "unpack_vertex.glsl"
+	#include "unpack_instance.glsl"
   vec3 translation = texelFetch(buftex, int(in_vertex.w)).xyz;
   vec4 position = vec4(in_vertex.xyz * VERTEX_SCALE_INV + translation, 1.0);
 	gl_ClipDistance[0] = position.y - WATERLEVEL;
@@ -54,6 +64,7 @@ uniform float modulation;
 
 in vec3 texCoord;
 in vec3 lightdata;
+in vec3 torchcolor;
 in vec4 biomeColor;
 flat in float worldLight;
 in float dist;
@@ -16,8 +16,10 @@ in vec4 in_vertex;
 in vec4 in_normal;
 in vec4 in_texture;
 in vec4 in_biome;
+in vec4 in_lightcolor;
 
 out vec3 lightdata;
+out vec3 torchcolor;
 out vec4 waterColor;
 
 out vec3 v_pos;
@@ -25,6 +27,8 @@ flat out vec3 v_normal;
 out vec3 w_vertex;
 
 const float VERTEX_SCALE_INV
+const float WATERLEVEL
+const float BLOCKS_Y
 
 void main(void)
 {
@@ -14,15 +14,19 @@ in vec4 in_vertex;
 in vec4 in_normal;
 in vec4 in_texture;
 in vec4 in_biome;
+in vec4 in_lightcolor;
 
 out vec3 texCoord;
 out vec3 lightdata;
+out vec3 torchcolor;
 out vec4 biomeColor;
 flat out float worldLight;
 
 out vec3 v_normals;
 
 const float VERTEX_SCALE_INV
+const float WATERLEVEL
+const float BLOCKS_Y
 
 void main(void)
 {
@@ -55,6 +59,7 @@ uniform float modulation;
 
 in vec3 texCoord;
 in vec3 lightdata;
+in vec3 torchcolor;
 in vec4 biomeColor;
 flat in float worldLight;
 in vec3 v_normals;
@@ -14,18 +14,25 @@ in vec4 in_vertex;
 in vec4 in_normal;
 in vec4 in_texture;
 in vec4 in_biome;
+in vec4 in_lightcolor;
+in uvec4 in_packed;
+uniform bool packedVertices;
 
 out vec3 texCoord;
 out vec3 lightdata;
+out vec3 torchcolor;
 out vec4 biomeColor;
 flat out float worldLight;
 
 out vec3 v_normals;
 
 const float VERTEX_SCALE_INV
+const float WATERLEVEL
+const float BLOCKS_Y
 
 void main(void)
 {
+	#include "unpack_vertex.glsl"
   vec3 translation = texelFetch(buftex, int(in_vertex.w)).xyz;
 	vec4 position = vec4(in_vertex.xyz * VERTEX_SCALE_INV + translation, 1.0);
 	position = matview * position;
@@ -55,6 +62,7 @@ uniform float modulation;
 
 in vec3 texCoord;
 in vec3 lightdata;
+in vec3 torchcolor;
 in vec4 biomeColor;
 flat in float worldLight;
 
@@ -13,21 +13,28 @@ in vec4 in_normal;
 in vec4 in_texture;
 in vec4 in_biome;
 in vec4 in_data1;
-in vec4 in_data2;
+in vec4 in_lightcolor;
+in uvec4 in_instance;
+in uvec4 in_instcolor;
+uniform bool instancedModels;
 
 out vec3 texCoord;
 out vec3 lightdata;
+out vec3 torchcolor;
 out vec4 biomeColor;
 flat out vec3 out_normal;
 flat out vec3 v_normals;
 
 const float ZFAR
 const float VERTEX_SCALE_INV
+const float WATERLEVEL
+const float BLOCKS_Y
 const float CROSSWIND_STRENGTH  = 0.5;
 const float PI2                 = 6.28318530717;
 
 void main(void)
 {
+	#include "unpack_instance.glsl"
   vec3 translation = texelFetch(buftex, int(in_vertex.w)).xyz;
   vec4 position = vec4(in_vertex.xyz * VERTEX_SCALE_INV + translation, 1.0);
 	position = matview * position;
@@ -36,7 +43,9 @@ void main(void)
 
 	// standing
 	float speed  = frameCounter * 0.02;
-	float factor = CROSSWIND_STRENGTH * in_data1.r;
+	// instances wave by the texture coordinate, the same as in_data1
+	float wave   = instancedModels ? in_texture.t / 255.0 : in_data1.r;
+	float factor = CROSSWIND_STRENGTH * wave;
 	// crosses waving in the wind
 	vec2 pos = in_vertex.xz * VERTEX_SCALE_INV / 16.0;
 	position.x += factor * sin(PI2 * (2.0*pos.x + pos.y) + speed);
@@ -64,6 +73,7 @@ uniform int   texrange;
 
 in vec3 texCoord;
 in vec3 lightdata;
+in vec3 torchcolor;
 in vec4 biomeColor;
 flat in vec3 out_normal;
 flat in vec3 v_normals;
@@ -17,5 +17,8 @@ cornershad = min(1.0, cornershad * worldLight + brightness * 0.1);
 color.rgb *= cornershad * shadow;
 //color.rgb = vec3(brightness);
 
-const vec3 torchColor = vec3(1.0, 0.94, 0.7);
+// torch chroma is the RGB levels normalized by the brightest level,
+// tinted warm so that uncolored lights look like they always did
+const vec3 torchTint = vec3(1.0, 0.94, 0.7);
+vec3 torchColor = torchTint * min(vec3(1.0), torchcolor / max(brightness, 1.0 / 255.0));
 color.rgb = mix(color.rgb, torchColor, brightness * 0.45);
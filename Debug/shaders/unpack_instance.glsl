@@ -0,0 +1,42 @@
+// models can come as instances (model_instance_t), one per block, which are
+// decoded into the same attributes as the full vertex format, using the
+// vertex of the model from the shared quad indices
+vec4 inst_vertex     = in_vertex;
+vec4 inst_normal     = in_normal;
+vec4 inst_texture    = in_texture;
+vec4 inst_biome      = in_biome;
+vec4 inst_lightcolor = in_lightcolor;
+if (instancedModels)
+{
+	// the cross, as in blockmodels_crosses.cpp and vemitcross.cpp
+	const vec3 CROSS_VERTICES[8] = vec3[8](
+		vec3(0.0, 0.0, 0.0), vec3(1.0, 0.0, 1.0), vec3(1.0, 1.0, 1.0), vec3(0.0, 1.0, 0.0),
+		vec3(1.0, 0.0, 0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 1.0), vec3(1.0, 1.0, 0.0));
+	const int CROSS_CORNER[8] = int[8](0, 1, 1, 0, 2, 3, 3, 2);
+	const int CROSS_COLOR[8]  = int[8](0, 1, 1, 0, 2, 2, 3, 3);
+	int v = gl_VertexID & 7;
+	uvec3 block = uvec3(in_instance.x & 31u, (in_instance.x >> 5u) & 511u, (in_instance.x >> 14u) & 31u);
+	// random height of the top vertices
+	float height = ((v & 2) != 0) ? float(int((block.x + block.z * 3u) & 7u) - 2) * 5.0 : 0.0;
+	// the column index is a constant attribute for the whole draw call
+	inst_vertex = vec4((vec3(block) + CROSS_VERTICES[v]) / VERTEX_SCALE_INV + vec3(0.0, height, 0.0), in_vertex.w);
+	inst_normal = vec4(0.0, 1.0, 0.0, 1.0);
+
+	int corner = CROSS_CORNER[v];
+	uint light = (in_instance[2 + corner / 2] >> uint((corner & 1) * 16)) & 0xFFFFu;
+	vec2 uv = vec2(float((v & 3) == 1 || (v & 3) == 2), float((v & 3) >= 2));
+	inst_texture = vec4(uv / VERTEX_SCALE_INV, float(in_instance.y & 0xFFFFu), float(light));
+	uint color = in_instcolor[CROSS_COLOR[v]];
+	inst_biome = vec4(uvec4(color, color >> 8u, color >> 16u, color >> 24u) & 255u) / 255.0;
+	inst_lightcolor = vec4(vec3(float(light >> 8u) / 255.0), 0.0);
+}
+#undef in_vertex
+#undef in_normal
+#undef in_texture
+#undef in_biome
+#undef in_lightcolor
+#define in_vertex     inst_vertex
+#define in_normal     inst_normal
+#define in_texture    inst_texture
+#define in_biome      inst_biome
+#define in_lightcolor inst_lightcolor
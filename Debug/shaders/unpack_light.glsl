@@ -1,3 +1,9 @@
-
 int light = int(in_texture.w);
-lightdata = vec3(float(light & 0xFF) / 255.0, float((light >> 8) & 0xFF) / 255.0, in_normal.w);
+// vertices carry raw skylight levels (level * 17), so that moving the sun
+// never requires remeshing: the falloff is applied here, daylight in stdlight
+float skylevel = float(light & 0xFF) / 17.0;
+float skydepth = 1.0 - min(in_vertex.y * VERTEX_SCALE_INV + translation.y, WATERLEVEL) / BLOCKS_Y;
+float skylight = (25.0 + 230.0 * pow(0.88, (15.0 - skylevel) * skydepth * skydepth)) / 255.0;
+lightdata = vec3(skylight, float((light >> 8) & 0xFF) / 255.0, in_normal.w);
+// RGB torchlight levels, same scale as the torch channel
+torchcolor = in_lightcolor.rgb;
@@ -0,0 +1,26 @@
+// plain terrain faces can come as packed vertices (terrain_vertex_t),
+// which are decoded into the same attributes as the full vertex format
+vec4 vtx_vertex     = in_vertex;
+vec4 vtx_normal     = in_normal;
+vec4 vtx_texture    = in_texture;
+vec4 vtx_biome      = in_biome;
+vec4 vtx_lightcolor = in_lightcolor;
+if (packedVertices)
+{
+	const vec3 FACE_NORMALS[6] = vec3[6](
+		vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0),
+		vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0),
+		vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0));
+	// the column index is a constant attribute for the whole draw call
+	vtx_vertex = vec4(vec3(in_packed.x & 31u, (in_packed.x >> 5u) & 511u, (in_packed.x >> 14u) & 31u) / VERTEX_SCALE_INV, in_vertex.w);
+	vtx_normal = vec4(FACE_NORMALS[(in_packed.x >> 19u) & 7u], float(in_packed.x >> 22u) / 127.0);
+	vtx_texture = vec4(vec2(in_packed.y & 4095u, (in_packed.y >> 12u) & 4095u) * 0.25 / VERTEX_SCALE_INV,
+	                   float(in_packed.z & 0xFFFFu), float(in_packed.z >> 16u));
+	vtx_biome = vec4(uvec4(in_packed.w, in_packed.w >> 8u, in_packed.w >> 16u, in_packed.w >> 24u) & 255u) / 255.0;
+	vtx_lightcolor = vec4(vec3(float(in_packed.z >> 24u) / 255.0), 0.0);
+}
+#define in_vertex     vtx_vertex
+#define in_normal     vtx_normal
+#define in_texture    vtx_texture
+#define in_biome      vtx_biome
+#define in_lightcolor vtx_lightcolor
@@ -92,7 +92,7 @@ namespace cppcraft
 		{
       this->setChannel(1, level);
 		}
-		inline light_t getTorchLight()
+		inline light_t getTorchLight() const
 		{
 			return this->getChannel(1);
 		}
@@ -162,6 +162,15 @@ namespace cppcraft
 		{
 			return (db().opacity >> (ch << 2)) & 0xF;
 		}
+		// emission level of a light, which is its brightest color channel
+		light_t getLightLevel() const
+		{
+			const auto op = db().opacity;
+			light_t lvl = op & 0xF;
+			if (((op >> 4) & 0xF) > lvl) lvl = (op >> 4) & 0xF;
+			if (((op >> 8) & 0xF) > lvl) lvl = (op >> 8) & 0xF;
+			return lvl;
+		}
 
     short getTexture(uint8_t face) const
     {
@@ -235,7 +244,7 @@ namespace cppcraft
 			return true;
 		}
 		//! returns true if this block allows you to place something on @face
-		bool placeOntoThis(uint8_t face)
+		bool placeOntoThis(uint8_t face) const
 		{
 			(void) face;
 			return !isCross();
@@ -273,7 +282,7 @@ namespace cppcraft
 		{
 			return db().tall;
 		}
-		// half a block tall
+		// half a block tall
 		bool isHalfblock() const
 		{
 			return false;
@@ -310,9 +319,31 @@ namespace cppcraft
 
   inline short Block::getConnectedTexture(const db::BlockData& db, uint8_t face) const
   {
-    connected_textures_t ct;
-    ct.blocks[4] = *this;
-    return db.connTexFunction(ct, face);
+    // on its own, without any neighbors
+    return db.getConnectedTexture(face, 0);
+  }
+}
+
+namespace db
+{
+  // runs the function once for every face and set of neighbors, so that
+  // the mesher only has to build the neighbor mask
+  inline void BlockData::useConnectedTexture(const conntex_func_t& func)
+  {
+    texture_mode = texmode_t::CONNECTED_TEXTURE;
+    conntex_table.resize(6 * 256);
+    cppcraft::connected_textures_t ct;
+    for (int face = 0; face < 6; face++)
+    for (int mask = 0; mask < 256; mask++)
+    {
+      for (int i = 0; i < 9; i++)
+      {
+        const int bit = (i < 4) ? i : i - 1;
+        const bool same = (i == 4) || (mask >> bit) & 1;
+        ct.blocks[i] = Block(same ? getID() : _AIR);
+      }
+      conntex_table[face * 256 + mask] = func(ct, face);
+    }
   }
 }
 
@@ -18,7 +18,8 @@ namespace cppcraft
 	const float BIOME_SCALE = 0.0003f;
   const float UNDERGEN_SCALE = 0.001f;
 
-	typedef uint32_t light_value_t;
+	// skylight, torchlight and AO bytes, then RGB torchlight bytes at bit 32
+	typedef uint64_t light_value_t;
 }
 
 extern void dump_trace();
@@ -3,6 +3,7 @@
 #include <delegate.hpp>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace cppcraft
 {
@@ -74,6 +75,8 @@ namespace db
 
     /// tile, texture & connected texture ///
     typedef delegate<short(const Block&, uint8_t face)> texture_func_t;
+    // may only look at which of the neighbors in the plane of the face are
+    // the same block type, as it is compiled into a table by useConnectedTexture
     typedef delegate<short(const connected_textures_t&, uint8_t face)> conntex_func_t;
     enum class texmode_t : uint8_t {
       TILE_ID = 0,
@@ -83,11 +86,16 @@ namespace db
 
     inline void useTileID(short texid);
     inline void useTextureFunction(texture_func_t);
-    inline void useConnectedTexture(conntex_func_t);
+    inline void useConnectedTexture(const conntex_func_t&);
     inline texmode_t textureMode() const noexcept { return texture_mode; }
     inline short   getTileID() const noexcept { return this->tile_id; }
     texture_func_t textureFunction = nullptr;
-    conntex_func_t connTexFunction = nullptr;
+    // the tile for @face, given the @mask of neighbors in the plane of the
+    // face that are the same block type, one bit for each of the blocks
+    // of connected_textures_t, skipping the center
+    short getConnectedTexture(uint8_t face, uint8_t mask) const noexcept {
+      return conntex_table[face * 256 + mask];
+    }
 
     // returns true if the block has an activation function
 		delegate <bool(const Block&)> hasActivation = nullptr;
@@ -124,7 +132,7 @@ namespace db
 		uint8_t shader = 0;
 		bool repeat_y = true;
 		// if non-zero, block is a light
-		uint8_t opacity = 0;
+		uint16_t opacity = 0;
 		// light travels through transparent blocks
 		bool transparent = false;
     void setBlock(bool v) { block = v; }
@@ -156,6 +164,8 @@ namespace db
     const int id;
     texmode_t texture_mode = texmode_t::TILE_ID;
     short   tile_id = 0;
+    // every face and neighbor mask, when using connected textures
+    std::vector<short> conntex_table;
     short   colorIndex = -1;
     bool    block = true;
     // mesh model index
@@ -173,10 +183,6 @@ namespace db
     texture_mode = texmode_t::STATIC_FUNCTION;
     textureFunction = std::move(func);
   }
-  inline void BlockData::useConnectedTexture(conntex_func_t func) {
-    texture_mode = texmode_t::CONNECTED_TEXTURE;
-    connTexFunction = std::move(func);
-  }
 
   // minimap
   inline uint32_t BlockData::getMinimapColor(
@@ -41,6 +41,11 @@ namespace db
 		{
 			return names.size();
 		}
+		// number of IDs in use, including unnamed ones
+		std::size_t count() const noexcept
+		{
+			return storage.size();
+		}
 
 		// get the instance
 		static Database<Datatype>& get()
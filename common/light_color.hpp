@@ -0,0 +1,76 @@
+#pragma once
+/**
+ * Packed RGB torchlight
+ *
+ * Three 4-bit light levels packed into one 16-bit word, one lane per
+ * color channel. Each lane is 5 bits wide, with the top bit used as a
+ * guard so that all three lanes can be decremented and compared with
+ * a handful of integer ops, instead of looping over channels.
+ *
+ *   bits  0-3: red    (guard: bit 4)
+ *   bits  5-8: green  (guard: bit 9)
+ *   bits 10-13: blue  (guard: bit 14)
+**/
+#include <cstdint>
+
+namespace cppcraft
+{
+  struct LightColor
+  {
+    typedef uint16_t color_t;
+
+    static constexpr color_t LSB    = 0x0421; // lowest bit of each lane
+    static constexpr color_t GUARDS = 0x4210; // guard bit of each lane
+    static constexpr color_t VALUES = 0x3DEF; // value bits of each lane
+
+    static constexpr color_t pack(int r, int g, int b) noexcept {
+      return (r & 0xF) | ((g & 0xF) << 5) | ((b & 0xF) << 10);
+    }
+    static constexpr int red  (color_t c) noexcept { return c & 0xF; }
+    static constexpr int green(color_t c) noexcept { return (c >> 5) & 0xF; }
+    static constexpr int blue (color_t c) noexcept { return (c >> 10) & 0xF; }
+
+    // the same level in all lanes
+    static constexpr color_t gray(int level) noexcept {
+      return (level & 0xF) * LSB;
+    }
+    // converts BlockData opacity (4 bits per channel: R | G << 4 | B << 8)
+    static constexpr color_t fromOpacity(uint16_t op) noexcept {
+      return pack(op, op >> 4, op >> 8);
+    }
+
+    // subtract the same amount from all lanes, clamping at zero
+    static color_t decay(color_t c, int amount) noexcept
+    {
+      const uint32_t x = (c | GUARDS) - (amount & 0xF) * LSB;
+      // guard bit still set means the lane did not underflow
+      const uint32_t keep = x & GUARDS;
+      return x & (keep - (keep >> 4)) & VALUES;
+    }
+    // guard bit set for each lane where a > b
+    static color_t greater(color_t a, color_t b) noexcept
+    {
+      return (((a | GUARDS) - b) - LSB) & GUARDS;
+    }
+    // true if any lane of a is brighter than the same lane of b
+    static bool brighter(color_t a, color_t b) noexcept
+    {
+      return greater(a, b) != 0;
+    }
+    // per-lane maximum
+    static color_t max(color_t a, color_t b) noexcept
+    {
+      const color_t gt = greater(a, b);
+      const color_t mask = gt - (gt >> 4);
+      return ((a & mask) | (b & ~mask)) & VALUES;
+    }
+    // the brightest lane, which is what the single-channel torchlight holds
+    static int intensity(color_t c) noexcept
+    {
+      int v = red(c);
+      if (green(c) > v) v = green(c);
+      if (blue(c) > v) v = blue(c);
+      return v;
+    }
+  };
+}
@@ -15,7 +15,7 @@ namespace cppcraft
     for (int z = -radius; z <= radius; z++)
     {
       storage.emplace_back(
-            sectors(sx+x, sz+z).getBlocks(), x, z);
+            sectors(sx+x, sz+z).snapshot(), x, z);
     }
   }
 
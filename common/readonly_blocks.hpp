@@ -1,19 +1,22 @@
 #pragma once
 #include "sectorblock.hpp"
 #include "common.hpp"
+#include <memory>
+#include <vector>
 
 namespace cppcraft
 {
   struct readonly_wrapper_t
   {
-    readonly_wrapper_t(sectorblock_t& sb, int X, int Z)
-        : blocks(sb), x(X), z(Z) {}
+    readonly_wrapper_t(std::shared_ptr<const sectorblock_t> sb, int X, int Z)
+        : blocks(std::move(sb)), x(X), z(Z) {}
 
     inline const Block& operator() (int x, int y, int z) const {
-      return blocks(x, y, z);
+      return (*blocks)(x, y, z);
     }
 
-    const sectorblock_t blocks;
+    // a shared snapshot, instead of a copy of the whole sector
+    const std::shared_ptr<const sectorblock_t> blocks;
     const int x;
     const int z;
   };
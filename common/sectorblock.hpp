@@ -1,13 +1,74 @@
 #pragma once
 #include "block.hpp"
+#include "light_color.hpp"
 
 #include "common.hpp"
 #include <array>
 #include <cstdint>
+#include <memory>
 
 namespace cppcraft
 {
-  struct sectorblock_t
+  /**
+   * The part of the blocks that is saved to disk, as one raw record per
+   * sector (see Chunks). Its layout is the file format, so anything that
+   * can be rebuilt or is optional lives in sectorblock_t instead.
+   * The emitter list is saved too, so loading never has to search for lights.
+  **/
+  struct sectorblock_record_t
+  {
+    std::array<Block, BLOCKS_XZ * BLOCKS_XZ * BLOCKS_Y> b;
+
+    uint16_t light_count = 0;
+    int16_t  highest_light_y = 0;
+
+    // compact list of light emitters, so that torchlight doesn't have
+    // to scan the whole volume. when it overflows, the per-y light bits
+    // are used to find the lights instead
+    struct emitter_t {
+      uint8_t  x, z;
+      uint16_t y;
+    };
+    static const int MAX_EMITTERS = 256;
+  protected:
+    static const uint16_t EMITTERS_OVERFLOW = 0xFFFF;
+
+    std::array<uint64_t, BLOCKS_Y / 64> m_lights;
+    uint16_t m_version = 0;
+    uint16_t m_emitter_count = 0;
+    std::array<emitter_t, MAX_EMITTERS> m_emitters {};
+  };
+
+  // packed RGB torchlight for a whole sector, which is only allocated
+  // once a color is written, as it is only used with colored lighting
+  class torch_plane_t
+  {
+  public:
+    typedef std::array<LightColor::color_t, BLOCKS_XZ * BLOCKS_XZ * BLOCKS_Y> plane_t;
+
+    torch_plane_t() = default;
+    torch_plane_t(const torch_plane_t& other)
+      : m_plane(other.m_plane ? new plane_t(*other.m_plane) : nullptr) {}
+    torch_plane_t& operator= (const torch_plane_t& other) {
+      m_plane.reset(other.m_plane ? new plane_t(*other.m_plane) : nullptr);
+      return *this;
+    }
+
+    LightColor::color_t get(int i) const noexcept {
+      return m_plane ? (*m_plane)[i] : 0;
+    }
+    LightColor::color_t& at(int i) {
+      if (m_plane == nullptr) m_plane.reset(new plane_t {});
+      return (*m_plane)[i];
+    }
+    bool allocated() const noexcept { return m_plane != nullptr; }
+    void clear() { m_plane = nullptr; }
+
+  private:
+    std::unique_ptr<plane_t> m_plane;
+  };
+
+  struct sectorblock_t : public sectorblock_record_t
   {
     Block& operator() (int x, int y, int z) {
       return b[x * BLOCKS_XZ * BLOCKS_Y + z * BLOCKS_Y + y];
@@ -15,28 +76,66 @@ namespace cppcraft
     const Block& operator() (int x, int y, int z) const {
       return b[x * BLOCKS_XZ * BLOCKS_Y + z * BLOCKS_Y + y];
     }
-    std::array<Block, BLOCKS_XZ * BLOCKS_XZ * BLOCKS_Y> b;
 
-    void setLight(short y) noexcept {
-      m_lights.at(y / 64) |= 1 << (y % 64);
-      if (y > highest_light_y) highest_light_y = y;
+    // packed RGB torchlight, only used when colored lighting is enabled
+    LightColor::color_t& torchColor(int x, int y, int z) {
+      return m_torch.at(x * BLOCKS_XZ * BLOCKS_Y + z * BLOCKS_Y + y);
+    }
+    LightColor::color_t torchColor(int x, int y, int z) const {
+      return m_torch.get(x * BLOCKS_XZ * BLOCKS_Y + z * BLOCKS_Y + y);
+    }
+    bool torchColorsAllocated() const noexcept {
+      return m_torch.allocated();
+    }
+    void clearTorchColors() {
+      m_torch.clear();
+    }
+
+    void addLight(int x, int y, int z) noexcept {
+      setLight(y);
+      if (m_emitter_count >= MAX_EMITTERS) {
+        m_emitter_count = EMITTERS_OVERFLOW;
+        return;
+      }
+      for (int i = 0; i < m_emitter_count; i++)
+        if (m_emitters[i].x == x && m_emitters[i].y == y && m_emitters[i].z == z) return;
+      m_emitters[m_emitter_count++] = {(uint8_t) x, (uint8_t) z, (uint16_t) y};
+    }
+    void removeLight(int x, int y, int z) noexcept {
+      for (int i = 0; i < emitterCount(); i++)
+      if (m_emitters[i].x == x && m_emitters[i].y == y && m_emitters[i].z == z) {
+        m_emitters[i] = m_emitters[--m_emitter_count];
+        return;
+      }
+    }
+    bool emittersOverflowed() const noexcept {
+      return m_emitter_count == EMITTERS_OVERFLOW;
+    }
+    int emitterCount() const noexcept {
+      return emittersOverflowed() ? 0 : m_emitter_count;
+    }
+    const emitter_t* emitters() const noexcept {
+      return m_emitters.data();
     }
     bool getLight(int y) const noexcept {
-      return m_lights.at(y / 64) & (1 << (y % 64));
+      return m_lights.at(y / 64) & (uint64_t(1) << (y % 64));
     }
     void clearLights() {
       for (auto& val : m_lights) val = 0;
+      highest_light_y = 0;
+      m_emitter_count = 0;
     }
 
     uint16_t version() const noexcept { return m_version; }
     void next_version() { m_version++; }
 
-    uint16_t light_count = 0;
-    int16_t  highest_light_y = 0;
   private:
-    std::array<uint64_t, BLOCKS_Y / 64> m_lights;
-    uint16_t m_version = 0;
+    void setLight(short y) noexcept {
+      m_lights.at(y / 64) |= uint64_t(1) << (y % 64);
+      if (y > highest_light_y) highest_light_y = y;
+    }
+    torch_plane_t m_torch;
   };
-  static_assert(sizeof(sectorblock_t::b) == BLOCKS_XZ*BLOCKS_XZ*BLOCKS_Y* sizeof(Block),
+  static_assert(sizeof(sectorblock_record_t::b) == BLOCKS_XZ*BLOCKS_XZ*BLOCKS_Y* sizeof(Block),
                 "The sectorblock array must be the size of an entire sector");
 }
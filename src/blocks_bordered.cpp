@@ -1,154 +1,46 @@
 #include "blocks_bordered.hpp"
 
+#include "lighting.hpp"
 #include "sectors.hpp"
 #include <cstring>
 
 namespace cppcraft
 {
-	bordered_sector_t::bordered_sector_t(Sector& sector)
-    : wx(sector.getWX()), wz(sector.getWZ())
+	static std::shared_ptr<const sectorblock_t> air_blocks()
 	{
-		// copy entire row from sector into sectorblock
-		for (int x = 0; x < BLOCKS_XZ; x++)
-		{
-			Block* src = &sector(x, 0, 0);
-			Block* dst = &get(x, 0, 0);
-			memcpy(dst, src, BLOCKS_XZ * BLOCKS_Y * sizeof(Block));
-		}
-
-		// copy borders from neighbors
-		// (-X)
-		if (sector.getX() > 0)
-		{
-			Sector& nbor = sectors(sector.getX()-1, sector.getZ());
-			for (int z = 0; z < BLOCKS_XZ; z++)
-			{
-				Block* src = &nbor(BLOCKS_XZ-1, 0, z);
-				Block* dst = &get(-1, 0, z);
-				memcpy(dst, src, BLOCKS_Y * sizeof(Block));
-			}
-		}
-		else
-		{
-			// when out of range, we need to set it to _AIR to prevent strange things
-			for (int z = 0; z < BLOCKS_XZ; z++)
-			for (int y = 0; y < BLOCKS_Y; y++)
-				get(-1, y, z) = Block(_AIR);
-		}
-		// (+X)
-		if (sector.getX()+1 < sectors.getXZ())
-		{
-			Sector& nbor = sectors(sector.getX()+1, sector.getZ());
-			for (int z = 0; z < BLOCKS_XZ; z++)
-			{
-				Block* src = &nbor(0, 0, z);
-				Block* dst = &get(BLOCKS_XZ, 0, z);
-				memcpy(dst, src, BLOCKS_Y * sizeof(Block));
-			}
-		}
-		else
-		{
-			// when out of range, we need to set it to _AIR to prevent strange things
-			for (int z = 0; z < BLOCKS_XZ; z++)
-			for (int y = 0; y < BLOCKS_Y; y++)
-				get(BLOCKS_XZ, y, z) = Block(_AIR);
-		}
-		// (-Z)
-		if (sector.getZ() > 0)
-		{
-			Sector& nbor = sectors(sector.getX(), sector.getZ()-1);
-			for (int x = 0; x < BLOCKS_XZ; x++)
-			{
-				Block* src = &nbor(x, 0, BLOCKS_XZ-1);
-				Block* dst = &get(x, 0, -1);
-				memcpy(dst, src, BLOCKS_Y * sizeof(Block));
-			}
-		}
-		else
-		{
-			// when out of range, we need to set it to _AIR to prevent strange things
-			for (int x = 0; x < BLOCKS_XZ; x++)
-			for (int y = 0; y < BLOCKS_Y; y++)
-				get(x, y, -1) = Block(_AIR);
-		}
-		// (+Z)
-		if (sector.getZ()+1 < sectors.getXZ())
-		{
-			Sector& nbor = sectors(sector.getX(), sector.getZ()+1);
-			for (int x = 0; x < BLOCKS_XZ; x++)
-			{
-				Block* src = &nbor(x, 0, 0);
-				Block* dst = &get(x, 0, BLOCKS_XZ);
-				memcpy(dst, src, BLOCKS_Y * sizeof(Block));
-			}
-		}
-		else
-		{
-			// when out of range, we need to set it to _AIR to prevent strange things
-			for (int x = 0; x < BLOCKS_XZ; x++)
-			for (int y = 0; y < BLOCKS_Y; y++)
-				get(x, y, BLOCKS_XZ) = Block(_AIR);
-		}
-		// (-XZ)
-		if (sector.getX() > 0 && sector.getZ() > 0)
-		{
-			Sector& nbor = sectors(sector.getX()-1, sector.getZ()-1);
+		static std::shared_ptr<const sectorblock_t> air = [] {
+			auto blocks = std::make_shared<sectorblock_t> ();
+			for (auto& blk : blocks->b) blk = Block(_AIR);
+			blocks->clearTorchColors();
+			return blocks;
+		}();
+		return air;
+	}
 
-			Block* src = &nbor(BLOCKS_XZ-1, 0, BLOCKS_XZ-1);
-			Block* dst = &get(-1, 0, -1);
-			memcpy(dst, src, BLOCKS_Y * sizeof(Block));
-		}
-		else
-		{
-			// when out of range, we need to set it to _AIR to prevent strange things
-			for (int y = 0; y < BLOCKS_Y; y++)
-				get(-1, y, -1) = Block(_AIR);
-		}
-		// (+XZ)
-		if (sector.getX() < sectors.getXZ()-1
-		 && sector.getZ() < sectors.getXZ()-1)
-		{
-			Sector& nbor = sectors(sector.getX()+1, sector.getZ()+1);
-
-			Block* src = &nbor(0, 0, 0);
-			Block* dst = &get(BLOCKS_XZ, 0, BLOCKS_XZ);
-			memcpy(dst, src, BLOCKS_Y * sizeof(Block));
-		}
-		else
-		{
-			// when out of range, we need to set it to _AIR to prevent strange things
-			for (int y = 0; y < BLOCKS_Y; y++)
-				get(BLOCKS_XZ, y, BLOCKS_XZ) = Block(_AIR);
-		}
-		// (+X-Z)
-		if (sector.getX() < sectors.getXZ()-1 && sector.getZ() > 0)
-		{
-			Sector& nbor = sectors(sector.getX()+1, sector.getZ()-1);
+	bordered_sector_t::bordered_sector_t(Sector& sector)
+	{
+		assign(sector);
+	}
 
-			Block* src = &nbor(0, 0, BLOCKS_XZ-1);
-			Block* dst = &get(BLOCKS_XZ, 0, -1);
-			memcpy(dst, src, BLOCKS_Y * sizeof(Block));
-		}
-		else
-		{
-			// when out of range, we need to set it to _AIR to prevent strange things
-			for (int y = 0; y < BLOCKS_Y; y++)
-				get(BLOCKS_XZ, y, -1) = Block(_AIR);
-		}
-		// (-X+Z)
-		if (sector.getX() > 0 && sector.getZ() < sectors.getXZ()-1)
-		{
-			Sector& nbor = sectors(sector.getX()-1, sector.getZ()+1);
+	void bordered_sector_t::assign(Sector& sector)
+	{
+		this->wx = sector.getWX();
+		this->wz = sector.getWZ();
+		this->source = &sector;
+		this->generation = sector.generation();
+		// share the blocks of the sector and its neighbors
+		for (int dx = -1; dx <= 1; dx++)
+		for (int dz = -1; dz <= 1; dz++)
+		{
+			const int sx = sector.getX() + dx;
+			const int sz = sector.getZ() + dz;
+			auto& snapshot = snapshots[(dx+1) * 3 + (dz+1)];
 
-			Block* src = &nbor(BLOCKS_XZ-1, 0, 0);
-			Block* dst = &get(-1, 0, BLOCKS_XZ);
-			memcpy(dst, src, BLOCKS_Y * sizeof(Block));
-		}
-		else
-		{
-			// when out of range, we need to set it to _AIR to prevent strange things
-			for (int y = 0; y < BLOCKS_Y; y++)
-				get(-1, y, BLOCKS_XZ) = Block(_AIR);
+			if (sx >= 0 && sz >= 0 && sx < sectors.getXZ() && sz < sectors.getXZ())
+				snapshot = sectors(sx, sz).snapshot();
+			else
+				// when out of range, we need it to be _AIR to prevent strange things
+				snapshot = air_blocks();
 		}
 
 		/// flatland data ///
@@ -199,6 +91,13 @@ namespace cppcraft
 			this->fget(BLOCKS_XZ, BLOCKS_XZ) =
 				this->fget(BLOCKS_XZ-1, BLOCKS_XZ-1);
 		}
-	} // bordered_sectorblock_t()
+
+		this->torch_colors = Lighting::coloredTorchlight();
+	} // assign()
+
+	void bordered_sector_t::release()
+	{
+		for (auto& snapshot : snapshots) snapshot = nullptr;
+	}
 
 }
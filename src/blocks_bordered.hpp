@@ -3,24 +3,34 @@
 
 #include "common.hpp"
 #include "sector.hpp"
+#include <array>
+#include <memory>
 
 namespace cppcraft
 {
+	/**
+	 * The blocks of a sector and its 8 neighbors, as seen by a mesh job.
+	 * Blocks are shared snapshots of the sectors (see Sector::snapshot()),
+	 * so nothing is copied unless the world writes to a sector while the
+	 * job still holds it. Coordinates go from -1 to BLOCKS_XZ on x and z.
+	**/
 	struct bordered_sector_t
 	{
 		bordered_sector_t(Sector& sector);
+		// starts over with the blocks of another sector, without allocating
+		void assign(Sector& sector);
 
 		// Block & biome retrieval functions
-		inline Block& get (int bx, int by, int bz)
+		inline const Block& get (int bx, int by, int bz) const
 		{
-			return blks[(bx+1) * (BLOCKS_XZ+2) * BLOCKS_Y + (bz+1) * BLOCKS_Y + by];
+			return blocks(bx, bz)(bx & (BLOCKS_XZ-1), by, bz & (BLOCKS_XZ-1));
 		}
 		inline auto& fget (int bx, int bz)
 		{
 			return flats[bx * (BLOCKS_XZ+1) + bz];
 		}
 
-		Block& operator() (int bx, int by, int bz)
+		const Block& operator() (int bx, int by, int bz) const
 		{
 			return get(bx, by, bz);
 		}
@@ -29,12 +39,32 @@ namespace cppcraft
 			return fget(bx, bz);
 		}
 
-    const int wx, wz;
+		// packed RGB torchlight, only used when colored lighting is enabled
+		bool hasTorchColors() const noexcept { return torch_colors; }
+		inline LightColor::color_t getTorchColor(int bx, int by, int bz) const
+		{
+			return blocks(bx, bz).torchColor(bx & (BLOCKS_XZ-1), by, bz & (BLOCKS_XZ-1));
+		}
+
+		// the sector that owns the (bx, bz) column
+		inline const sectorblock_t& blocks(int bx, int bz) const
+		{
+			return *snapshots[unsigned(bx + BLOCKS_XZ) / BLOCKS_XZ * 3 + unsigned(bz + BLOCKS_XZ) / BLOCKS_XZ];
+		}
+		// lets go of the snapshots, once the mesh is done
+		void release();
+
+    int wx, wz;
+    // the sector, and its generation when the blocks were taken
+    const Sector* source;
+    uint32_t generation;
   private:
-    // all the blocks from source sector and neighbors
-		alignas(32) std::array<Block, (BLOCKS_XZ+2) * (BLOCKS_XZ+2) * BLOCKS_Y> blks;
+    // the source sector and its neighbors, or air outside the world
+		std::array<std::shared_ptr<const sectorblock_t>, 9> snapshots;
 
 		// all the 2D data from source sector and neighbors
  	  alignas(32) std::array<Flatland::flatland_t, (BLOCKS_XZ+1) * (BLOCKS_XZ+1)> flats;
+
+    bool torch_colors;
 	};
 }
@@ -153,7 +153,7 @@ namespace cppcraft
 			// if we failed to read, currentCnt must be set to 0
 			if (!File) currentCnt = 0;
 
-			PL = (1 + chunk_offset) * sizeof(int) + currentCnt * sizeof(sectorblock_t);
+			PL = (1 + chunk_offset) * sizeof(int) + currentCnt * sizeof(sectorblock_record_t);
 
 			// put location of data
 			File.seekp(P);
@@ -168,9 +168,10 @@ namespace cppcraft
 		// reset all state flags
 		File.clear();
 
-		// write sectorblock_t to disk
+		// write the saved part of the blocks to disk
 		File.seekp(PL);
-		File.write( (char*) &s.getBlocks(), sizeof(sectorblock_t) );
+		const sectorblock_record_t& record = s.blocks();
+		File.write( (const char*) &record, sizeof(sectorblock_record_t) );
 
 		if (!File)
 		{
@@ -190,7 +191,10 @@ namespace cppcraft
     auto& blocks = sector.getBlocks();
 
 		File.seekg(PL);
-		File.read( (char*) &blocks, sizeof(sectorblock_t) );
+		sectorblock_record_t& record = blocks;
+		File.read( (char*) &record, sizeof(sectorblock_record_t) );
+		// the colors aren't saved, and come back with the next torchlight pass
+		blocks.clearTorchColors();
 
 		if (!File.good())
 		{
@@ -6,6 +6,7 @@
 #include "renderconst.hpp"
 #include "precompiler.hpp"
 #include "vertex_block.hpp"
+#include <cstdlib>
 #include <cstring>
 
 using namespace library;
@@ -29,6 +30,57 @@ namespace cppcraft
 		this->columns.resize(num_columns);
 	}
 
+	void Columns::moved(const int dx, const int dz, const int wdx, const int wdz)
+	{
+		const int XZ = sectors.getXZ();
+		// nothing is where it was
+		if (std::abs(dx) >= XZ || std::abs(dz) >= XZ) {
+			resetAll();
+			return;
+		}
+		// the rows that came in on the edges, where the ones
+		// that fell off on the opposite edges used to be
+		const int x0 = (dx < 0) ? 0 : XZ - dx;
+		const int x1 = (dx < 0) ? -dx : XZ;
+		for (int x = x0; x < x1; x++)
+		for (int z = 0; z < XZ; z++) reset(x, z, wdx, wdz);
+
+		const int z0 = (dz < 0) ? 0 : XZ - dz;
+		const int z1 = (dz < 0) ? -dz : XZ;
+		for (int x = 0; x < XZ; x++)
+		for (int z = z0; z < z1; z++) reset(x, z, wdx, wdz);
+	}
+
+	unsigned int Columns::quadIndexBuffer()
+	{
+		if (this->quad_ibo == 0)
+		{
+			std::vector<indice_t> indices(quad_indices::MAX_INDICES);
+			quad_indices::generate(indices.data(), quad_indices::MAX_QUADS);
+
+			glGenBuffers(1, &this->quad_ibo);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->quad_ibo);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indice_t),
+			             indices.data(), GL_STATIC_DRAW);
+		}
+		return this->quad_ibo;
+	}
+
+	void Columns::account(const Column& cv, int sign)
+	{
+		int64_t vertices = 0, packed = 0;
+		for (int n = 0; n < RenderConst::MAX_UNIQUE_SHADERS; n++)
+		{
+			vertices += cv.vertices[n];
+			packed   += cv.packed[n];
+		}
+		auto& st = lod_stats.at(cv.lod);
+		st.columns  += sign;
+		st.vertices += sign * (vertices + packed);
+		st.bytes    += sign * (vertices * sizeof(vertex_t) + packed * sizeof(terrain_vertex_t)
+		                       + cv.instances * sizeof(model_instance_t));
+	}
+
 	Column::Column()
 	{
 		// initialize VAO to 0, signifying a column without valid GL resources
@@ -46,61 +98,118 @@ namespace cppcraft
 		// generate resources for column //
 		///////////////////////////////////
 
-		(void) y;
 		bool updateAttribs = false;
+		// sub-meshes up in the sky are often empty, and need no buffers
+		const bool hasVertices = !pc->datadump.empty() || this->vao != 0;
 
-		if (this->vao == 0)
+		if (this->vao == 0 && hasVertices)
 		{
 			// vertex array object
 			glGenVertexArrays(1, &this->vao);
-			// vertex and index buffer object
+			// vertex buffer object
 			glGenBuffers(1, &this->vbo);
 			updateAttribs = true;
 		}
 
+		// replacing the old mesh, if there was one
+		if (this->hasdata) columns.account(*this, -1);
+		this->lod = pc->lod;
 		for (int n = 0; n < RenderConst::MAX_UNIQUE_SHADERS; n++)
 		{
-			//this->indices[n]     = pc->indices[n];
-			//this->indexoffset[n] = indices;
 			this->vertices[n]     = pc->vertices[n];
 			this->bufferoffset[n] = pc->bufferoffset[n];
+			this->packed[n]       = pc->packed[n];
+			this->packedoffset[n] = pc->packedoffset[n];
+			this->indices[n]       = pc->indices[n];
+			this->packedindices[n] = pc->packedindices[n];
 		}
+		this->instances = pc->instancedump.size();
+		columns.account(*this, 1);
 
     // set each vertex to the columns unique ID
     for (auto& vtx : pc->datadump) {
       vtx.face = this->m_idx;
     }
 
-		// bind vao
-		glBindVertexArray(this->vao);
-
-		// bind vbo and upload vertex data
-		glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
-		//glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
-		glBufferData(GL_ARRAY_BUFFER,
-                 pc->datadump.size() * sizeof(vertex_t), /* DONT COUNT TOTAL! */
-                 pc->datadump.data(),
-                 GL_STATIC_DRAW);
+		if (hasVertices)
+		{
+			// bind vao
+			glBindVertexArray(this->vao);
+
+			// bind vbo and upload vertex data
+			glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+			//glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+			glBufferData(GL_ARRAY_BUFFER,
+                   pc->datadump.size() * sizeof(vertex_t), /* DONT COUNT TOTAL! */
+                   pc->datadump.data(),
+                   GL_STATIC_DRAW);
+
+			if (updateAttribs)
+			{
+			// the shared quad indices, as part of the vao state
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, columns.quadIndexBuffer());
+			// attribute pointers
+			glVertexAttribPointer(0, 4, GL_SHORT,		  GL_FALSE, sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, x)); // vertex
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(1, 4, GL_BYTE,		  GL_TRUE,  sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, nx)); // normal
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(2, 4, GL_SHORT,		  GL_FALSE, sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, u)); // texture
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, color)); // biome color
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, data1));
+			glEnableVertexAttribArray(4);
+			glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, lightcolor)); // torch color
+			glEnableVertexAttribArray(5);
+			}
+		}
 
-		// bind ibo and upload index data
-		//glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ibo);
-		//glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices * sizeof(indice_t), pc->indidump, GL_STATIC_DRAW);
+		// packed terrain vertices go in their own buffer, where the shaders
+		// get the column index from a constant attribute in the draw call
+		if (!pc->packeddump.empty() || this->pvao != 0)
+		{
+			if (this->pvao == 0)
+			{
+				glGenVertexArrays(1, &this->pvao);
+				glGenBuffers(1, &this->pvbo);
+				glBindVertexArray(this->pvao);
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, columns.quadIndexBuffer());
+				glBindBuffer(GL_ARRAY_BUFFER, this->pvbo);
+				glVertexAttribIPointer(6, 4, GL_UNSIGNED_INT, sizeof(terrain_vertex_t), (GLvoid*) 0);
+				glEnableVertexAttribArray(6);
+			}
+			glBindVertexArray(this->pvao);
+			glBindBuffer(GL_ARRAY_BUFFER, this->pvbo);
+			glBufferData(GL_ARRAY_BUFFER,
+			             pc->packeddump.size() * sizeof(terrain_vertex_t),
+			             pc->packeddump.data(),
+			             GL_STATIC_DRAW);
+		}
 
-		if (updateAttribs)
+		// model instances, with the model drawn from the shared quad indices
+		// for each of them, and the column index also from the draw call
+		if (!pc->instancedump.empty() || this->ivao != 0)
 		{
-		// attribute pointers
-		glVertexAttribPointer(0, 4, GL_SHORT,		  GL_FALSE, sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, x)); // vertex
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(1, 4, GL_BYTE,		  GL_TRUE,  sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, nx)); // normal
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(2, 4, GL_SHORT,		  GL_FALSE, sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, u)); // texture
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, color)); // biome color
-		glEnableVertexAttribArray(3);
-    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, data1));
-		glEnableVertexAttribArray(4);
-    glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(vertex_t), (GLvoid*) offsetof(vertex_t, data2));
-		glEnableVertexAttribArray(5);
+			if (this->ivao == 0)
+			{
+				glGenVertexArrays(1, &this->ivao);
+				glGenBuffers(1, &this->ivbo);
+				glBindVertexArray(this->ivao);
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, columns.quadIndexBuffer());
+				glBindBuffer(GL_ARRAY_BUFFER, this->ivbo);
+				glVertexAttribIPointer(7, 4, GL_UNSIGNED_INT, sizeof(model_instance_t), (GLvoid*) offsetof(model_instance_t, pos));
+				glEnableVertexAttribArray(7);
+				glVertexAttribDivisor(7, 1);
+				glVertexAttribIPointer(8, 4, GL_UNSIGNED_INT, sizeof(model_instance_t), (GLvoid*) offsetof(model_instance_t, color));
+				glEnableVertexAttribArray(8);
+				glVertexAttribDivisor(8, 1);
+			}
+			glBindVertexArray(this->ivao);
+			glBindBuffer(GL_ARRAY_BUFFER, this->ivbo);
+			glBufferData(GL_ARRAY_BUFFER,
+			             pc->instancedump.size() * sizeof(model_instance_t),
+			             pc->instancedump.data(),
+			             GL_STATIC_DRAW);
 		}
 
 #ifdef OPENGL_DO_CHECKS
@@ -111,9 +220,10 @@ namespace cppcraft
 		}
 #endif
 
+		const int y0 = y * Sector::MESH_LAYERS;
 		if (camera.getFrustum().column(x * BLOCKS_XZ + BLOCKS_XZ / 2,
 									   z * BLOCKS_XZ + BLOCKS_XZ / 2,
-									   0,  BLOCKS_Y,   BLOCKS_XZ / 2))
+									   y0, y0 + Sector::MESH_LAYERS, BLOCKS_XZ / 2))
 		{
 			// update render list
 			camera.needsupd = true;
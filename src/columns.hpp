@@ -36,15 +36,23 @@ namespace cppcraft
 
 		unsigned int  vao; // vertex array object
 		unsigned int  vbo; // vertex buffer
-		unsigned int  ibo; // index buffer
+		unsigned int  pvao = 0; // packed terrain vertices
+		unsigned int  pvbo = 0;
+		unsigned int  ivao = 0; // instanced models
+		unsigned int  ivbo = 0;
 
 		glm::vec3 pos; // rendering position
-
-		//int indices    [RenderConst::MAX_UNIQUE_SHADERS];
-		//int indexoffset[RenderConst::MAX_UNIQUE_SHADERS];
+		int lod = 0;   // level of detail of the uploaded mesh
 
 		uint32_t bufferoffset[RenderConst::MAX_UNIQUE_SHADERS];
 		uint32_t vertices    [RenderConst::MAX_UNIQUE_SHADERS];
+		uint32_t packedoffset[RenderConst::MAX_UNIQUE_SHADERS] {};
+		uint32_t packed      [RenderConst::MAX_UNIQUE_SHADERS] {};
+		// index counts, drawn with the shared quad index buffer
+		uint32_t indices      [RenderConst::MAX_UNIQUE_SHADERS] {};
+		uint32_t packedindices[RenderConst::MAX_UNIQUE_SHADERS] {};
+		// model instances, drawn on the 2-sided line
+		uint32_t instances = 0;
 
   private:
     int m_idx = 0;
@@ -53,8 +61,8 @@ namespace cppcraft
 
 	class Columns {
 	public:
-    // number of columns on Y-axis
-    static const int HEIGHT = 1;
+    // number of columns on Y-axis, one for each sub-mesh of a sector
+    static const int HEIGHT = Sector::MESHES;
 		void init();
 
 		inline int getHeight() const
@@ -62,21 +70,54 @@ namespace cppcraft
 			return HEIGHT;
 		}
 
-		// column index operator
-		Column& operator() (int x, int z, int wdx, int wdz)
+		// column index operator, where the columns are a ring buffer
+		// rotated by the world delta (wdx, wdz), just like the sectors
+		Column& operator() (int x, int y, int z, int wdx, int wdz)
 		{
-			x = (x + wdx) % sectors.getXZ();
-			z = (z + wdz) % sectors.getXZ();
+			const int XZ = sectors.getXZ();
+			x += wdx; if (x >= XZ) x -= XZ;
+			z += wdz; if (z >= XZ) z -= XZ;
 
-			return columns.at(x * sectors.getXZ() + z);
+			return columns.at((x * sectors.getXZ() + z) * HEIGHT + y);
+		}
+		// resets all the columns at (x, z)
+		void reset(int x, int z, int wdx, int wdz)
+		{
+			for (int y = 0; y < HEIGHT; y++) (*this)(x, y, z, wdx, wdz).reset();
+		}
+		//! \brief the world moved by (dx, dz) sectors, and the columns of the
+		//! sectors that came in on the edges are reset, which is all it takes
+		//! as the columns are a ring buffer, like the sectors (render thread)
+		void moved(int dx, int dz, int wdx, int wdz);
+		//! \brief resets every column, eg. after a teleport (render thread)
+		void resetAll()
+		{
+			for (auto& cv : columns) cv.reset();
 		}
 
     size_t size() const noexcept {
       return columns.size();
     }
 
+		// the static index buffer all columns draw their quads with,
+		// created on first use
+		unsigned int quadIndexBuffer();
+
+		// what the uploaded meshes add up to, for each level of detail
+		struct lod_stats_t
+		{
+			int64_t columns  = 0;
+			int64_t vertices = 0;
+			int64_t bytes    = 0;
+		};
+		const lod_stats_t& stats(int lod) const { return lod_stats.at(lod); }
+		// adds (@sign = 1) or removes (-1) the mesh of a column (render thread)
+		void account(const Column& cv, int sign);
+
 	private:
 		std::vector<Column> columns;
+		unsigned int quad_ibo = 0;
+		std::array<lod_stats_t, Sector::LOD_LEVELS> lod_stats;
   };
 	extern Columns columns;
 
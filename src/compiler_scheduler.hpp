@@ -1,6 +1,6 @@
 #pragma once
+#include "mpsc_queue.hpp"
 #include <memory>
-#include <vector>
 
 namespace cppcraft
 {
@@ -11,11 +11,11 @@ namespace cppcraft
 	public:
 		static void add(std::unique_ptr<Precomp> prc);
 
-		// returns all objects queued
-		static inline std::vector<std::unique_ptr<Precomp>> get();
-
-		// used by teleport
+		// used by teleport, drops the queued meshes before the next compile
 		static void reset();
+
+		// how long finished meshes waited for the render thread
+		static queue_stats_t stats();
 	};
 
 }
@@ -3,35 +3,41 @@
 #include <library/log.hpp>
 #include <library/timing/timer.hpp>
 #include "columns.hpp"
+#include "frame_budget.hpp"
 #include "compiler_scheduler.hpp"
 #include "precompiler.hpp"
+#include "precompq.hpp"
 #include "world.hpp"
-#include <mutex>
+#include <algorithm>
+#include <atomic>
 
 using namespace library;
 
 namespace cppcraft
 {
-  static std::mutex mtx_compiler;
-	static std::vector<std::unique_ptr<Precomp>> cjobs;
+	// finished meshes, from the workers to the render thread
+	static MPSCQueue<std::unique_ptr<Precomp>, 1024> cjobs;
   static std::deque<std::unique_ptr<Precomp>> compiler_queue;
+  // set by the world thread, and the render thread drops the meshes
+  static std::atomic<bool> reset_requested {false};
+  // the time the render thread spends on uploads each frame
+  FrameBudget uploadbudget({{"Upload", true}});
+  static const double UPLOAD_MIN_MS = 2.0;
+  static const double UPLOAD_MAX_MS = 8.0;
 
 	void CompilerScheduler::add(std::unique_ptr<Precomp> precomp)
 	{
-		std::lock_guard<std::mutex> lock(mtx_compiler);
-		cjobs.push_back(std::move(precomp));
+		cjobs.push(std::move(precomp));
 	}
 
-	inline std::vector<std::unique_ptr<Precomp>> CompilerScheduler::get()
+	void CompilerScheduler::reset()
 	{
-    std::lock_guard<std::mutex> lock(mtx_compiler);
-    return std::move(cjobs);
+    reset_requested = true;
 	}
 
-	void CompilerScheduler::reset()
+	queue_stats_t CompilerScheduler::stats()
 	{
-    std::lock_guard<std::mutex> lock(mtx_compiler);
-    cjobs.clear();
+		return cjobs.stats();
 	}
 
 	// initialize compiler data buffers
@@ -44,31 +50,48 @@ namespace cppcraft
 	// run compilers and try to clear queue, if theres enough time
 	void Compilers::run(const int wx, const int wz, const int wdx, const int wdz)
 	{
-    auto scheduled = CompilerScheduler::get();
+    // only the render thread can take from the queue
+    if (reset_requested.exchange(false))
+    {
+      cjobs.drain(
+      [] (std::unique_ptr<Precomp> precomp) {
+        precompq.recycle(std::move(precomp));
+      });
+      for (auto& precomp : compiler_queue) precompq.recycle(std::move(precomp));
+      compiler_queue.clear();
+    }
     // insert into main queue
-    for (auto& precomp : scheduled) compiler_queue.push_back(std::move(precomp));
+    cjobs.drain(
+    [] (std::unique_ptr<Precomp> precomp) {
+      compiler_queue.push_back(std::move(precomp));
+    });
 
-    library::Timer timer;
+    // 2 millis with a few uploads waiting, and more as they pile up
+    uploadbudget.backlog(0, compiler_queue.size());
+    uploadbudget.begin(std::min(std::max(uploadbudget.work(0), UPLOAD_MIN_MS), UPLOAD_MAX_MS));
     // execute main queue
-		while (!compiler_queue.empty())
-		{
+		uploadbudget.run(0,
+		[=] {
       auto precomp = std::move(compiler_queue.front());
       compiler_queue.pop_front();
 
-      // TODO: find out why wx, wz doesnt work replacing world.getW[X/Z]
+			// the column is where the sector is in the current snapshot
 			const int x = precomp->getWX() - wx;
 			const int z = precomp->getWZ() - wz;
 
-			if (x >= 0 && z >= 0 && x < sectors.getXZ() && z < sectors.getXZ())
+			// a mesh for what the sector was before a transition is dropped
+			if (precomp->stale() == false &&
+          x >= 0 && z >= 0 && x < sectors.getXZ() && z < sectors.getXZ())
 			{
-				Column& cv = columns(x, z, wdx, wdz);
-				cv.compile(x, 0, z, precomp.get());
+				Column& cv = columns(x, precomp->mesh, z, wdx, wdz);
+				cv.compile(x, precomp->mesh, z, precomp.get());
+				precompq.uploaded(*precomp);
 			}
-
-      const double time_spent = timer.getTime();
-      // we only accept spending 2 millis here
-      if (time_spent > 0.002) break;
-		}
+			// let the next mesh job have its buffers
+			precompq.recycle(std::move(precomp));
+      return !compiler_queue.empty();
+		});
+    uploadbudget.end();
 	} // Compilers::run()
 
 }
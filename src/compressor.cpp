@@ -23,7 +23,7 @@ namespace cppcraft
 	{
 		logger << Log::INFO << "* Initializing compressor" << Log::ENDL;
 		/*
-		const int compressed_max_size = Flatland::FLATLAND_SIZE + sizeof(Sector::sectorblock_t);
+		const int compressed_max_size = Flatland::FLATLAND_SIZE + sizeof(sectorblock_record_t);
 		
 		// initialize LZO
 		compressor.init(compressed_max_size);
@@ -85,7 +85,7 @@ namespace cppcraft
 		Sector& base = sectors(x, z);
 		base.blockpt = new Sector::sectorblock_t;
 		
-		memcpy(base.blockpt, cpos, sizeof(Sector::sectorblock_t));
+		memcpy(base.blockpt, cpos, sizeof(sectorblock_record_t));
 		
 		// mark sector as generated
 		base.gen_flags = Sector::GENERATED;
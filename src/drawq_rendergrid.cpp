@@ -130,27 +130,32 @@ namespace cppcraft
 
 		while (true)
 		{
-			auto& cv = columns(x, z, rg.wdx, rg.wdz);
-			if (cv.renderable)
+      const float fx = (x + 0.5f) - center_grid.x;
+      const float fz = (z + 0.5f) - center_grid.y;
+      const bool in_range = fx*fx + fz*fz < MAX_GRIDRAD;
+
+			// each sub-mesh of the column has its own bounding box
+			for (int y = 0; y < Columns::HEIGHT; y++)
 			{
-        const float fx = (x + 0.5f) - center_grid.x;
-    		const float fz = (z + 0.5f) - center_grid.y;
-				if (fx*fx + fz*fz < MAX_GRIDRAD)
+				auto& cv = columns(x, y, z, rg.wdx, rg.wdz);
+				if (cv.renderable)
 				{
 					static const float gs_half = BLOCKS_XZ / 2;
+					const int y0 = y * Sector::MESH_LAYERS;
 
-					if (rg.frustum->column(
+					if (in_range && rg.frustum->column(
 							(x * BLOCKS_XZ) + gs_half,
 							(z * BLOCKS_XZ) + gs_half,
-							0, BLOCKS_Y,  gs_half))
+							y0, y0 + Sector::MESH_LAYERS,  gs_half))
 					{
-						// this column is likely visible, and so we add all its meshes to queue
+						// this sub-mesh is likely visible, and so we add all its meshes to queue
 						cv.pos.x = x * BLOCKS_XZ;
 						cv.pos.z = z * BLOCKS_XZ;
 
 						for (size_t i = 0; i < lines.size(); i++)
 						{
-							if (cv.vertices[i] != 0)
+							const bool instanced = (i == RenderConst::TX_TRANS_2SIDED && cv.instances != 0);
+							if (cv.vertices[i] != 0 || cv.packed[i] != 0 || instanced)
 							{
 								// add to draw queue
                 lines[i].push_back(&cv);
@@ -158,19 +163,28 @@ namespace cppcraft
 
 						} // while i < shaders
 
-					} // frustum test
-
-				} // radial test
-			}
-			else if (cv.hasdata) // not renderable, but has VAO
-			{
-				// DONT DISABLE THIS, GPU WILL RUN OUT OF MEMORY IN A HEARTBEAT!!!!!!!!
-				cv.hasdata = false;
-				// free data from VAO/VBO (GPU is going to re-use this eventually)
-				glBindVertexArray(cv.vao);
-				glBindBuffer(GL_ARRAY_BUFFER, cv.vbo);
-				glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
-			} // render test
+					} // radial and frustum test
+				}
+				else if (cv.hasdata) // not renderable, but has VAO
+				{
+					// DONT DISABLE THIS, GPU WILL RUN OUT OF MEMORY IN A HEARTBEAT!!!!!!!!
+					cv.hasdata = false;
+					columns.account(cv, -1);
+					// free data from VAO/VBO (GPU is going to re-use this eventually)
+					if (cv.vao != 0)
+					{
+						glBindVertexArray(cv.vao);
+						glBindBuffer(GL_ARRAY_BUFFER, cv.vbo);
+						glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+					}
+					if (cv.pvao != 0)
+					{
+						glBindVertexArray(cv.pvao);
+						glBindBuffer(GL_ARRAY_BUFFER, cv.pvbo);
+						glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+					}
+				} // render test
+			} // sub-meshes
 
 			if (rg.majority < 2)
 			{
@@ -0,0 +1,101 @@
+#include "frame_budget.hpp"
+
+#include <algorithm>
+
+namespace cppcraft
+{
+	const int FrameBudget::STARVED;
+
+	FrameBudget::FrameBudget(std::initializer_list<stage_def_t> stages)
+	{
+		for (const auto& def : stages)
+		{
+			stage_t st;
+			st.c.name = def.name;
+			st.repeat = def.repeat;
+			m_stages.push_back(st);
+			m_published.push_back(st.c);
+		}
+	}
+
+	double FrameBudget::work(int stage) const noexcept
+	{
+		const stage_t& st = m_stages[stage];
+		if (st.backlog == 0) return 0.0;
+		return st.c.cost_ms * (st.repeat ? st.backlog : 1);
+	}
+
+	void FrameBudget::begin(double available_ms)
+	{
+		const auto now = clock::now();
+		available_ms = std::max(available_ms, 0.0);
+		m_carry_ms = 0.0;
+		m_deadline = now + std::chrono::duration_cast<clock::duration>(
+				std::chrono::duration<double, std::milli>(available_ms));
+
+		double total = 0.0;
+		int waiting = 0;
+		for (int i = 0; i < stages(); i++)
+		{
+			total += work(i);
+			if (m_stages[i].backlog) waiting++;
+		}
+		for (int i = 0; i < stages(); i++)
+		{
+			stage_t& st = m_stages[i];
+			st.c.backlog = st.backlog;
+			st.c.spent_ms = 0.0;
+			st.c.calls = 0;
+			if (st.backlog == 0) st.c.budget_ms = 0.0;
+			// a share of the round for the share of the work, and an even
+			// share until the stages have been measured
+			else if (total > 0.0) st.c.budget_ms = available_ms * work(i) / total;
+			else st.c.budget_ms = available_ms / waiting;
+		}
+	}
+
+	bool FrameBudget::start(stage_t& st, double& budget_ms)
+	{
+		if (st.backlog == 0) {
+			st.starved = 0;
+			return false;
+		}
+		const double left = std::chrono::duration<double, std::milli>(m_deadline - clock::now()).count();
+		// the unused time of the stages before goes to this one,
+		// and one call is always allowed if it fits in the round
+		st.c.budget_ms += m_carry_ms;
+		m_carry_ms = 0.0;
+		budget_ms = std::min(std::max(st.c.budget_ms, st.c.cost_ms), left);
+		if (st.c.cost_ms > budget_ms || left <= 0.0)
+		{
+			if (++st.starved < STARVED) {
+				// and if it can't run, its share goes on to the next one
+				m_carry_ms = st.c.budget_ms;
+				st.c.skipped++;
+				return false;
+			}
+			budget_ms = 0.0;
+		}
+		st.starved = 0;
+		return true;
+	}
+
+	void FrameBudget::measure(stage_t& st, double ms) noexcept
+	{
+		// the first call sets the cost, and then it moves slowly
+		st.c.cost_ms = (st.c.cost_ms == 0.0) ? ms : st.c.cost_ms * 0.9 + ms * 0.1;
+		st.c.calls++;
+	}
+
+	void FrameBudget::end()
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		for (int i = 0; i < stages(); i++) m_published[i] = m_stages[i].c;
+	}
+
+	FrameBudget::counters_t FrameBudget::counters(int stage) const
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		return m_published.at(stage);
+	}
+}
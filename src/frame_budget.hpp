@@ -0,0 +1,117 @@
+#ifndef FRAME_BUDGET_HPP
+#define FRAME_BUDGET_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+namespace cppcraft
+{
+	/**
+	 * Splits the time a thread can spend on background work in one round
+	 * between the stages that have work waiting. Each stage is measured
+	 * per call, and gets a share of the round that matches the time its
+	 * backlog would take. Time a stage doesn't use, or is skipped with, is
+	 * added to the budget of the next one that runs, and nothing runs past
+	 * the end of the round, except a stage that was skipped for STARVED
+	 * rounds in a row, which then gets one call.
+	**/
+	class FrameBudget
+	{
+	public:
+		typedef std::chrono::steady_clock clock;
+		static const int STARVED = 16;
+
+		struct stage_def_t
+		{
+			const char* name;
+			bool repeat; // called for as long as it has budget, or just once
+		};
+		FrameBudget(std::initializer_list<stage_def_t> stages);
+
+		//! \brief the number of items waiting for @stage
+		void backlog(int stage, std::size_t items) noexcept {
+			m_stages[stage].backlog = items;
+		}
+		//! \brief the time it would take to clear the backlog of @stage, in ms
+		double work(int stage) const noexcept;
+
+		//! \brief starts a round of @available_ms, and divides it between the stages
+		void begin(double available_ms);
+		//! \brief calls @func until it returns false, or the budget of @stage is spent
+		template <typename Func>
+		void run(int stage, Func func);
+		//! \brief publishes the counters of the round
+		void end();
+
+		//! \brief what was decided and spent in the last round, for each stage
+		struct counters_t
+		{
+			const char* name = "";
+			std::size_t backlog = 0;
+			double  cost_ms   = 0.0; // per call, on average
+			double  budget_ms = 0.0; // its share, and the time left over before it
+			double  spent_ms  = 0.0;
+			int     calls     = 0;
+			int64_t skipped   = 0; // rounds with a backlog but without time for it
+		};
+		counters_t counters(int stage) const;
+		int stages() const noexcept { return m_stages.size(); }
+
+	private:
+		struct stage_t
+		{
+			counters_t c;
+			bool repeat;
+			std::size_t backlog = 0;
+			int starved = 0;
+		};
+		static double ms_since(clock::time_point t) noexcept
+		{
+			return std::chrono::duration<double, std::milli>(clock::now() - t).count();
+		}
+		// the time left in the round for @stage, or false if it should be skipped
+		bool start(stage_t& st, double& budget_ms);
+		void measure(stage_t& st, double ms) noexcept;
+
+		std::vector<stage_t> m_stages;
+		clock::time_point m_deadline;
+		// budget the stages before didn't use, for the next stage
+		double m_carry_ms = 0.0;
+		// the counters of the last round, read by other threads
+		std::vector<counters_t> m_published;
+		mutable std::mutex m_mtx;
+	};
+
+	template <typename Func>
+	void FrameBudget::run(int stage, Func func)
+	{
+		stage_t& st = m_stages[stage];
+		double budget_ms;
+		if (start(st, budget_ms) == false) return;
+
+		const auto t0 = clock::now();
+		double spent = 0.0;
+		while (true)
+		{
+			const auto t = clock::now();
+			const bool more = func();
+			measure(st, ms_since(t));
+			spent = ms_since(t0);
+			// stop before a call that wouldn't fit
+			if (!more || !st.repeat || spent + st.c.cost_ms > budget_ms) break;
+		}
+		st.c.spent_ms = spent;
+		m_carry_ms = std::max(budget_ms - spent, 0.0);
+	}
+
+	// the background work of the world thread, and the uploads of the renderer
+	extern FrameBudget worldbudget;
+	extern FrameBudget uploadbudget;
+}
+
+#endif
@@ -38,6 +38,15 @@ namespace cppcraft
 		reflections    = config.get("render.reflections", true);
 		hq_reflections = config.get("render.hq_reflections", false);
 		reflectTerrain = config.get("render.reflect_terrain", false);
+		// merge cube faces into larger quads when meshing
+		greedy_meshing = config.get("render.greedy_meshing", true);
+		// 16-byte vertices for plain terrain faces
+		packed_vertices = config.get("render.packed_vertices", true);
+		// one instance record per cross, instead of its vertices
+		instanced_models = config.get("render.instanced_models", true);
+		// coarser meshes for distant sectors
+		lod_distance[0] = config.get("render.lod_2x_distance", 12);
+		lod_distance[1] = config.get("render.lod_4x_distance", 20);
 
 		playerhand    = config.get("playerhand", true);
 
@@ -32,6 +32,12 @@ namespace cppcraft
 		bool hq_reflections;
 		bool reflectTerrain;
 		
+		bool greedy_meshing;
+		bool packed_vertices;
+		bool instanced_models;
+		// distance in sectors to the 2x and 4x level of detail, 0 = never
+		int lod_distance[2];
+		
 		bool playerhand;
 		
 	};
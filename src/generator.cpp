@@ -4,8 +4,10 @@
 #include <library/log.hpp>
 #include "chunks.hpp"
 #include "minimap.hpp"
+#include "mpsc_queue.hpp"
 #include "player.hpp"
 #include "lighting.hpp"
+#include "pipeline.hpp"
 #include "sectors.hpp"
 #include "threadpool.hpp"
 #include "world.hpp"
@@ -29,10 +31,8 @@ namespace cppcraft
 	unsigned int g_compres[Chunks::CHUNK_SIZE][Chunks::CHUNK_SIZE];
 
 	std::deque<Sector*> Generator::queue;
-	// multi-threaded shits, mutex for the finished queue
-	// and the list of containers of finished jobs (gendata_t)
-	static std::mutex mtx_genq;
-	static std::vector<std::unique_ptr<terragen::gendata_t>> finished;
+	// the containers of finished jobs (gendata_t), from the workers
+	static MPSCQueue<Generator::result_t, 256> finished;
 
 	void Generator::init()
 	{
@@ -61,7 +61,7 @@ namespace cppcraft
 		std::sort(queue.begin(), queue.end(), GenerationOrder);
 
 		// queue from the top of the vector
-		while (!queue.empty() && AsyncPool::available())
+		while (!queue.empty() && AsyncPool::accepts(AsyncPool::GENERATION))
 		{
 			// because its a vector internally, we pop from the back
 			Sector* sect = queue.front();
@@ -73,39 +73,33 @@ namespace cppcraft
 			//	sect->getX(), sect->getZ());
 
       delegate<void()> func =
-      [wx = sect->getWX(), wz = sect->getWZ()]
+      [sect, generation = sect->generation(), wx = sect->getWX(), wz = sect->getWZ()]
       {
         // create immutable job data
   			auto gdata = std::make_unique<terragen::gendata_t> (wx, wz);
     		terragen::Generator::run(gdata.get());
 
     		// re-add the data back to the finished queue
-    		mtx_genq.lock();
-    		finished.push_back(std::move(gdata));
-    		mtx_genq.unlock();
+    		finished.push({sect, generation, std::move(gdata)});
     	};
 			// execute the generator job in background, delete job after its done
-			AsyncPool::sched(std::move(func));
+			AsyncPool::sched(AsyncPool::GENERATION, std::move(func));
 		}
 
-    // retrieve from queue
-    mtx_genq.lock();
-    auto finvec = std::move(finished);
-    mtx_genq.unlock();
     bool minimap_updated = false;
 
 		// finished generator jobs
-		for (auto& gdata : finvec)
+		finished.drain(
+		[&minimap_updated] (result_t result)
 		{
-			const int x = gdata->wx - world.getWX();
-			const int z = gdata->wz - world.getWZ();
-			// check that the generated data is still
-			// within our grid:
-			if (x >= 0 && x < sectors.getXZ() &&
-					z >= 0 && z < sectors.getXZ())
+			auto& gdata = result.gdata;
+			// check that the sector still wants the generated data, and
+			// hasn't been given to another place in the world since
+			if (result.sector->generation() == result.generation &&
+			    result.sector->generating())
 			{
 				// resultant sector
-				Sector& dest = sectors(x, z);
+				Sector& dest = *result.sector;
 				//printf("Sector was generated: (%d, %d)\n", dest.getX(), dest.getZ());
 
 				// swap out generated blocks
@@ -122,16 +116,7 @@ namespace cppcraft
 				if (dest.objects > 0)
 			     terragen::ObjectQueue::add(gdata->get_objects());
         else
-        {
-          // each time a sector gets generated, we can check if neighbors
-          // are ready to be added to precompq
-          sectors.onNxN(dest, 1, // 3x3
-              [] (Sector& sect) -> bool {
-                if (sect.isReadyForAtmos() && sect.isUpdatingMesh() == false)
-                    sect.updateAllMeshes();
-                return true;
-              });
-        }
+          Pipeline::terrainDone(dest);
 				// add it to the minimap right now
         minimap.addSector(dest);
         minimap_updated = true;
@@ -139,14 +124,12 @@ namespace cppcraft
 			else
 			{
 			#ifdef DEBUG
-				printf("INVALID sector was generated: (%d, %d)\n", x, z);
+				printf("STALE sector was generated: (%d, %d)\n",
+				       gdata->wx - world.getWX(), gdata->wz - world.getWZ());
 			#endif
 			}
-      if (minimap_updated) minimap.setUpdated();
-		}
-
-    // allow more jobs in the async pool
-    AsyncPool::release(finvec.size());
+		});
+    if (minimap_updated) minimap.setUpdated();
 
 #ifdef TIMING
     timer.measure();
@@ -155,6 +138,15 @@ namespace cppcraft
 #endif
 	}
 
+	std::size_t Generator::results()
+	{
+		return finished.size();
+	}
+	queue_stats_t Generator::handoff()
+	{
+		return finished.stats();
+	}
+
 	void Generator::loadSector(Sector& sector, std::ifstream& file, unsigned int PL)
 	{
 		// start by setting sector as not having been generated yet
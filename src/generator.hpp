@@ -9,13 +9,19 @@
 #ifndef GENERATOR_HPP
 #define GENERATOR_HPP
 
+#include "mpsc_queue.hpp"
 #include "sector.hpp"
 #include <deque>
+#include <memory>
 
 namespace library
 {
 	class Timer;
 }
+namespace terragen
+{
+	struct gendata_t;
+}
 
 namespace cppcraft
 {
@@ -37,10 +43,22 @@ namespace cppcraft
 		static std::size_t size() {
       return queue.size();
     }
+		// returns the number of finished jobs waiting for the world thread
+		static std::size_t results();
+		// how long finished jobs waited for the world thread
+		static queue_stats_t handoff();
 
 		// unused atm
 		bool generate(Sector& sector);
 
+		// a finished job, and the generation of the sector it was started for
+		struct result_t
+		{
+			Sector*  sector;
+			uint32_t generation;
+			std::unique_ptr<terragen::gendata_t> gdata;
+		};
+
 	private:
 		static void loadSector(Sector&, std::ifstream&, unsigned int);
     static std::deque<Sector*> queue;
@@ -168,13 +168,21 @@ namespace terragen
             for (int i = 1; i < 10; i++) {
               tile_ids[i] = tiledb.tiles(id + "_" + std::to_string(i));
             }
-            // create basic CT function
+            // the first tile on its own, otherwise a 3x3 sheet of border
+            // tiles (_1 to _9), from the edges that continue in the plane
             block.useConnectedTexture(
               BlockData::conntex_func_t::make_packed(
-              [tile_ids] (const connected_textures_t& ct, uint8_t face) -> short
+              [tile_ids] (const connected_textures_t& ct, uint8_t) -> short
               {
-                // TODO: write me
-                return 0;
+                const int self = ct.blocks[4].getID();
+                const bool lo_a = ct.blocks[3].getID() == self;
+                const bool hi_a = ct.blocks[5].getID() == self;
+                const bool lo_b = ct.blocks[1].getID() == self;
+                const bool hi_b = ct.blocks[7].getID() == self;
+                if (!(lo_a || hi_a || lo_b || hi_b)) return tile_ids[0];
+                const int col = (lo_a == hi_a) ? 1 : (hi_a ? 0 : 2);
+                const int row = (lo_b == hi_b) ? 1 : (hi_b ? 0 : 2);
+                return tile_ids[1 + row * 3 + col];
               }));
             is_connected = true;
           } else {
@@ -213,9 +221,17 @@ namespace terragen
         [sound] (const Block&) { return sound;
       });
     }
-    // light emission value
+    // light emission value, either a level or an [R, G, B] color
     if (v.HasMember("light")) {
-      block.setLightColor(v["light"].GetInt(), 0, 0);
+      auto& light = v["light"];
+      if (light.IsArray()) {
+        CC_ASSERT(light.Size() == 3, "JSON light color must be [R, G, B]");
+        block.setLightColor(light[0].GetInt(), light[1].GetInt(), light[2].GetInt());
+      }
+      else {
+        const int lvl = light.GetInt();
+        block.setLightColor(lvl, lvl, lvl);
+      }
     }
   }
 
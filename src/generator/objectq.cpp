@@ -1,5 +1,6 @@
 #include "objectq.hpp"
 
+#include "../pipeline.hpp"
 #include "../sectors.hpp"
 #include "../seamless.hpp"
 #include "../spiders.hpp"
@@ -40,9 +41,9 @@ namespace terragen
 		return queue;
 	}
 
-	void ObjectQueue::run_internal()
+	bool ObjectQueue::run_internal()
 	{
-		if (objects.empty()) return;
+		if (objects.empty()) return false;
 
 		int worldX = cppcraft::world.getWX() * BLOCKS_XZ;
 		int worldZ = cppcraft::world.getWZ() * BLOCKS_XZ;
@@ -91,19 +92,13 @@ namespace terragen
 					//assert (sector.objects);
 					if (sector.objects) {
 						sector.objects--;
-            if (sector.objects == 0) {
-              // now that we have completed all objects on this sector,
-              // its possible that all its neighbors can be added to precompq
-              sectors.onNxN(sector, 1, // 3x3
-                  [] (Sector& sect) -> bool {
-                    if (sect.isReadyForAtmos() && sect.isUpdatingMesh() == false)
-                        sect.updateAllMeshes();
-                    return true;
-                  });
-            } // no longer has objects
+            // now that we have completed all objects on this sector,
+            // its neighbors may be ready for the next stage
+            if (sector.objects == 0) cppcraft::Pipeline::terrainDone(sector);
           } // has objects
+          return true;
 				}
-        return;
+        return false;
 			}
 			else if (sectX < 0 || sectX >= sectors.getXZ()
 				    || sectZ < 0 || sectZ >= sectors.getXZ())
@@ -119,7 +114,7 @@ namespace terragen
         it = next;
       }
 		} // for(objects)
-
+		return false;
 	} // ObjectQueue::run()
 
   bool ObjectQueue::contains(Sector& sector)
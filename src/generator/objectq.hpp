@@ -16,9 +16,11 @@ namespace terragen
 
     static void init();
 
-		static void run()
+		// places the next object that can be placed,
+		// and returns false when none could be
+		static bool run()
 		{
-			get().run_internal();
+			return get().run_internal();
 		}
 		static ObjectQueue& get();
 
@@ -33,7 +35,7 @@ namespace terragen
     static bool contains(Sector&);
 
 	private:
-		void run_internal();
+		bool run_internal();
 
 		std::list<SchedObject> objects;
     std::list<SchedObject> retry_objects;
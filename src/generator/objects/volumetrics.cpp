@@ -48,7 +48,7 @@ namespace terragen
   	int dy;
   	for (dy = y; dy > 0; dy--)
   	{
-  		auto& blk = Spiders::getBlock(x, dy, z);
+  		const Block& blk = Spiders::getBlock(x, dy, z);
   		if (blk.getID() == mat || !blk.triviallyOverwriteable())
   		{
   			if (dy != y && blk.getID() != mat && travel > 0)
@@ -60,7 +60,9 @@ namespace terragen
   			}
   			return;
   		}
-  		blk.setID(mat);
+  		int bx = x, by = dy, bz = z;
+  		Sector* sector = Spiders::wrap(bx, by, bz);
+  		if (sector) (*sector)(bx, by, bz).setID(mat);
   	}
   	if (dy <= WATERLEVEL || travel == 0) return;
   	dy++; // go back up
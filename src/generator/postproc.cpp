@@ -73,8 +73,8 @@ namespace terragen
           if (gndLevel == 0) {
             if (block.isTransparent() == false) gndLevel = y+1;
           }
-          // mark this Y-value as having a light source
-          if (block.isLight()) gdata->setLight(y);
+          // remember this light source
+          if (block.isLight()) gdata->addLight(x, y, z);
   			}
   			// use skylevel to determine when we are below sky
   			block.setLight((skyLevel == 0) ? 15 : 0, 0);
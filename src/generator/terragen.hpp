@@ -45,7 +45,7 @@ namespace terragen
 		{
 			return (*sblock)(x, y, z);
 		}
-    inline void setLight(int y) { sblock->setLight(y); }
+    inline void addLight(int x, int y, int z) { sblock->addLight(x, y, z); }
 
     // schedule object for creation
     template <typename... Args>
@@ -1,10 +1,11 @@
 #include "lighting.hpp"
 
-#include "sectors.hpp"
+#include "neighborhood.hpp"
 #include "spiders.hpp"
 #include "world.hpp"
 #include <library/timing/timer.hpp>
 #include <deque>
+#include <memory>
 #include <queue>
 using namespace library;
 //#define TIMING
@@ -12,7 +13,8 @@ static const int MAX_REMOVALS = 800;
 
 namespace cppcraft
 {
-  extern void removeSkylight(int x, int y, int z, char dir, char lvl, std::queue<Lighting::emitter_t>&);
+  using view_t = Lighting::view_t;
+  extern void removeSkylight(const view_t&, int x, int y, int z, char dir, char lvl, std::queue<Lighting::emitter_t>&);
   struct DeferredRemovedLight {
     int  x;
     int  y1, y2;
@@ -46,10 +48,11 @@ namespace cppcraft
       if (x >= 0 && z >= 0 && x < sectors.getXZ() * BLOCKS_XZ
                            && z < sectors.getXZ() * BLOCKS_XZ)
       {
+        const view_t view(sectors(x / BLOCKS_XZ, z / BLOCKS_XZ));
         for (int y = loc.y1; y <= loc.y2; y++) {
           // start rays in all 6 directions
     		  for (char dir = 0; dir < 6; dir++)
-    			   removeSkylight(x, y, z, dir, loc.lvl, lrefill);
+    			   removeSkylight(view, view.fromGridX(x), y, view.fromGridZ(z), dir, loc.lvl, lrefill);
         }
       }
       lreque.pop_front();
@@ -60,6 +63,8 @@ namespace cppcraft
 #ifdef TIMING
     int sources = 0;
 #endif
+    // consecutive emitters mostly share a sector, so keep its view around
+    std::unique_ptr<view_t> view;
 		while (!lrefill.empty())
 		{
 			const emitter_t& e = lrefill.front();
@@ -69,6 +74,8 @@ namespace cppcraft
       Sector* sector = Spiders::wrap(bx, by, bz);
       if (sector != nullptr)
       {
+        if (view == nullptr || &view->center() != sector)
+            view.reset(new view_t(*sector));
         short lvl = (*sector)(bx, by, bz).getSkyLight();
         if (lvl == e.lvl) {
           char dir = e.dir;
@@ -81,7 +88,7 @@ namespace cppcraft
           case 5: dir = 4; break;
           default: assert(0 && "Invalid direction in skylight emitter");
           }
-          propagateChannel(sector, bx, by, bz, {0, dir, lvl});
+          propagateChannel(*view, bx, by, bz, {0, dir, lvl});
         }
       }
 			lrefill.pop();
@@ -1,9 +1,12 @@
 #include "lighting.hpp"
 
+#include <library/config.hpp>
 #include <library/math/toolbox.hpp>
-#include "sectors.hpp"
+#include "neighborhood.hpp"
 #include "spiders.hpp"
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <queue>
 
 using namespace library;
@@ -11,12 +14,16 @@ using namespace library;
 namespace cppcraft
 {
   using emitter_t = Lighting::emitter_t;
-	extern void removeChannel(int x, int y, int z, char dir, emitter_t& removed, std::queue<emitter_t>& q);
+  using view_t = Lighting::view_t;
+	extern void removeChannel(const view_t&, int x, int y, int z, char dir, emitter_t& removed, std::queue<emitter_t>& q);
+  bool Lighting::m_colored = false;
 
 	void Lighting::init()
 	{
 		extern Block air_block;
 		air_block.setLight(15, 0);
+		// RGB torchlight, propagated in a separate packed plane
+		m_colored = config.get("world.colored_light", false);
 	}
 
 	light_value_t Lighting::lightValue(const Block& block)
@@ -34,7 +41,7 @@ namespace cppcraft
 		return result;
 	}
 
-  inline void beginPropagateSkylight(Sector* s, int bx, int by, int bz, char mask)
+  inline void beginPropagateSkylight(const view_t& s, int bx, int by, int bz, char mask)
   {
   	if (mask & 1) Lighting::propagateChannel(s, bx, by, bz, {0, 0, 15}); // +x
   	if (mask & 2) Lighting::propagateChannel(s, bx, by, bz, {0, 1, 15}); // -x
@@ -44,6 +51,7 @@ namespace cppcraft
 
   void Lighting::atmosphericFlood(Sector& sector)
   {
+    const view_t view(sector);
     for (int x = 0; x < BLOCKS_XZ; x++)
     for (int z = 0; z < BLOCKS_XZ; z++)
     {
@@ -63,12 +71,13 @@ namespace cppcraft
     		if (z > 0)
     			if (sector.flat()(x, z-1).skyLevel <= y) mask &= ~8;
 
-		    beginPropagateSkylight(&sector, x, y, z, mask);
+		    beginPropagateSkylight(view, x, y, z, mask);
       } // y
 
-	    // try to enter water and other transparent blocks at the skylevel
-	    if (sector(x, sky, z).isTransparent())
-			   propagateChannel(&sector, x, sky, z, {0, 3, 14});
+	    // try to enter water and other transparent blocks below the skylevel,
+	    // with the same falloff as skylight entering them from the side
+	    if (sky > 0 && view.get(x, sky-1, z).isTransparent())
+			   propagateChannel(view, x, sky, z, {0, 3, 15});
 
     } // x, z
 
@@ -78,72 +87,116 @@ namespace cppcraft
 	  sector.atmospherics = true;
   } // atmospheric flood
 
+  void Lighting::torchSource(const view_t& view, int x, int y, int z)
+  {
+    Sector& sector = view.center();
+    Block& block = sector(x, y, z);
+    const int ch = 1;
+
+    // set to max blocklight value
+    uint8_t opacity = block.getLightLevel();
+    block.setChannel(ch, opacity);
+
+    // mask out impossible paths
+    int mask = 63;
+    if (x < BLOCKS_XZ-1)
+      if (!sector(x+1, y, z).isTransparent()) mask &= ~1;
+    if (x > 0)
+      if (!sector(x-1, y, z).isTransparent()) mask &= ~2;
+
+    // a light on the top or bottom layer has nothing above or below it
+    if (y < BLOCKS_Y-1)
+      if (!sector(x, y+1, z).isTransparent()) mask &= ~4;
+    if (y > 0)
+      if (!sector(x, y-1, z).isTransparent()) mask &= ~8;
+
+    if (z < BLOCKS_XZ-1)
+      if (!sector(x, y, z+1).isTransparent()) mask &= ~16;
+    if (z > 0)
+      if (!sector(x, y, z-1).isTransparent()) mask &= ~32;
+
+    if (m_colored)
+    {
+      const auto color = LightColor::fromOpacity(block.db().opacity);
+      view.torchColor(x, y, z) = color;
+      // mask bits are in the same order as the ray directions
+      for (int dir = 0; dir < 6; dir++)
+        if (mask & (1 << dir)) propagateColor(view, x, y, z, dir, color);
+      return;
+    }
+
+    // propagate block light in all directions
+    if (mask & 1)
+      propagateChannel(view, x, y, z, {ch, 0, opacity}); // +x
+    if (mask & 2)
+      propagateChannel(view, x, y, z, {ch, 1, opacity}); // -x
+    if (mask & 4)
+      propagateChannel(view, x, y, z, {ch, 2, opacity}); // +y
+    if (mask & 8)
+      propagateChannel(view, x, y, z, {ch, 3, opacity}); // -y
+    if (mask & 16)
+      propagateChannel(view, x, y, z, {ch, 4, opacity}); // +z
+    if (mask & 32)
+      propagateChannel(view, x, y, z, {ch, 5, opacity}); // -z
+  }
+
   void Lighting::torchlight(Sector& sector)
   {
+    auto& sb = sector.getBlocks();
+    const view_t view(sector);
     int light_count = 0;
-    for (int y = 1; y <= sector.getHighestLightPoint(); y++)
-    if (sector.hasLight(y))
+
+    if (LIKELY(!sb.emittersOverflowed()))
     {
-      for (int x = 0; x < BLOCKS_XZ; x++)
-      for (int z = 0; z < BLOCKS_XZ; z++)
+      // only visit the known light emitters
+      for (int i = 0; i < sb.emitterCount(); i++)
       {
-  		  Block& block = sector(x, y, z);
-
-        if (block.isLight())
-  		  {
+        const auto& e = sb.emitters()[i];
+        if (sector(e.x, e.y, e.z).isLight())
+        {
           light_count++;
-    			const int ch = 1;
-
-    			// set to max blocklight value
-          uint8_t opacity = block.getOpacity(0);
-          block.setChannel(ch, opacity);
-
-          // mask out impossible paths
-          int mask = 63;
-          if (x < BLOCKS_XZ-1)
-            if (!sector(x+1, y, z).isTransparent()) mask &= ~1;
-          if (x > 0)
-            if (!sector(x-1, y, z).isTransparent()) mask &= ~2;
-
-          if (!sector(x, y+1, z).isTransparent()) mask &= ~4;
-          if (!sector(x, y-1, z).isTransparent()) mask &= ~8;
-
-          if (z < BLOCKS_XZ-1)
-            if (!sector(x, y, z+1).isTransparent()) mask &= ~16;
-          if (z > 0)
-            if (!sector(x, y, z-1).isTransparent()) mask &= ~32;
-
-          // propagate block light in all directions
-          if (mask & 1)
-            propagateChannel(&sector, x, y, z, {ch, 0, opacity}); // +x
-          if (mask & 2)
-            propagateChannel(&sector, x, y, z, {ch, 1, opacity}); // -x
-          if (mask & 4)
-            propagateChannel(&sector, x, y, z, {ch, 2, opacity}); // +y
-          if (mask & 8)
-            propagateChannel(&sector, x, y, z, {ch, 3, opacity}); // -y
-          if (mask & 16)
-            propagateChannel(&sector, x, y, z, {ch, 4, opacity}); // +z
-          if (mask & 32)
-            propagateChannel(&sector, x, y, z, {ch, 5, opacity}); // -z
-
-    		} // isLight()
-      } // x, z
-    } // is light source(y)
+          torchSource(view, e.x, e.y, e.z);
+        }
+      }
+    }
+    else
+    {
+      // too many lights to keep track of, so scan the marked y-values
+      for (int y = 1; y <= sector.getHighestLightPoint(); y++)
+      if (sector.hasLight(y))
+      {
+        for (int x = 0; x < BLOCKS_XZ; x++)
+        for (int z = 0; z < BLOCKS_XZ; z++)
+        {
+          if (sector(x, y, z).isLight())
+          {
+            light_count++;
+            torchSource(view, x, y, z);
+          }
+        } // x, z
+      } // is light source(y)
+    }
     // update sectors light count (mostly for debugging)
-    sector.getBlocks().light_count = light_count;
-  } // atmospheric flood
+    sb.light_count = light_count;
+  } // torchlight
 
   #define DO_FLOOD_INTO(dir) {                 \
-      s2 = Spiders::wrap(*s, bx, by, bz);      \
-      if (s2 != nullptr) {                     \
-        auto lvl = (*s2)(bx, by, bz).getChannel(ch); \
-        if (lvl > 1) propagateChannel(s2, bx, by, bz, {ch, dir, lvl}); \
+      if (view.valid(bx, by, bz)) {            \
+        auto lvl = view.get(bx, by, bz).getChannel(ch); \
+        if (lvl > 1) {                         \
+          if (ch == 1 && m_colored)            \
+            propagateColor(view, bx, by, bz, dir, view.getTorchColor(bx, by, bz)); \
+          else                                 \
+            propagateChannel(view, bx, by, bz, {ch, dir, lvl}); \
+        }                                      \
       }}
 
   void Lighting::floodInto(Sector* s, int x, int y, int z, short ch)
   {
-    Sector* s2 = nullptr;
+    floodInto(view_t(*s), x, y, z, ch);
+  }
+  void Lighting::floodInto(const view_t& view, int x, int y, int z, short ch)
+  {
     int bx, by, bz;
 
 	  // for each neighbor to this block, flood in from
@@ -151,7 +204,7 @@ namespace cppcraft
     DO_FLOOD_INTO(0); // +x
 
     bx = x+1; by = y; bz = z;
-    DO_FLOOD_INTO(0); // -x
+    DO_FLOOD_INTO(1); // -x
 
     bx = x; by = y-1; bz = z;
     DO_FLOOD_INTO(2); // +y
@@ -170,19 +223,33 @@ namespace cppcraft
 	{
     Sector* s = Spiders::wrap(x, y, z);
     assert(s != nullptr);
+    floodOutof(view_t(*s), x, y, z, ch, lvl);
+  }
+	void Lighting::floodOutof(const view_t& view, int x, int y, int z, short ch, short lvl)
+	{
+    if (ch == 1 && m_colored)
+    {
+      // the source block already holds its color
+      const auto color = view.getTorchColor(x, y, z);
+      for (int dir = 0; dir < 6; dir++)
+        propagateColor(view, x, y, z, dir, color);
+      return;
+    }
 		// for each neighbor to this block, try to
 		// propagate light from ch outwards
-		propagateChannel(s, x, y, z, {ch, 0, lvl}); // +x
-		propagateChannel(s, x, y, z, {ch, 1, lvl}); // -x
-		propagateChannel(s, x, y, z, {ch, 2, lvl}); // +y
-		propagateChannel(s, x, y, z, {ch, 3, lvl}); // -y
-		propagateChannel(s, x, y, z, {ch, 4, lvl}); // +z
-		propagateChannel(s, x, y, z, {ch, 5, lvl}); // -z
+		propagateChannel(view, x, y, z, {ch, 0, lvl}); // +x
+		propagateChannel(view, x, y, z, {ch, 1, lvl}); // -x
+		propagateChannel(view, x, y, z, {ch, 2, lvl}); // +y
+		propagateChannel(view, x, y, z, {ch, 3, lvl}); // -y
+		propagateChannel(view, x, y, z, {ch, 4, lvl}); // +z
+		propagateChannel(view, x, y, z, {ch, 5, lvl}); // -z
 	}
 
 	void Lighting::skyrayDownwards(Sector& sector, int bx, int by, int bz)
 	{
-		for (int y = by; y >= 0; y--)
+    const view_t view(sector);
+		int y = by;
+		for (; y >= 0; y--)
 		{
 			if (sector(bx, y, bz).isAir())
 			{
@@ -196,20 +263,22 @@ namespace cppcraft
 				sector.flat()(bx, bz).skyLevel = new_skylevel;
         // send out rays on all sides along column
         for (y = by; y >= new_skylevel; y--) {
-  				propagateChannel(&sector, bx, y, bz, {0, 0, 15}); // +x
-  				propagateChannel(&sector, bx, y, bz, {0, 1, 15}); // -x
-  				propagateChannel(&sector, bx, y, bz, {0, 4, 15}); // +z
-  				propagateChannel(&sector, bx, y, bz, {0, 5, 15}); // -z
+  				propagateChannel(view, bx, y, bz, {0, 0, 15}); // +x
+  				propagateChannel(view, bx, y, bz, {0, 1, 15}); // -x
+  				propagateChannel(view, bx, y, bz, {0, 4, 15}); // +z
+  				propagateChannel(view, bx, y, bz, {0, 5, 15}); // -z
         }
         y = new_skylevel - 1;
 				// try to enter below, if its transparent
 				if (sector(bx, y, bz).isTransparent())
 				{
-					propagateChannel(&sector, bx, y, bz, {0, 3, 14});
+					propagateChannel(view, bx, new_skylevel, bz, {0, 3, 15});
 				}
 				break;
 			}
 		}
+		// the column that got skylight, down to where the ray stopped
+		sector.updateMeshes(std::max(y, 0), by);
 	}
 
 	void Lighting::removeLight(const Block& blk, int srcX, int srcY, int srcZ)
@@ -219,50 +288,63 @@ namespace cppcraft
 
 		assert(blk.isLight());
 		// radius of light
-		uint8_t rad = blk.getOpacity(0);
+		uint8_t rad = blk.getLightLevel();
 
 		// clear out ALL torchlight in this radius,
 		// and remember all the lights we pass
-		for (int x = srcX - rad; x <= srcX + rad; x++)
-		for (int z = srcZ - rad; z <= srcZ + rad; z++)
-		for (int y = srcY - rad; y <= srcY + rad; y++)
+		// the shell just outside the radius is untouched by this light,
+		// so anything lit there is sent back inwards afterwards
+		const int shell = rad + 1;
+		// the shell reaches at most one sector away from the source
+		view_t view(sectors(srcX / BLOCKS_XZ, srcZ / BLOCKS_XZ));
+		srcX = view.fromGridX(srcX);
+		srcZ = view.fromGridZ(srcZ);
+
+		for (int x = srcX - shell; x <= srcX + shell; x++)
+		for (int z = srcZ - shell; z <= srcZ + shell; z++)
+		for (int y = srcY - shell; y <= srcY + shell; y++)
 		{
 			// validate new position
-			if (x < 0 || y < 1 || z < 0 ||
-				  x >= sectors.getXZ() * BLOCKS_XZ ||
-				  z >= sectors.getXZ() * BLOCKS_XZ ||
-				  y >= BLOCKS_Y)  continue;
-
-			Sector& sector = sectors(x / BLOCKS_XZ, z / BLOCKS_XZ);
-			//assert(sector.generated());
-			int bx = x & (BLOCKS_XZ-1);
-			int bz = z & (BLOCKS_XZ-1);
-			Block& blk2 = sector(bx, y, bz);
-
-			if (blk2.isLight())
+			if (y < 1 || !view.valid(x, y, z)) continue;
+
+			const Block& blk2 = view.get(x, y, z);
+
+			if (abs(x - srcX) == shell || abs(y - srcY) == shell || abs(z - srcZ) == shell)
 			{
-				q.emplace(x, y, z, 1, 0, blk2.getOpacity(0));
+				if (blk2.getTorchLight() > 1)
+					q.emplace(x, y, z, 1, 0, blk2.getTorchLight());
 			}
-			else
+			else if (blk2.isLight())
 			{
-				blk2.setTorchLight(0);
-				if (!sector.isUpdatingMesh())
-					sector.updateAllMeshes();
+				q.emplace(x, y, z, 1, 0, blk2.getLightLevel());
+			}
+			else if (blk2.getTorchLight() != 0 || (m_colored && view.getTorchColor(x, y, z) != 0))
+			{
+				view(x, y, z).setTorchLight(0);
+				if (m_colored) view.torchColor(x, y, z) = 0;
+				view.changed(x, y, z);
 			}
 		}
 
-		// re-flood lights that we crossed by
+		// re-flood lights that we crossed by, and the shell
+		// light from the edge of the view can travel past it,
+		// so flood from a view centered on each emitters sector instead
+		view_t local = view;
 		while (!q.empty())
 		{
 			const emitter_t& e = q.front();
-      auto lvl = Spiders::getBlock(e.x, e.y, e.z).getSkyLight();
-      if (lvl > 1) floodOutof(e.x, e.y, e.z, e.ch, lvl);
+      auto lvl = view.get(e.x, e.y, e.z).getTorchLight();
+      if (lvl > 1)
+      {
+        const int gx = view.toGridX(e.x);
+        const int gz = view.toGridZ(e.z);
+        Sector& sector = sectors(gx / BLOCKS_XZ, gz / BLOCKS_XZ);
+        if (&local.center() != &sector) local = view_t(sector);
+        floodOutof(local, local.fromGridX(gx), e.y, local.fromGridZ(gz), e.ch, lvl);
+      }
       q.pop();
 		}
 
-		// go through all the edges and send rays back inwards (?)
-		//....
-
 	} // removeLight()
 
 } // namespace
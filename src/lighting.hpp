@@ -8,16 +8,20 @@
 
 #include "common.hpp"
 #include "block.hpp"
+#include "light_color.hpp"
 
 namespace cppcraft
 {
 	class Sector;
+	template <int R> class NeighborhoodView;
 
 	class Lighting
 	{
 	public:
 		static void init();
 		static light_value_t lightValue(const Block& block);
+		// the sectors around the one being lit, resolved once per operation
+		typedef NeighborhoodView<1> view_t;
 
 		struct emitter_t
 		{
@@ -46,6 +50,14 @@ namespace cppcraft
       short level;
     };
     static void propagateChannel(Sector*, int x, int y, int z, propagate_t);
+    static void propagateChannel(const view_t&, int x, int y, int z, propagate_t);
+    // propagates packed RGB torchlight, keeping the torch channel as its brightest lane
+    static void propagateColor(Sector*, int x, int y, int z, char dir, LightColor::color_t);
+    static void propagateColor(const view_t&, int x, int y, int z, char dir, LightColor::color_t);
+
+    // colored torchlight is enabled with world.colored_light
+    static bool coloredTorchlight() noexcept { return m_colored; }
+    static void setColoredTorchlight(bool enabled) noexcept { m_colored = enabled; }
 
     //
     static void deferredRemove(Sector& sector, int x, int y1, int y2, int z, short lv);
@@ -57,6 +69,12 @@ namespace cppcraft
   	   if (block.isAir()) return 1;
   	   return (block.isTransparent() ? 2 : 15);
     }
+  private:
+    // floods torchlight out from the light source at (x, y, z)
+    static void torchSource(const view_t&, int x, int y, int z);
+    static void floodInto(const view_t&, int x, int y, int z, short ch);
+    static void floodOutof(const view_t&, int x, int y, int z, short ch, short lvl);
+    static bool m_colored;
 	};
 }
 
@@ -1,7 +1,7 @@
 #include "lighting.hpp"
 
 #include "sectors.hpp"
-#include "spiders.hpp"
+#include "neighborhood.hpp"
 #include <queue>
 
 
@@ -9,51 +9,75 @@ namespace cppcraft
 {
   static_assert(sizeof(Lighting::propagate_t) <= 8, "Needs to fit in a register");
   using emitter_t = Lighting::emitter_t;
+  using view_t = Lighting::view_t;
+
+  // move one step in ray direction, returns false when leaving the view or the world
+  static inline bool rayStep(const view_t& view, int& x, int& y, int& z, char dir)
+  {
+		// only the axis we moved along can leave the view
+		switch (dir) {
+		case 0: return view.valid(++x, z);
+		case 1: return view.valid(--x, z);
+		case 2: return ++y < BLOCKS_Y;
+		case 3: return --y >= 0;
+		case 4: return view.valid(x, ++z);
+		case 5: return view.valid(x, --z);
+		}
+    return false;
+  }
+
+  static inline void remeshNeighbor(const view_t& view, const Sector& sector, int x, int y, int z, int dx, int dz)
+  {
+    if (view.contains(x + dx, z + dz))
+    {
+      if (view.valid(x + dx, 0, z + dz)) view.changed(x + dx, y, z + dz);
+    }
+    else if (unsigned(sector.getX() + dx) < unsigned(sectors.getXZ())
+          && unsigned(sector.getZ() + dz) < unsigned(sectors.getXZ()))
+    {
+      // the neighbor is just outside the view, which is rare enough to queue directly
+      sectors(sector.getX() + dx, sector.getZ() + dz).updateMesh(y);
+    }
+  }
+
+  // a light value changed at (x, y, z), so remesh the sector and any neighbor touching it
+  static inline void lightChanged(const view_t& view, int x, int y, int z)
+  {
+		// make sure the sub-meshes seeing the block are updated, since something was changed
+		view.changed(x, y, z);
+
+    const int bx = x & (BLOCKS_XZ-1);
+    const int bz = z & (BLOCKS_XZ-1);
+    // update all neighboring sectors :(
+    if (UNLIKELY(bx == 0 || bx == BLOCKS_XZ-1 || bz == 0 || bz == BLOCKS_XZ-1))
+    {
+      const Sector& sector = view.sector(x, z);
+      if (bx == 0)
+        remeshNeighbor(view, sector, x, y, z, -1, 0);
+      else if (bx == BLOCKS_XZ-1)
+        remeshNeighbor(view, sector, x, y, z,  1, 0);
+      if (bz == 0)
+        remeshNeighbor(view, sector, x, y, z, 0, -1);
+      else if (bz == BLOCKS_XZ-1)
+        remeshNeighbor(view, sector, x, y, z, 0,  1);
+    }
+  }
 
   void Lighting::propagateChannel(
       Sector* sector, int bx, int by, int bz, propagate_t p)
+  {
+    propagateChannel(view_t(*sector), bx, by, bz, p);
+  }
+
+  void Lighting::propagateChannel(
+      const view_t& view, int bx, int by, int bz, propagate_t p)
   {
     while (p.level > 0)
     {
   		// move in ray direction
-  		switch (p.dir) {
-  		case 0:
-          if (UNLIKELY(++bx >= BLOCKS_XZ)) {
-            if (sector->getX()+1 >= sectors.getXZ()) return;
-            sector = &sectors(sector->getX()+1, sector->getZ());
-            bx = 0;
-          }
-          break;
-  		case 1:
-          if (UNLIKELY(--bx < 0)) {
-            if (sector->getX()-1 < 0) return;
-            sector = &sectors(sector->getX()-1, sector->getZ());
-            bx = BLOCKS_XZ-1;
-          }
-          break;
-  		case 2:
-          if (UNLIKELY(++by >= BLOCKS_Y)) return;
-          break;
-  		case 3:
-          if (UNLIKELY(--by < 0)) return;
-          break;
-  		case 4:
-          if (UNLIKELY(++bz >= BLOCKS_XZ)) {
-            if (sector->getZ()+1 >= sectors.getXZ()) return;
-            sector = &sectors(sector->getX(), sector->getZ()+1);
-            bz = 0;
-          }
-          break;
-  		case 5:
-          if (UNLIKELY(--bz < 0)) {
-            if (sector->getZ()-1 < 0) return;
-            sector = &sectors(sector->getX(), sector->getZ()-1);
-            bz = BLOCKS_XZ-1;
-          }
-          break;
-  		}
+      if (!rayStep(view, bx, by, bz, p.dir)) return;
 
-  		Block& blk2 = (*sector)(bx, by, bz);
+  		const Block& blk2 = view.get(bx, by, bz);
   		// decrease light level based on what we hit
   		p.level -= lightPenetrate(blk2);
 
@@ -63,62 +87,87 @@ namespace cppcraft
   		if (blk2.getChannel(p.ch) >= p.level) break;
 
   		// set new light level
-      //printf("propagateChannel(%d, %d, %d): ch %d to %d (from %d) X=%d Z=%d bx=%d bz=%d\n",
-      //        x, y, z, ch, level, blk2.getChannel(ch), sector.getX(), sector.getZ(), bx, bz);
-  		blk2.setChannel(p.ch, p.level);
-
-  		// make sure the sectors mesh is updated, since something was changed
-  		if (!sector->isUpdatingMesh()) sector->updateAllMeshes();
-
-      // update all neighboring sectors :(
-      if (UNLIKELY(bx == 0 || bx == BLOCKS_XZ-1 || bz == 0 || bz == BLOCKS_XZ-1))
-      {
-        if (bx == 0)
-        {
-          if (sector->getX() > 0)
-              sectors(sector->getX()-1, sector->getZ()).updateAllMeshes();
-        }
-        else if (bx == BLOCKS_XZ-1)
-        {
-          if (sector->getX()+1 < sectors.getXZ())
-              sectors(sector->getX()+1, sector->getZ()).updateAllMeshes();
-        }
-        if (bz == 0)
-        {
-          if (sector->getZ() > 0)
-              sectors(sector->getX(), sector->getZ()-1).updateAllMeshes();
-        }
-        else if (bz == BLOCKS_XZ-1)
-        {
-          if (sector->getZ()+1 < sectors.getXZ())
-              sectors(sector->getX(), sector->getZ()+1).updateAllMeshes();
-        }
-      }
+  		view(bx, by, bz).setChannel(p.ch, p.level);
+      lightChanged(view, bx, by, bz);
 
   		switch (p.dir) {
   		case 0: // +x
   		case 1: // -x
-  			propagateChannel(sector, bx, by, bz, {p.ch, 2, p.level});
-  			propagateChannel(sector, bx, by, bz, {p.ch, 3, p.level});
-  			propagateChannel(sector, bx, by, bz, {p.ch, 4, p.level});
-  			propagateChannel(sector, bx, by, bz, {p.ch, 5, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 2, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 3, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 4, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 5, p.level});
   			break;
   		case 2: // +y
   		case 3: // -y
-  			propagateChannel(sector, bx, by, bz, {p.ch, 0, p.level});
-  			propagateChannel(sector, bx, by, bz, {p.ch, 1, p.level});
-  			propagateChannel(sector, bx, by, bz, {p.ch, 4, p.level});
-  			propagateChannel(sector, bx, by, bz, {p.ch, 5, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 0, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 1, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 4, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 5, p.level});
   			break;
   		case 4: // +z
   		case 5: // -z
-  			propagateChannel(sector, bx, by, bz, {p.ch, 0, p.level});
-  			propagateChannel(sector, bx, by, bz, {p.ch, 1, p.level});
-  			propagateChannel(sector, bx, by, bz, {p.ch, 2, p.level});
-  			propagateChannel(sector, bx, by, bz, {p.ch, 3, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 0, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 1, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 2, p.level});
+  			propagateChannel(view, bx, by, bz, {p.ch, 3, p.level});
   			break;
   		}
     } // for (level)
   }
 
+  void Lighting::propagateColor(
+      Sector* sector, int bx, int by, int bz, char dir, LightColor::color_t color)
+  {
+    propagateColor(view_t(*sector), bx, by, bz, dir, color);
+  }
+
+  void Lighting::propagateColor(
+      const view_t& view, int bx, int by, int bz, char dir, LightColor::color_t color)
+  {
+    while (color != 0)
+    {
+      if (!rayStep(view, bx, by, bz, dir)) return;
+
+  		const Block& blk2 = view.get(bx, by, bz);
+  		// all three lanes decay at once
+  		color = LightColor::decay(color, lightPenetrate(blk2));
+  		if (color == 0) break;
+
+      // stop unless at least one lane gets brighter
+      const auto stored = view.getTorchColor(bx, by, bz);
+  		if (!LightColor::brighter(color, stored)) break;
+
+  		const auto brightest = LightColor::max(stored, color);
+  		view.torchColor(bx, by, bz) = brightest;
+      // the torch channel holds the brightest lane, for everything else that reads it
+  		view(bx, by, bz).setChannel(1, LightColor::intensity(brightest));
+      lightChanged(view, bx, by, bz);
+
+  		switch (dir) {
+  		case 0: // +x
+  		case 1: // -x
+  			propagateColor(view, bx, by, bz, 2, color);
+  			propagateColor(view, bx, by, bz, 3, color);
+  			propagateColor(view, bx, by, bz, 4, color);
+  			propagateColor(view, bx, by, bz, 5, color);
+  			break;
+  		case 2: // +y
+  		case 3: // -y
+  			propagateColor(view, bx, by, bz, 0, color);
+  			propagateColor(view, bx, by, bz, 1, color);
+  			propagateColor(view, bx, by, bz, 4, color);
+  			propagateColor(view, bx, by, bz, 5, color);
+  			break;
+  		case 4: // +z
+  		case 5: // -z
+  			propagateColor(view, bx, by, bz, 0, color);
+  			propagateColor(view, bx, by, bz, 1, color);
+  			propagateColor(view, bx, by, bz, 2, color);
+  			propagateColor(view, bx, by, bz, 3, color);
+  			break;
+  		}
+    }
+  }
+
 }
@@ -1,14 +1,16 @@
 #include "lighting.hpp"
 
-#include "sectors.hpp"
+#include "neighborhood.hpp"
 #include "spiders.hpp"
 #include <queue>
 
 namespace cppcraft
 {
 	using emitter_t = Lighting::emitter_t;
+	using view_t = Lighting::view_t;
 
-  void removeSkylight(int x, int y, int z, char dir, char lvl, std::queue<emitter_t>& q)
+  // (x, y, z) is relative to the view, while queued emitters are in grid coordinates
+  void removeSkylight(const view_t& view, int x, int y, int z, char dir, char lvl, std::queue<emitter_t>& q)
   {
   	while (true)
   	{
@@ -23,14 +25,10 @@ namespace cppcraft
   		}
 
   		// validate new position
-  		if (x < 0 || y < 1 || z < 0 ||
-  			x >= sectors.getXZ() * BLOCKS_XZ ||
-  			z >= sectors.getXZ() * BLOCKS_XZ ||
-  			y >= BLOCKS_Y) break;
+  		if (y < 1 || !view.valid(x, y, z)) break;
 
-  		Sector& sector = sectors(x / BLOCKS_XZ, z / BLOCKS_XZ);
-  		assert(sector.generated());
-  		Block& blk2 = sector(x & (BLOCKS_XZ-1), y, z & (BLOCKS_XZ-1));
+  		assert(view.sector(x, z).generated());
+  		const Block& blk2 = view.get(x, y, z);
 
   		auto block_lvl = blk2.getSkyLight();
   		// exit when we encounter a node with zero or maximum light
@@ -42,44 +40,43 @@ namespace cppcraft
   		{
         assert (block_lvl > 1);
   			// when the level is same or above, we will use this to refill the removed volume
-        q.emplace(x, y, z, 0, dir, block_lvl);
+        q.emplace(view.toGridX(x), y, view.toGridZ(z), 0, dir, block_lvl);
   			break;
   		}
   		// our light was stronger, continue to remove
 
   		// set it to zero
       //printf("removeSkylight(%d, %d, %d): %d >= %d\n", x, y, z, lvl, block_lvl);
-  		blk2.setSkyLight(0);
+  		view(x, y, z).setSkyLight(0);
 
   		// simulate decrease of light level
-  		lvl -= Lighting::lightPenetrate(blk2);
+  		lvl -= Lighting::lightPenetrate(view.get(x, y, z));
   		if (lvl <= 0) break;
 
   		// make sure the sectors mesh is updated, since something was changed
-  		if (!sector.isUpdatingMesh())
-  			   sector.updateAllMeshes();
+  		view.changed(x, y, z);
 
   		switch (dir) {
   		case 0: // +x
   		case 1: // -x
-  			removeSkylight(x, y, z, 2, lvl, q);
-  			removeSkylight(x, y, z, 3, lvl, q);
-  			removeSkylight(x, y, z, 4, lvl, q);
-  			removeSkylight(x, y, z, 5, lvl, q);
+  			removeSkylight(view, x, y, z, 2, lvl, q);
+  			removeSkylight(view, x, y, z, 3, lvl, q);
+  			removeSkylight(view, x, y, z, 4, lvl, q);
+  			removeSkylight(view, x, y, z, 5, lvl, q);
   			break;
   		case 2: // +y
   		case 3: // -y
-  			removeSkylight(x, y, z, 0, lvl, q);
-  			removeSkylight(x, y, z, 1, lvl, q);
-  			removeSkylight(x, y, z, 4, lvl, q);
-  			removeSkylight(x, y, z, 5, lvl, q);
+  			removeSkylight(view, x, y, z, 0, lvl, q);
+  			removeSkylight(view, x, y, z, 1, lvl, q);
+  			removeSkylight(view, x, y, z, 4, lvl, q);
+  			removeSkylight(view, x, y, z, 5, lvl, q);
   			break;
   		case 4: // +z
   		case 5: // -z
-  			removeSkylight(x, y, z, 0, lvl, q);
-  			removeSkylight(x, y, z, 1, lvl, q);
-  			removeSkylight(x, y, z, 2, lvl, q);
-  			removeSkylight(x, y, z, 3, lvl, q);
+  			removeSkylight(view, x, y, z, 0, lvl, q);
+  			removeSkylight(view, x, y, z, 1, lvl, q);
+  			removeSkylight(view, x, y, z, 2, lvl, q);
+  			removeSkylight(view, x, y, z, 3, lvl, q);
   			break;
   		}
   	} // ray
@@ -88,7 +85,7 @@ namespace cppcraft
   // for each (x, y, z) that has a non-zero level lower than removed.lvl,
   // set them to zero. if the node is also a light source, queue it up,
   // so we can re-propagate its light after removing the @removed lightsource
-  void removeChannel(int x, int y, int z, char dir, emitter_t& removed, std::queue<emitter_t>& q)
+  void removeChannel(const view_t& view, int x, int y, int z, char dir, emitter_t& removed, std::queue<emitter_t>& q)
   {
   	// move in ray direction
   	switch (dir) {
@@ -101,26 +98,21 @@ namespace cppcraft
   	}
 
   	// validate new position
-  	if (x < 0 || y < 1 || z < 0 ||
-  		x >= sectors.getXZ() * BLOCKS_XZ ||
-  		z >= sectors.getXZ() * BLOCKS_XZ ||
-  		y >= BLOCKS_Y) return;
+  	if (y < 1 || !view.valid(x, y, z)) return;
 
-  	Sector& sector = sectors(x / BLOCKS_XZ, z / BLOCKS_XZ);
-  	//assert(sector.generated());
-  	Block& blk2 = sector(x & (BLOCKS_XZ-1), y, z & (BLOCKS_XZ-1));
+  	const Block& blk2 = view.get(x, y, z);
 
   	// exit when we encounter a node with non-zero light
   	// that is less than the level we are removing
   	char level = blk2.getChannel(removed.ch);
   	if (level != 0 && level < removed.lvl)
   	{
-  		q.emplace(x, y, z, removed.ch, dir, level);
+  		q.emplace(view.toGridX(x), y, view.toGridZ(z), removed.ch, dir, level);
   		return;
   	}
   	else if (level >= removed.lvl)
   	{
-  		q.emplace(x, y, z, removed.ch, dir, level);
+  		q.emplace(view.toGridX(x), y, view.toGridZ(z), removed.ch, dir, level);
   	}
   	else // level == 0
   	{
@@ -128,32 +120,32 @@ namespace cppcraft
   	}
 
   	// set it to zero
-  	blk2.setChannel(removed.ch, 0);
+  	view(x, y, z).setChannel(removed.ch, 0);
   	// make sure the sectors mesh is updated, since something was changed
-  	if (!sector.isUpdatingMesh()) sector.updateAllMeshes();
+  	view.changed(x, y, z);
 
   	switch (dir)
   	{
   	case 0: // +x
   	case 1: // -x
-  		removeChannel(x, y, z, 2, removed, q);
-  		removeChannel(x, y, z, 3, removed, q);
-  		removeChannel(x, y, z, 4, removed, q);
-  		removeChannel(x, y, z, 5, removed, q);
+  		removeChannel(view, x, y, z, 2, removed, q);
+  		removeChannel(view, x, y, z, 3, removed, q);
+  		removeChannel(view, x, y, z, 4, removed, q);
+  		removeChannel(view, x, y, z, 5, removed, q);
   		break;
   	case 2: // +y
   	case 3: // -y
-  		removeChannel(x, y, z, 0, removed, q);
-  		removeChannel(x, y, z, 1, removed, q);
-  		removeChannel(x, y, z, 4, removed, q);
-  		removeChannel(x, y, z, 5, removed, q);
+  		removeChannel(view, x, y, z, 0, removed, q);
+  		removeChannel(view, x, y, z, 1, removed, q);
+  		removeChannel(view, x, y, z, 4, removed, q);
+  		removeChannel(view, x, y, z, 5, removed, q);
   		break;
   	case 4: // +z
   	case 5: // -z
-  		removeChannel(x, y, z, 0, removed, q);
-  		removeChannel(x, y, z, 1, removed, q);
-  		removeChannel(x, y, z, 2, removed, q);
-  		removeChannel(x, y, z, 3, removed, q);
+  		removeChannel(view, x, y, z, 0, removed, q);
+  		removeChannel(view, x, y, z, 1, removed, q);
+  		removeChannel(view, x, y, z, 2, removed, q);
+  		removeChannel(view, x, y, z, 3, removed, q);
   		break;
   	}
   }
@@ -161,11 +153,14 @@ namespace cppcraft
   void Lighting::removeSkyLight(int x, int y1, int y2, int z, char lvl)
 	{
 		std::queue<emitter_t> q;
+		const view_t view(sectors(x / BLOCKS_XZ, z / BLOCKS_XZ));
+		x = view.fromGridX(x);
+		z = view.fromGridZ(z);
     // remove all light from whole column
     for (int y = y1; y <= y2; y++) {
       // start rays in all 6 directions
 		  for (int dir = 0; dir < 6; dir++)
-			  removeSkylight(x, y, z, dir, lvl, q);
+			  removeSkylight(view, x, y, z, dir, lvl, q);
     }
 		// re-flood edge values that were encountered
 		while (!q.empty())
@@ -8,54 +8,86 @@ namespace cppcraft
 	{
 		return (((bx + bz * 3) & 7) - 2) * 5;
 	}
+	// crosses keep their own AO, so only light and torch color is set
+	inline void set_cross_light(vertex_t& vtx, light_value_t light)
+	{
+		vtx.light = light & 0xFFFF;
+		vtx.lightcolor = light >> 32;
+	}
+	// instances have gray torchlight, the same as the torchlight level
+	inline bool gray_torchlight(light_value_t light)
+	{
+		const uint32_t torch = (light >> 8) & 0xFF;
+		return uint32_t(light >> 32) == (torch | torch << 8 | torch << 16);
+	}
 
-	void emitCross(PTD& ptd, int bx, int by, int bz, block_t)
+	// cross-mesh object 0 (cross), and the corner of the light and of the
+	// terrain color of each of its vertices
+	static const int CROSS_MODEL = 0;
+	static const int CROSS_CORNER[8] = {0, 1, 1, 0, 2, 3, 3, 2};
+	static const int CROSS_COLOR [8] = {0, 1, 1, 0, 2, 2, 3, 3};
+
+	// the vertices of a cross instance, the same as the shaders in
+	// unpack_instance.glsl make them, but not yet moved to the block
+	vertex_t* expandCross(const model_instance_t& inst, std::vector<vertex_t>& dest)
 	{
-    const Block& block = ptd.sector->get(bx, by, bz);
-    // copy cross-mesh object 0 (cross)
-		auto vtx = blockmodels.crosses.copyTo(0, ptd.current());
-
-		// huge boring list of cross-lighting
-		vtx[0].light = ptd.smoothLight(block, bx, by, bz,  bx-1, by, bz,  bx, by, bz-1,  bx-1, by, bz-1);
-		vtx[1].light = ptd.smoothLight(block, bx+1, by, bz+1,  bx, by, bz+1,  bx+1, by, bz,  bx, by, bz);
-		vtx[2].light = vtx[1].light;
-		vtx[3].light = vtx[0].light;
-		vtx[4].light = ptd.smoothLight(block, bx+1, by, bz,  bx, by, bz,  bx+1, by, bz-1,  bx, by, bz-1);
-		vtx[5].light = ptd.smoothLight(block, bx, by, bz+1,  bx-1, by, bz+1,  bx, by, bz,  bx-1, by, bz);
-		vtx[6].light = vtx[5].light;
-		vtx[7].light = vtx[4].light;
+		auto vtx = blockmodels.crosses.copyTo(inst.model(), dest);
+		// random height for non-special crosses
+		const short height = randomHeight(inst.x(), inst.z());
 
-		// terrain color
-		Block& blk = ptd.sector->get(bx, by, bz);
-		auto clid = blk.db().getColorIndex();
+		for (int i = 0; i < blockmodels.crosses.size(inst.model()); i++)
+		{
+			// the top vertices
+			if (i & 2) vtx[i].y += height;
 
-		vtx[0].color = ptd.getColor(bx  , bz  , clid); // (0, 0)
-		vtx[3].color = ptd.getColor(bx  , bz  , clid);
+			vtx[i].w  = inst.tile & 0xFFFF;
+			vtx[i].ao = 127;
+			vtx[i].light = inst.getLight(CROSS_CORNER[i]);
+			const uint32_t torch = vtx[i].light >> 8;
+			vtx[i].lightcolor = torch | torch << 8 | torch << 16;
+			vtx[i].color = inst.color[CROSS_COLOR[i]];
+		}
+		return &*vtx;
+	}
 
-		vtx[4].color = ptd.getColor(bx+1, bz  , clid); // (1, 0)
-		vtx[5].color = ptd.getColor(bx+1, bz  , clid);
+	void emitCross(PTD& ptd, int bx, int by, int bz, block_t)
+	{
+		const Block& block = ptd.sector->get(bx, by, bz);
 
-		vtx[6].color = ptd.getColor(bx  , bz+1, clid); // (0, 1)
-		vtx[7].color = ptd.getColor(bx  , bz+1, clid);
+		// huge boring list of cross-lighting, one for each corner
+		const light_value_t light[model_instance_t::CORNERS] = {
+			ptd.smoothLight(block, bx, by, bz,  bx-1, by, bz,  bx, by, bz-1,  bx-1, by, bz-1),
+			ptd.smoothLight(block, bx+1, by, bz+1,  bx, by, bz+1,  bx+1, by, bz,  bx, by, bz),
+			ptd.smoothLight(block, bx+1, by, bz,  bx, by, bz,  bx+1, by, bz-1,  bx, by, bz-1),
+			ptd.smoothLight(block, bx, by, bz+1,  bx-1, by, bz+1,  bx, by, bz,  bx-1, by, bz)
+		};
 
-		vtx[2].color = ptd.getColor(bx+1, bz+1, clid); // (1, 1)
-		vtx[1].color = ptd.getColor(bx+1, bz+1, clid);
+		model_instance_t inst(bx, by, bz, CROSS_MODEL, block.getTexture(0));
+		// terrain color
+		const auto clid = block.db().getColorIndex();
+		inst.color[0] = ptd.getColor(bx  , bz  , clid); // (0, 0)
+		inst.color[1] = ptd.getColor(bx+1, bz+1, clid); // (1, 1)
+		inst.color[2] = ptd.getColor(bx+1, bz  , clid); // (1, 0)
+		inst.color[3] = ptd.getColor(bx  , bz+1, clid); // (0, 1)
 
-		// set first vertex tile id
-		vtx->w = blk.getTexture(0);
-		vtx->ao = 127;
-		// set reset
-		for (int i = 1; i < blockmodels.crosses.size(0); i++)
+		bool gray = true;
+		for (int c = 0; c < model_instance_t::CORNERS; c++)
+		{
+			inst.setLight(c, light[c] & 0xFFFF);
+			gray = gray && gray_torchlight(light[c]);
+		}
+		// near colored lights, crosses stay as vertices
+		if (ptd.instancing && gray && ptd.shader == RenderConst::TX_TRANS_2SIDED)
 		{
-			vtx[i].w  = vtx->w;
-			vtx[i].ao = vtx->ao;
+			ptd.instances.push_back(inst);
+			return;
 		}
 
-		// random height for non-special crosses
-		short height = randomHeight(bx, bz);
-		vtx[2].y += height;
-		vtx[3].y += height;
-		vtx[6].y += height;
-		vtx[7].y += height;
+		// the vertices are moved to the block by process_block()
+		std::vector<vertex_t>& dest = ptd.current();
+		const size_t start = dest.size();
+		vertex_t* vtx = expandCross(inst, dest);
+		for (int i = 0; i < (int) (dest.size() - start); i++)
+			set_cross_light(vtx[i], light[CROSS_CORNER[i]]);
 	}
 }
@@ -356,4 +356,15 @@ namespace cppcraft
 
 	} // emitCube()
 
+	// re-emits a finished cube face quad as packed terrain vertices,
+	// returning false (and emitting nothing) if any corner doesn't fit
+	bool emitPackedQuad(std::vector<terrain_vertex_t>& dest, const vertex_t* quad)
+	{
+		terrain_vertex_t packed[4];
+		for (int i = 0; i < 4; i++)
+			if (!packed[i].pack(quad[i])) return false;
+		dest.insert(dest.end(), packed, packed + 4);
+		return true;
+	} // emitPackedQuad()
+
 }
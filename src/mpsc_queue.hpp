@@ -0,0 +1,155 @@
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace cppcraft
+{
+	//! \brief how long the items of a queue waited, from pushed to drained
+	struct queue_stats_t
+	{
+		int64_t count = 0;
+		double  avg_ms   = 0.0;
+		double  worst_ms = 0.0;
+		int64_t full = 0; // pushes that found the queue full
+	};
+
+	/**
+	 * Bounded lock-free queue for handing results from any number of
+	 * producers (eg. the workers) to one consumer (eg. the world thread).
+	 * Each slot has a sequence number that tells whose turn it is:
+	 * producers claim the tail with a CAS and publish the slot with a
+	 * release store, and the consumer takes it after an acquire load,
+	 * so the items themselves are never touched by two threads at once.
+	 * N must be a power of two.
+	**/
+	template <typename T, std::size_t N>
+	class MPSCQueue
+	{
+	public:
+		static_assert(N >= 2 && (N & (N-1)) == 0, "The queue size must be a power of two");
+		typedef std::chrono::steady_clock clock;
+
+		MPSCQueue() noexcept
+		{
+			for (std::size_t i = 0; i < N; i++)
+				cells[i].seq.store(i, std::memory_order_relaxed);
+		}
+
+		//! \brief Adds @value, unless the queue is full (any thread)
+		bool try_push(T&& value)
+		{
+			if (enqueue(value)) return true;
+			m_full.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		//! \brief Adds @value, and waits for the consumer while the queue is full
+		void push(T value)
+		{
+			if (try_push(std::move(value))) return;
+			while (!enqueue(value)) std::this_thread::yield();
+		}
+
+		//! \brief Calls @func(T) with each item in order, up to @max of them,
+		//! and returns how many there were (consumer thread only)
+		template <typename Func>
+		std::size_t drain(Func func, std::size_t max = N)
+		{
+			std::size_t pos = head.load(std::memory_order_relaxed);
+			std::size_t count = 0;
+			clock::time_point now;
+			for (; count < max; count++, pos++)
+			{
+				cell_t& cell = cells[pos & (N-1)];
+				if (cell.seq.load(std::memory_order_acquire) != pos + 1) break;
+				if (count == 0) now = clock::now();
+
+				T value = std::move(cell.value);
+				record(now - cell.pushed);
+				// the slot is free for the producers of the next lap
+				cell.seq.store(pos + N, std::memory_order_release);
+				head.store(pos + 1, std::memory_order_relaxed);
+				func(std::move(value));
+			}
+			return count;
+		}
+
+		//! \brief the number of items waiting, which can be stale by the time
+		//! it returns when the other threads are busy
+		std::size_t size() const noexcept
+		{
+			const std::size_t t = tail.load(std::memory_order_relaxed);
+			const std::size_t h = head.load(std::memory_order_relaxed);
+			return (t > h) ? t - h : 0;
+		}
+		static constexpr std::size_t capacity() noexcept { return N; }
+
+		queue_stats_t stats() const noexcept
+		{
+			queue_stats_t st;
+			st.count = m_count.load(std::memory_order_relaxed);
+			if (st.count > 0)
+				st.avg_ms = m_total_us.load(std::memory_order_relaxed) / 1000.0 / st.count;
+			st.worst_ms = m_worst_us.load(std::memory_order_relaxed) / 1000.0;
+			st.full = m_full.load(std::memory_order_relaxed);
+			return st;
+		}
+
+	private:
+		bool enqueue(T& value)
+		{
+			std::size_t pos = tail.load(std::memory_order_relaxed);
+			while (true)
+			{
+				cell_t& cell = cells[pos & (N-1)];
+				const std::size_t seq = cell.seq.load(std::memory_order_acquire);
+				const intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+				if (diff == 0)
+				{
+					// claim the slot, or try again with the new tail
+					if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						cell.value  = std::move(value);
+						cell.pushed = clock::now();
+						cell.seq.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				// the consumer hasn't taken the item from the last lap
+				else if (diff < 0) return false;
+				else pos = tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		// only the consumer writes the stats
+		void record(clock::duration waited) noexcept
+		{
+			const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(waited).count();
+			m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			m_total_us.store(m_total_us.load(std::memory_order_relaxed) + us, std::memory_order_relaxed);
+			if (us > m_worst_us.load(std::memory_order_relaxed))
+				m_worst_us.store(us, std::memory_order_relaxed);
+		}
+
+		struct cell_t
+		{
+			std::atomic<std::size_t> seq;
+			clock::time_point pushed;
+			T value;
+		};
+		cell_t cells[N];
+		// the producers and the consumer each keep to their own cache line
+		alignas(64) std::atomic<std::size_t> tail {0};
+		alignas(64) std::atomic<std::size_t> head {0};
+		std::atomic<int64_t> m_count {0};
+		std::atomic<int64_t> m_total_us {0};
+		std::atomic<int64_t> m_worst_us {0};
+		alignas(64) std::atomic<int64_t> m_full {0};
+	};
+}
+
+#endif
@@ -0,0 +1,144 @@
+#pragma once
+#include "sectors.hpp"
+#include <array>
+
+namespace cppcraft
+{
+  /**
+   * Pins the blocks of the (2R+1)x(2R+1) sectors around a center sector,
+   * so that rays can cross sector borders without resolving sectors again.
+   * Coordinates are relative to the center sector, so that (0, y, 0) is
+   * the first block of the center, and (-1, y, 0) is the last block
+   * of its -x neighbor. Sectors outside the world are left as null.
+   * Reads go through the const accessors of each sector, and a sector
+   * is only made writable the first time something is written into it,
+   * so a view must not outlive the operation it was made for, as it
+   * would write into any snapshot taken since.
+   * Changed blocks are collected as dirty sub-meshes per sector, and
+   * each sector is sent to the mesh queue once, when the view goes away.
+  **/
+  template <int R = 1>
+  class NeighborhoodView
+  {
+  public:
+    static const int SIDE   = 2 * R + 1;
+    static const int EXTENT = R * BLOCKS_XZ;
+
+    NeighborhoodView(Sector& center)
+    {
+      const int cx = center.getX();
+      const int cz = center.getZ();
+      m_bx = cx * BLOCKS_XZ;
+      m_bz = cz * BLOCKS_XZ;
+      for (int dx = -R; dx <= R; dx++)
+      for (int dz = -R; dz <= R; dz++)
+      {
+        const int i = (dx + R) * SIDE + (dz + R);
+        const int sx = cx + dx;
+        const int sz = cz + dz;
+        if (sx >= 0 && sz >= 0 && sx < sectors.getXZ() && sz < sectors.getXZ())
+          m_sectors[i] = &sectors(sx, sz);
+        else
+          m_sectors[i] = nullptr;
+        m_writable[i] = nullptr;
+        m_dirty[i] = 0;
+      }
+    }
+    // a copy pins the same sectors, but has no changes of its own yet
+    NeighborhoodView(const NeighborhoodView& other)
+      : m_sectors(other.m_sectors), m_bx(other.m_bx), m_bz(other.m_bz)
+    {
+      m_writable.fill(nullptr);
+      m_dirty.fill(0);
+    }
+    NeighborhoodView& operator= (const NeighborhoodView& other)
+    {
+      flush();
+      m_sectors = other.m_sectors;
+      m_writable.fill(nullptr);
+      m_bx = other.m_bx;
+      m_bz = other.m_bz;
+      return *this;
+    }
+    ~NeighborhoodView() { flush(); }
+
+    // true if the (x, z) column is covered by the view
+    static bool contains(int x, int z) noexcept {
+      return unsigned(x + EXTENT) < unsigned(SIDE * BLOCKS_XZ)
+          && unsigned(z + EXTENT) < unsigned(SIDE * BLOCKS_XZ);
+    }
+    // true if the (x, z) column is inside the view, and inside the world
+    bool valid(int x, int z) const noexcept {
+      return contains(x, z) && m_sectors[slot(x, z)] != nullptr;
+    }
+    // true if (x, y, z) is inside the view, and inside the world
+    bool valid(int x, int y, int z) const noexcept {
+      return unsigned(y) < unsigned(BLOCKS_Y) && valid(x, z);
+    }
+
+    // for reading, without making the sector writable
+    const Block& get(int x, int y, int z) const noexcept {
+      return blocks(x, z)(x & (BLOCKS_XZ-1), y, z & (BLOCKS_XZ-1));
+    }
+    LightColor::color_t getTorchColor(int x, int y, int z) const noexcept {
+      return blocks(x, z).torchColor(x & (BLOCKS_XZ-1), y, z & (BLOCKS_XZ-1));
+    }
+    const sectorblock_t& blocks(int x, int z) const noexcept {
+      return m_sectors[slot(x, z)]->blocks();
+    }
+    // for writing, which makes the sector writable
+    Block& operator() (int x, int y, int z) const {
+      return writable(x, z)(x & (BLOCKS_XZ-1), y, z & (BLOCKS_XZ-1));
+    }
+    LightColor::color_t& torchColor(int x, int y, int z) const {
+      return writable(x, z).torchColor(x & (BLOCKS_XZ-1), y, z & (BLOCKS_XZ-1));
+    }
+    Sector& sector(int x, int z) const noexcept {
+      return *m_sectors[slot(x, z)];
+    }
+    Sector& center() const noexcept {
+      return *m_sectors[slot(0, 0)];
+    }
+
+    // the light or the block at (x, y, z) changed, so the sub-meshes
+    // seeing it are rebuilt once the view is done
+    void changed(int x, int y, int z) const noexcept {
+      m_dirty[slot(x, z)] |= Sector::meshMask(y, y);
+    }
+    // send the sectors changed so far to the mesh queue
+    void flush() const
+    {
+      for (int i = 0; i < SIDE * SIDE; i++)
+      if (m_dirty[i]) {
+        m_sectors[i]->updateMeshes(m_dirty[i]);
+        m_dirty[i] = 0;
+      }
+    }
+
+    // conversion between view and sectors-grid block coordinates,
+    // which is what Spiders::wrap() and friends take
+    int toGridX(int x) const noexcept { return x + m_bx; }
+    int toGridZ(int z) const noexcept { return z + m_bz; }
+    int fromGridX(int x) const noexcept { return x - m_bx; }
+    int fromGridZ(int z) const noexcept { return z - m_bz; }
+
+  private:
+    static int slot(int x, int z) noexcept {
+      return unsigned(x + EXTENT) / BLOCKS_XZ * SIDE + unsigned(z + EXTENT) / BLOCKS_XZ;
+    }
+    sectorblock_t& writable(int x, int z) const
+    {
+      const int i = slot(x, z);
+      if (UNLIKELY(m_writable[i] == nullptr))
+          m_writable[i] = &m_sectors[i]->getBlocks();
+      return *m_writable[i];
+    }
+
+    std::array<Sector*, SIDE * SIDE> m_sectors;
+    // the blocks of the sectors written to so far
+    mutable std::array<sectorblock_t*, SIDE * SIDE> m_writable;
+    // the sub-meshes of each sector that need to be rebuilt
+    mutable std::array<uint16_t, SIDE * SIDE> m_dirty;
+    int m_bx, m_bz;
+  };
+}
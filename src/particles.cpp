@@ -26,9 +26,8 @@ namespace cppcraft
 			deadParticles.push_back(i);
 
     // initialize world position properly
-    physics.currentWX = world.getWX();
-    physics.currentWZ = world.getWZ();
-    snapshot = physics;
+    snapshot.currentWX = world.getWX();
+    snapshot.currentWZ = world.getWZ();
 	}
 
 	// execute one update-tick
@@ -96,14 +95,12 @@ namespace cppcraft
 		}
 		this->count = lastAlive + 1;
 
-		this->mtx.lock();
-		{
-      physics.updated = true;
-			physics.currentWX = world.getWX();
-			physics.currentWZ = world.getWZ();
-      physics.vertices = std::move(vertices);
-		}
-		this->mtx.unlock();
+		info_t info;
+		info.currentWX = world.getWX();
+		info.currentWZ = world.getWZ();
+		info.vertices  = std::move(vertices);
+		// when the renderer is behind, it gets the next one instead
+		physics.try_push(std::move(info));
 	}
 
 	int Particles::newParticleID()
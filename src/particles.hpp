@@ -2,12 +2,12 @@
 #define PARTICLES_HPP
 
 #include "delegate.hpp"
+#include "mpsc_queue.hpp"
 #include <glm/vec3.hpp>
 #include <cstdint>
 #include <array>
 #include <deque>
 #include <map>
-#include <mutex>
 #include <string>
 #include <vector>
 
@@ -98,7 +98,6 @@ namespace cppcraft
     // returns a new particle ID from queue, or -1
 		int newParticleID();
 
-    std::mutex mtx;
     // database
 		std::map<std::string, size_t> names;
 		std::vector<ParticleType>     types;
@@ -108,7 +107,8 @@ namespace cppcraft
 		  int currentWX, currentWZ;
       std::vector<particle_vertex_t> vertices;
     };
-    info_t physics;
+    // from the world thread to the renderer, which only needs the newest
+    MPSCQueue<info_t, 4> physics;
     info_t snapshot;
 
     // simulation
@@ -20,13 +20,10 @@ namespace cppcraft
 
 	void Particles::renderUpdate()
 	{
-		this->mtx.lock();
-    if (physics.updated == true)
-    {
-      snapshot = std::move(physics);
-      physics.updated = false;
-    }
-    this->mtx.unlock();
+		physics.drain(
+		[this] (info_t info) {
+			snapshot = std::move(info);
+		});
 
     // exit when nothing to do
 		if (snapshot.vertices.empty()) return;
@@ -0,0 +1,153 @@
+#include "pipeline.hpp"
+
+#include "lighting.hpp"
+#include "precompq.hpp"
+#include "sectors.hpp"
+
+namespace cppcraft
+{
+	std::deque<Sector*> Pipeline::lightq;
+
+	static const char* STAGE_NAMES[Pipeline::STAGES] = {
+		"generate", "objects", "light", "mesh", "done"
+	};
+
+	// the edge is not meshed, as it is about to be moved by seamless
+	static bool onEdge(const Sector& sector)
+	{
+		return sector.getX() < 2 || sector.getZ() < 2
+			|| sector.getX() >= sectors.getXZ()-2 || sector.getZ() >= sectors.getXZ()-2;
+	}
+
+	Pipeline::stage_t Pipeline::stage(const Sector& sector)
+	{
+		if (sector.generated() == false) return GENERATE;
+		if (sector.objects > 0) return OBJECTS;
+		if (sector.atmospherics == false) return LIGHT;
+		if (sector.isUpdatingMesh() || sector.dirtyMeshes) return MESH;
+		return DONE;
+	}
+	const char* Pipeline::name(stage_t stage)
+	{
+		return STAGE_NAMES[stage];
+	}
+
+	std::string Pipeline::waitingOn(const Sector& sector)
+	{
+		const Sector* blocker = nullptr;
+		switch (stage(sector))
+		{
+		case GENERATE:
+			return sector.generating() ? "generator" : "nothing";
+		case OBJECTS:
+			return std::to_string(sector.objects) + " objects";
+		case LIGHT:
+			// the first neighbor without its terrain
+			sectors.onNxN(sector, 1,
+			[&blocker] (Sector& sect) {
+				if (sect.generated() && sect.objects == 0) return true;
+				blocker = &sect;
+				return false;
+			});
+			if (blocker) return blocker->to_string() + " " + name(stage(*blocker));
+			return sector.has_flag(Sector::LIGHTING) ? "light queue" : "nothing";
+		case MESH:
+			if (onEdge(sector)) return "edge";
+			// the first neighbor without its light
+			sectors.onNxN(sector, 1,
+			[&blocker] (Sector& sect) {
+				if (sect.atmospherics) return true;
+				blocker = &sect;
+				return false;
+			});
+			if (blocker) return blocker->to_string() + " " + name(stage(*blocker));
+			return sector.isUpdatingMesh() ? "mesh queue" : "nothing";
+		default:
+			return "";
+		}
+	}
+
+	void Pipeline::terrainDone(Sector& sector)
+	{
+		// the neighbors can be lit once all the sectors around them are done
+		sectors.onNxN(sector, 1, // 3x3
+		[] (Sector& sect) -> bool {
+			if (sect.atmospherics == false && sect.has_flag(Sector::LIGHTING) == false
+			 && sect.isReadyForAtmos())
+			{
+				sect.add_genflag(Sector::LIGHTING);
+				lightq.push_back(&sect);
+			}
+			return true;
+		});
+	}
+
+	bool Pipeline::meshReady(const Sector& sector)
+	{
+		if (onEdge(sector)) return false;
+		return sectors.onNxN(sector, 1, // 3x3
+		[] (Sector& sect) {
+			return sect.generated() && sect.atmospherics;
+		});
+	}
+
+	void Pipeline::lightDone(Sector& sector)
+	{
+		// the light and the faces along the borders of the
+		// neighbors have changed, and they may be ready now
+		sectors.onNxN(sector, 1, // 3x3
+		[] (Sector& sect) -> bool {
+			if (sect.generated() == false) return true;
+			sect.dirtyMeshes = (1 << Sector::MESHES) - 1;
+			if (meshReady(sect)) precompq.add(sect);
+			return true;
+		});
+	}
+
+	bool Pipeline::run()
+	{
+		while (!lightq.empty())
+		{
+			Sector& sector = *lightq.front();
+			lightq.pop_front();
+			// regenerated since, and then it is queued again once its terrain is done
+			if (sector.has_flag(Sector::LIGHTING) == false) continue;
+			sector.rem_genflag(Sector::LIGHTING);
+			if (sector.atmospherics || sector.isReadyForAtmos() == false) continue;
+
+			Lighting::atmosphericFlood(sector);
+			lightDone(sector);
+			break;
+		}
+		return !lightq.empty();
+	}
+
+	void Pipeline::dump(FILE* out)
+	{
+		static const char STAGE_CHARS[STAGES+1] = "GOLM.";
+		int count[STAGES] = {0};
+		for (int z = 0; z < sectors.getXZ(); z++)
+		{
+			for (int x = 0; x < sectors.getXZ(); x++)
+			{
+				const stage_t st = stage(sectors(x, z));
+				count[st]++;
+				fputc(STAGE_CHARS[st], out);
+			}
+			fputc('\n', out);
+		}
+		for (int st = 0; st < STAGES; st++)
+			fprintf(out, "%s: %d  ", name((stage_t) st), count[st]);
+		fprintf(out, "(light queue: %zu, mesh queue: %zu)\n", lightq.size(), precompq.size());
+
+		for (int x = 0; x < sectors.getXZ(); x++)
+		for (int z = 0; z < sectors.getXZ(); z++)
+		{
+			const Sector& sector = sectors(x, z);
+			const stage_t st = stage(sector);
+			if (st == DONE) continue;
+			fprintf(out, "%s %s: waiting on %s\n", sector.to_string().c_str(),
+					name(st), waitingOn(sector).c_str());
+		}
+	}
+}
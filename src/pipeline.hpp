@@ -0,0 +1,59 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <cstdio>
+#include <deque>
+#include <string>
+
+namespace cppcraft
+{
+	class Sector;
+
+	/**
+	 * The stages a sector goes through before it can be seen:
+	 * generate -> objects -> light -> mesh (-> upload)
+	 * A sector is lit once the sectors around it have their terrain and
+	 * objects, and meshed once the sectors around it are lit. Each stage
+	 * that completes tells the sectors around it, which move on as soon as
+	 * everything they depend on is done, so nothing is polled each frame.
+	**/
+	class Pipeline
+	{
+	public:
+		enum stage_t {
+			GENERATE = 0,
+			OBJECTS,
+			LIGHT,
+			MESH,
+			DONE,
+			STAGES
+		};
+		static stage_t stage(const Sector& sector);
+		static const char* name(stage_t stage);
+		//! \brief what @sector is waiting on in its current stage, in words
+		static std::string waitingOn(const Sector& sector);
+
+		//! \brief @sector is generated, and has all of its objects
+		static void terrainDone(Sector& sector);
+		//! \brief true when all the sectors around @sector are lit
+		static bool meshReady(const Sector& sector);
+
+		//! \brief floods the next sector that is ready for its light, and
+		//! returns true if there are more (world thread)
+		static bool run();
+
+		static std::size_t size() noexcept {
+			return lightq.size();
+		}
+		//! \brief prints the stage of every sector to @out (world thread)
+		static void dump(FILE* out);
+
+	private:
+		// @sector was flooded with light
+		static void lightDone(Sector& sector);
+
+		static std::deque<Sector*> lightq;
+	};
+}
+
+#endif
@@ -22,7 +22,7 @@ namespace cppcraft
 	{
 		plogic.movestate = PMS_Normal;
 		plogic.sector = nullptr;
-		plogic.block = &air_block;
+		plogic.block = air_block;
 
 		// initialize block selection system
 		plogic.selection = playerselect_t();
@@ -32,6 +32,7 @@ namespace cppcraft
 
 		player.snapStage = 0;
 		player.snap_pos = vec3(0.0f);
+		player.snap_eye = air_block;
 	}
 
 	bool PlayerClass::busyControls() const
@@ -94,6 +95,9 @@ namespace cppcraft
 			const double net_change = 0.01;
 			player.changedPosition = distance(snap_pos, pos) > net_change;
 			snap_pos = pos;
+			// the renderer doesn't read the blocks, as they are only
+			// safe to read on this thread, so it gets the block from here
+			snap_eye = Spiders::testArea(pos.x, pos.y - camera.getZNear(), pos.z);
 
 			// true if the player is moving (on purpose)
 			// used to modulate player camera giving the effect of movement
@@ -20,6 +20,8 @@ namespace cppcraft
 		glm::vec3 pos;
 		glm::vec3 snap_pos;
 		int    snapStage;
+		// the block at the eye of the player, at snap_pos, for the renderer
+		Block  snap_eye;
 
 		// rotation in radians
 		glm::vec2 rot;
@@ -4,6 +4,7 @@
 #include "particles.hpp"
 #include "player.hpp"
 #include "player_logic.hpp"
+#include "precompq.hpp"
 #include "sectors.hpp"
 #include "soundman.hpp"
 #include "spiders.hpp"
@@ -34,7 +35,7 @@ namespace cppcraft
 		int ddy = int(selection.pos.y);
 		int ddz = int(selection.pos.z);
 
-		Block& selected = Spiders::getBlock(ddx, ddy, ddz);
+		const Block& selected = Spiders::getBlock(ddx, ddy, ddz);
 		(void) held_item;
 		(void) selected;
 		/*
@@ -140,7 +141,7 @@ namespace cppcraft
 		int ddx = selection.pos.x;
 		int ddy = selection.pos.y;
 		int ddz = selection.pos.z;
-		Block& selectedBlock = Spiders::getBlock(ddx, ddy, ddz);
+		const Block& selectedBlock = Spiders::getBlock(ddx, ddy, ddz);
 
 		// now that we know we are allowed to place our block with the specificed facing,
 		// we have to check if we are similarly allowed to place something onto the same facing
@@ -161,13 +162,15 @@ namespace cppcraft
 			}
 
 			// check if we are allowed to place a block in the selected position
-			Block& newBlock = Spiders::getBlock(ddx, ddy, ddz);
+			const Block& newBlock = Spiders::getBlock(ddx, ddy, ddz);
 			if (newBlock.triviallyOverwriteable())
 			{
 				// add block to world
 				bool placed = Spiders::setBlock(ddx, ddy, ddz, buildingBlock);
 				if (placed)
 				{
+					// the player is waiting to see it
+					if (Sector* sector = sectors.sectorAt(ddx, ddz)) precompq.add(*sector, true);
 					//item.setCount(item.getCount() - 1); //decrease count (directly)!
 					//inventory.setChanged(true);
 					printf("Placing item %d with block ID %d\n",
@@ -269,6 +272,8 @@ namespace cppcraft
 
 				if (!removed.isAir())
 				{
+					// the player is waiting to see it
+					if (Sector* sector = sectors.sectorAt(ddx, ddz)) precompq.add(*sector, true);
           const glm::vec3 center(ddx + 0.5f, ddy + 0.5f, ddz + 0.5f);
 					// play material 'removed' sound
 					if (removed.hasSound())
@@ -320,7 +325,7 @@ namespace cppcraft
 			{
 				// increase ray by one big step
 				ray += rayBigStep;
-				Block& found = Spiders::getBlock(ray.x, ray.y, ray.z);
+				const Block& found = Spiders::getBlock(ray.x, ray.y, ray.z);
 
 				if (!found.isAir() && !found.isFluid())
 				{
@@ -334,7 +339,7 @@ namespace cppcraft
 						{
 							// glean backward slowly until we exit completely, but we still retain our closest valid position
 							ray -= rayStep;
-							Block& bfound = Spiders::getBlock(ray.x, ray.y, ray.z);
+							const Block& bfound = Spiders::getBlock(ray.x, ray.y, ray.z);
 
 							fracs = glm::fract(ray);
 
@@ -5,6 +5,7 @@
 #include "chat.hpp"
 #include "game.hpp"
 #include "gameconf.hpp"
+#include "pipeline.hpp"
 #include "player_inputs.hpp"
 #include "player_logic.hpp"
 #include "sun.hpp"
@@ -223,6 +224,12 @@ namespace cppcraft
 
 				thesun.setRadianAngle(-1);
 			}
+			if (game.input().key(GLFW_KEY_F5) == Input::KEY_PRESSED)
+			{
+				game.input().key_hold(GLFW_KEY_F5);
+				// print the pipeline stage of every sector
+				Pipeline::dump(stdout);
+			}
 
 			if (game.input().key(keyconf.k_flying) == Input::KEY_PRESSED)
 			{
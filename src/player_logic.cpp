@@ -71,12 +71,12 @@ namespace cppcraft
 			if (timesteps == 0)
 			{
 				// play material sound, except for fluids, crosses and air
-				if (block->hasSound())
+				if (block.hasSound())
 				{
 					int value = rand() & 1;
 					stepsound = 0 + value;
 
-					soundman.playMaterial(block->getSound(), stepsound,
+					soundman.playMaterial(block.getSound(), stepsound,
               {player.pos.x, player.pos.y - 1.51f, player.pos.z});
 				}
 
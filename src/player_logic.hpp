@@ -91,9 +91,9 @@ namespace cppcraft
 		static const short JETPACK_SOUNDWAIT = 24;
 	#endif
 
-		// player standing on this:
-		Block* block;
-		Block* lastblock;
+		// player standing on this (a copy, as the renderer looks at it too):
+		Block block;
+		const Block* lastblock;
 
 		// returns true if the player has selected a block in the world
 		bool hasSelection() const
@@ -278,7 +278,7 @@ namespace cppcraft
 			// normal momentum, except on ground with varying friction
 
 			// player block can affect momentum
-			if (plogic.block->isLowFriction())
+			if (plogic.block.isLowFriction())
 			{
 				// weakest momentum change
 				player.accel.x = mix(player.accel.x, dx, 0.01);
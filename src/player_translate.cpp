@@ -403,7 +403,7 @@ namespace cppcraft
 			Ladderized = false;
 			Submerged  = PS_None;
 			FullySubmerged = PS_None;
-			block = &air_block; // in-air
+			block = air_block; // in-air
 
 			freefall = false; // never falling
 			player.accel.y = 0.0; // and, zero gravity!
@@ -513,7 +513,7 @@ namespace cppcraft
 		if (tries) return;
 
 		// determine player block (block that the player is standing on
-		block = &Spiders::getBlock(player.pos.x, player.pos.y - PLAYER_GROUND_LEVEL, player.pos.z, PlayerPhysics::PLAYER_SIZE);
+		block = Spiders::getBlock(player.pos.x, player.pos.y - PLAYER_GROUND_LEVEL, player.pos.z, PlayerPhysics::PLAYER_SIZE);
 
 		/// manage falling player //
 		// determing if player is falling, then set appropriate flags (DONT USE getBlock!)
@@ -539,10 +539,10 @@ namespace cppcraft
 			player.accel.y = 0;
 
 			// play a landing sound
-			if (block->hasSound())
+			if (block.hasSound())
 			{
 				int sound = rnd(4);
-				soundman.playMaterial(block->getSound(), sound,
+				soundman.playMaterial(block.getSound(), sound,
             {player.pos.x, player.pos.y - PLAYER_GROUND_LEVEL, player.pos.z});
 			}
 
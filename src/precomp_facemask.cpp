@@ -0,0 +1,123 @@
+#include "precomp_facemask.hpp"
+
+#include "blocks_bordered.hpp"
+#include <algorithm>
+
+namespace cppcraft
+{
+	// all bits from BLOCKS_Y and up in the last word
+	static const uint64_t ABOVE_WORLD = (BLOCKS_Y % 64) ? ~0ull << (BLOCKS_Y % 64) : 0;
+
+	void facemask_t::refreshTable()
+	{
+		auto& db = ::db::BlockDB::cget();
+		const size_t count = std::min(db.count(), m_table.size());
+		for (size_t id = 0; id < count; id++)
+		{
+			const auto& bd = db[id];
+			uint8_t info = bd.transparentSides & ::db::BlockData::SIDE_ALL;
+			if (id != _AIR)
+				info |= (bd.visibilityComp == nullptr) ? ID_CUBE : ID_SPECIAL;
+			m_table[id] = info;
+		}
+		// unknown IDs are never meshed
+		for (size_t id = count; id < m_table.size(); id++)
+			m_table[id] = ::db::BlockData::SIDE_ALL;
+	}
+
+	void facemask_t::build(const bordered_sector_t& bsb, int bottom, int height)
+	{
+		// the block data can change between sectors, eg. when mods load
+		refreshTable();
+		const int first = std::max(bottom - 1, 0);
+		const int words = (height + 63) / 64;
+
+		for (int x = -1; x <= BLOCKS_XZ; x++)
+		for (int z = -1; z <= BLOCKS_XZ; z++)
+		{
+			const int idx = index(x, z);
+			const Block* column = &bsb(x, 0, z);
+
+			for (int w = 0; w < first / 64; w++)
+			{
+				for (int p = 0; p < 6; p++) m_transparent[p][idx][w] = 0;
+				m_special[idx][w] = 0;
+				m_cubes[idx][w]   = 0;
+			}
+			for (int w = first / 64; w < words; w++)
+			{
+				uint64_t planes[8] = {0};
+				const int end = std::min(64, height - w * 64);
+				// whatever is above the scanned height is air
+				uint64_t air = (end < 64) ? ~0ull << end : 0;
+				for (int bit = (w == first / 64) ? first % 64 : 0; bit < end; bit++)
+				{
+					const uint64_t info = m_table[column[w * 64 + bit].getID()];
+					// the two common cases: air, and opaque cubes
+					if (info == ::db::BlockData::SIDE_ALL)
+						air |= 1ull << bit;
+					else if (info == ID_CUBE)
+						planes[7] |= 1ull << bit;
+					else
+						for (int p = 0; p < 8; p++)
+							planes[p] |= ((info >> p) & 1) << bit;
+				}
+				for (int p = 0; p < 6; p++)
+					m_transparent[p][idx][w] = planes[p] | air;
+				m_special[idx][w] = planes[6];
+				m_cubes[idx][w]   = planes[7];
+			}
+			for (int w = words; w < WORDS; w++)
+			{
+				for (int p = 0; p < 6; p++) m_transparent[p][idx][w] = ~0ull;
+				m_special[idx][w] = 0;
+				m_cubes[idx][w]   = 0;
+			}
+			// the very top of the world is always open
+			for (int p = 0; p < 6; p++) m_transparent[p][idx][WORDS-1] |= ABOVE_WORLD;
+		}
+	}
+
+	// the plane bits of the blocks right below each block
+	inline uint64_t facemask_t::below(int p, int idx, int w) const noexcept
+	{
+		const auto& col = m_transparent[p][idx];
+		// the bottom of the world never gets faces
+		return (col[w] << 1) | ((w > 0) ? col[w-1] >> 63 : 0);
+	}
+	// the plane bits of the blocks right above each block
+	inline uint64_t facemask_t::above(int p, int idx, int w) const noexcept
+	{
+		const auto& col = m_transparent[p][idx];
+		return (col[w] >> 1) | ((w+1 < WORDS) ? col[w+1] << 63 : 1ull << 63);
+	}
+
+	void facemask_t::visible(int bx, int bz, column_t& result) const
+	{
+		const int idx = index(bx, bz);
+		for (int w = 0; w < WORDS; w++)
+		{
+			result[w] = m_cubes[idx][w] & (
+					m_transparent[5][idx - (BLOCKS_XZ+2)][w] | // -x
+					m_transparent[4][idx + (BLOCKS_XZ+2)][w] | // +x
+					below(3, idx, w) | above(2, idx, w)      | // -y, +y
+					m_transparent[1][idx - 1][w] |             // -z
+					m_transparent[0][idx + 1][w]);             // +z
+		}
+	}
+
+	uint16_t facemask_t::visibleFaces(int bx, int by, int bz) const
+	{
+		const int idx = index(bx, bz);
+		const int w = by / 64;
+		const int bit = by % 64;
+		uint16_t sides = 0;
+		sides |= ((m_transparent[5][idx - (BLOCKS_XZ+2)][w] >> bit) & 1) << 5;
+		sides |= ((m_transparent[4][idx + (BLOCKS_XZ+2)][w] >> bit) & 1) << 4;
+		sides |= ((below(3, idx, w) >> bit) & 1) << 3;
+		sides |= ((above(2, idx, w) >> bit) & 1) << 2;
+		sides |= ((m_transparent[1][idx - 1][w] >> bit) & 1) << 1;
+		sides |= ((m_transparent[0][idx + 1][w] >> bit) & 1);
+		return sides;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "common.hpp"
+#include <array>
+#include <cstdint>
+
+namespace cppcraft
+{
+	struct bordered_sector_t;
+
+	/**
+	 * Occupancy and transparency bitmasks for a bordered sector, with one
+	 * bit per block, and 64 blocks of a column per word. The visible faces
+	 * of a whole column are then a few shifts and ANDs, instead of six
+	 * neighbor loads and block database lookups per block.
+	 * Blocks with their own visibility function are kept apart as special,
+	 * and must still be tested one by one.
+	**/
+	class facemask_t
+	{
+	public:
+		static const int WORDS = (BLOCKS_Y + 63) / 64;
+		typedef std::array<uint64_t, WORDS> column_t;
+
+		// scans the blocks from @bottom-1 up to @height (and the borders)
+		// into bitmasks. everything above is treated as air, and everything
+		// below as opaque blocks without faces of their own
+		void build(const bordered_sector_t& bsb, int bottom, int height);
+
+		// cube blocks in (bx, bz) that have at least one visible face
+		void visible(int bx, int bz, column_t& result) const;
+		// blocks in (bx, bz) that need Block::visibleFaces()
+		const column_t& special(int bx, int bz) const noexcept {
+			return m_special[index(bx, bz)];
+		}
+		// the visible faces of the cube block at (bx, by, bz)
+		// @mask: 1 = +z, 2 = -z, 4 = +y, 8 = -y, 16 = +x, 32 = -x
+		uint16_t visibleFaces(int bx, int by, int bz) const;
+
+	private:
+		static int index(int bx, int bz) noexcept {
+			return (bx+1) * (BLOCKS_XZ+2) + (bz+1);
+		}
+		// plane @p has the bit set when the block is transparent towards 1 << p
+		uint64_t below(int p, int idx, int w) const noexcept;
+		uint64_t above(int p, int idx, int w) const noexcept;
+		void refreshTable();
+
+		typedef std::array<column_t, (BLOCKS_XZ+2) * (BLOCKS_XZ+2)> plane_t;
+		std::array<plane_t, 6> m_transparent;
+		plane_t m_cubes;   // not air, and using the default visibility test
+		plane_t m_special; // has a custom visibility test
+		// per block ID: transparent sides, and the two flags below
+		static const uint8_t ID_SPECIAL = 64;
+		static const uint8_t ID_CUBE    = 128;
+		std::array<uint8_t, 4096> m_table;
+	};
+}
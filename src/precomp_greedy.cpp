@@ -0,0 +1,357 @@
+#include "precomp_thread.hpp"
+
+#include "renderconst.hpp"
+#include <algorithm>
+
+namespace cppcraft
+{
+	static const int S = RenderConst::VERTEX_SCALE;
+	static_assert((S & (S-1)) == 0, "Texture wrapping needs a power of two vertex scale");
+
+	// everything except position and texture coordinates, and the face
+	// field, which is only model data until the column overwrites it
+	static inline bool same_attributes(const vertex_t& a, const vertex_t& b)
+	{
+		return a.nx == b.nx && a.ny == b.ny && a.nz == b.nz
+			&& a.ao == b.ao && a.w == b.w && a.light == b.light && a.color == b.color
+			&& a.data1 == b.data1 && a.lightcolor == b.lightcolor;
+	}
+	static inline int coord(const vertex_t& v, int axis)
+	{
+		return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+	}
+	static inline void set_coord(vertex_t& v, int axis, int value)
+	{
+		if (axis == 0) v.x = value; else if (axis == 1) v.y = value; else v.z = value;
+	}
+	// the two in-plane axes (a, b) for each normal axis
+	static const int AXIS_A[3] = {2, 0, 0};
+	static const int AXIS_B[3] = {1, 2, 1};
+	// number of cells along each axis
+	static const int CELLS[3] = {BLOCKS_XZ, BLOCKS_Y, BLOCKS_XZ};
+
+	// a quad whose corners are the same along a can be stretched along a,
+	// and likewise for b, since the attributes are interpolated over the quad
+	static const uint8_t FLAT_A = 1;
+	static const uint8_t FLAT_B = 2;
+
+	/**
+	 * Checks if the quad at @q is a whole, unit cube face that is flat along
+	 * at least one axis, and returns its sort key, or 0 if it is not.
+	 * The key orders quads by face direction, slice, row and column.
+	 * @corners gets which corner of the cell each vertex is at, and
+	 * @flat the axes along which the quad has the same attributes.
+	**/
+	static uint32_t classify(const vertex_t* q, uint8_t& corners, uint8_t& flat)
+	{
+		int n;
+		if (q->nx != 0 && q->ny == 0 && q->nz == 0) n = 0;
+		else if (q->ny != 0 && q->nx == 0 && q->nz == 0) n = 1;
+		else if (q->nz != 0 && q->nx == 0 && q->ny == 0) n = 2;
+		else return 0;
+
+		const int plane = coord(q[0], n);
+		if (plane & (S-1)) return 0;
+		const int A = AXIS_A[n], B = AXIS_B[n];
+		int mina = coord(q[0], A), minb = coord(q[0], B);
+		for (int i = 1; i < 4; i++) {
+			mina = std::min(mina, coord(q[i], A));
+			minb = std::min(minb, coord(q[i], B));
+		}
+		if ((mina | minb) & (S-1)) return 0;
+		if (mina < 0 || minb < 0) return 0;
+		if (mina / S >= CELLS[A] || minb / S >= CELLS[B]) return 0;
+
+		corners = 0;
+		int seen = 0;
+		int idx[4];
+		for (int i = 0; i < 4; i++)
+		{
+			if (coord(q[i], n) != plane) return 0;
+			const int da = coord(q[i], A) - mina;
+			const int db = coord(q[i], B) - minb;
+			if ((da != 0 && da != S) || (db != 0 && db != S)) return 0;
+			const int corner = (da ? 1 : 0) | (db ? 2 : 0);
+			seen |= 1 << corner;
+			corners |= corner << (i * 2);
+			idx[corner] = i;
+		}
+		if (seen != 15) return 0;
+
+		flat = 0;
+		if (same_attributes(q[idx[0]], q[idx[1]]) && same_attributes(q[idx[2]], q[idx[3]])) flat |= FLAT_A;
+		if (same_attributes(q[idx[0]], q[idx[2]]) && same_attributes(q[idx[1]], q[idx[3]])) flat |= FLAT_B;
+		if (flat == 0) return 0;
+
+		// direction 0-5, with the sign of the normal
+		const int sign = (n == 0) ? q->nx : ((n == 1) ? q->ny : q->nz);
+		const int dir = n * 2 + (sign < 0);
+		// 1 + so that a valid key is never 0
+		return 1 + ((dir * (BLOCKS_Y+1) + plane / S) * BLOCKS_Y + minb / S) * BLOCKS_Y + mina / S;
+	}
+
+	struct greedy_quad_t
+	{
+		// texture coordinate steps per cell along a and b
+		int du_a, du_b, dv_a, dv_b;
+	};
+	static greedy_quad_t texture_steps(const vertex_t* q, uint8_t corners)
+	{
+		int idx[4];
+		for (int i = 0; i < 4; i++) idx[(corners >> (i * 2)) & 3] = i;
+		const vertex_t& v00 = q[idx[0]];
+		const vertex_t& v10 = q[idx[1]];
+		const vertex_t& v01 = q[idx[2]];
+		return { v10.u - v00.u, v01.u - v00.u, v10.v - v00.v, v01.v - v00.v };
+	}
+
+	// can quad @r, which is (da, db) cells away, become part of @origin
+	static inline bool mergeable(const vertex_t* origin, uint8_t ocorners, const greedy_quad_t& steps,
+	                             const vertex_t* r, uint8_t rcorners, int da, int db)
+	{
+		// same winding, and the same attributes on every corner
+		if (rcorners != ocorners) return false;
+		// texture coordinates must continue the origin quad, modulo one tile
+		for (int i = 0; i < 4; i++)
+		{
+			if (!same_attributes(origin[i], r[i])) return false;
+			const int u = origin[i].u + da * steps.du_a + db * steps.du_b;
+			const int v = origin[i].v + da * steps.dv_a + db * steps.dv_b;
+			if (((r[i].u - u) | (r[i].v - v)) & (S-1)) return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Sorts the whole cube faces of @vertices that are flat along at least
+	 * the axes in @need by their classify() key into @keys, with the quad
+	 * index in the low bits. Returns false when there is nothing to merge.
+	**/
+	static bool sort_faces(const std::vector<vertex_t>& vertices, uint8_t need,
+	                       std::vector<uint64_t>& keys, std::vector<uint8_t>& corners,
+	                       std::vector<uint8_t>& flat)
+	{
+		const int quads = vertices.size() / 4;
+		keys.clear();
+		corners.resize(quads);
+		flat.resize(quads);
+		for (int q = 0; q < quads; q++)
+		{
+			const uint32_t key = classify(&vertices[q * 4], corners[q], flat[q]);
+			if (key && (flat[q] & need) == need) keys.push_back(uint64_t(key) << 32 | q);
+		}
+		if (keys.size() < 2) return false;
+		std::sort(keys.begin(), keys.end());
+		return true;
+	}
+	// the slice of a sort key, and the cell in the 2D mask of the slice
+	static const uint32_t SLICE = BLOCKS_Y * BLOCKS_Y;
+	static inline uint32_t slice_of(uint64_t key)
+	{
+		return uint32_t((key >> 32) - 1) / SLICE;
+	}
+	static inline int cell_of(uint64_t key)
+	{
+		const uint32_t k = uint32_t(key >> 32) - 1;
+		return (k / BLOCKS_Y % BLOCKS_Y) * BLOCKS_XZ + k % BLOCKS_Y;
+	}
+
+	// stretches the unit quad @origin over @width x @height cells
+	static void stretch(vertex_t* origin, uint8_t oc, const greedy_quad_t& steps,
+	                    int A, int B, int width, int height)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			const int corner = (oc >> (i * 2)) & 3;
+			if (corner & 1) {
+				set_coord(origin[i], A, coord(origin[i], A) + (width-1) * S);
+				origin[i].u += (width-1) * steps.du_a;
+				origin[i].v += (width-1) * steps.dv_a;
+			}
+			if (corner & 2) {
+				set_coord(origin[i], B, coord(origin[i], B) + (height-1) * S);
+				origin[i].u += (height-1) * steps.du_b;
+				origin[i].v += (height-1) * steps.dv_b;
+			}
+		}
+	}
+
+	// compacts the remaining quads, keeping their order
+	static void compact(std::vector<vertex_t>& vertices, const std::vector<bool>& removed)
+	{
+		const int quads = vertices.size() / 4;
+		size_t out = 0;
+		for (int q = 0; q < quads; q++)
+		{
+			if (removed[q]) continue;
+			if (out != size_t(q) * 4)
+				std::copy(&vertices[q * 4], &vertices[q * 4] + 4, &vertices[out]);
+			out += 4;
+		}
+		vertices.resize(out);
+	}
+
+	void PrecompThread::greedyMesh(std::vector<vertex_t>& vertices)
+	{
+		const int quads = vertices.size() / 4;
+		if (quads < 2) return;
+
+		// sort the whole cube faces by slice, then position in the slice
+		auto& keys = greedy.keys;
+		auto& corners = greedy.corners;
+		auto& flat = greedy.flat;
+		if (sort_faces(vertices, 0, keys, corners, flat) == false) return;
+
+		auto& removed = greedy.removed;
+		removed.assign(quads, false);
+		auto& grid = greedy.grid;
+		grid.resize(BLOCKS_Y * BLOCKS_XZ);
+		std::fill(grid.begin(), grid.end(), -1);
+
+		// process one slice at a time
+		size_t begin = 0;
+		while (begin < keys.size())
+		{
+			const uint32_t slice = slice_of(keys[begin]);
+			size_t end = begin;
+			while (end < keys.size() && slice_of(keys[end]) == slice) end++;
+
+			const int n = (slice / (BLOCKS_Y+1)) / 2;
+			const int A = AXIS_A[n], B = AXIS_B[n];
+			const int W = CELLS[A];
+			// 2D mask of the quads in this slice
+			for (size_t k = begin; k < end; k++)
+				grid[cell_of(keys[k])] = uint32_t(keys[k]);
+
+			for (size_t k = begin; k < end; k++)
+			{
+				const int q = uint32_t(keys[k]);
+				if (removed[q]) continue;
+				vertex_t* origin = &vertices[q * 4];
+				const uint8_t oc = corners[q];
+				const auto steps = texture_steps(origin, oc);
+				const int cell = cell_of(keys[k]);
+				const int ca = cell % BLOCKS_XZ;
+				const int cb = cell / BLOCKS_XZ;
+
+				auto accepts = [&] (int a, int b) -> bool {
+					if (a >= W || b >= CELLS[B]) return false;
+					const int r = grid[b * BLOCKS_XZ + a];
+					if (r < 0 || removed[r] || r == q) return false;
+					return mergeable(origin, oc, steps, &vertices[r * 4], corners[r], a - ca, b - cb);
+				};
+				// grow along a, then along b for as long as whole rows match,
+				// but only along the axes the light and AO don't change along
+				int width = 1;
+				if (flat[q] & FLAT_A)
+					while (accepts(ca + width, cb)) width++;
+				int height = 1;
+				for (bool row = (flat[q] & FLAT_B) != 0; row; )
+				{
+					for (int i = 0; i < width; i++)
+						if (!accepts(ca + i, cb + height)) { row = false; break; }
+					if (row) height++;
+				}
+				if (width == 1 && height == 1) continue;
+
+				for (int j = 0; j < height; j++)
+				for (int i = 0; i < width; i++)
+					if (i || j) removed[grid[(cb + j) * BLOCKS_XZ + ca + i]] = true;
+
+				// stretch the origin quad over the whole rectangle
+				stretch(origin, oc, steps, A, B, width, height);
+			}
+			// reset only what was used
+			for (size_t k = begin; k < end; k++) grid[cell_of(keys[k])] = -1;
+			begin = end;
+		}
+		compact(vertices, removed);
+	}
+
+	void PrecompThread::greedyFluids(std::vector<vertex_t>& vertices)
+	{
+		static_assert(BLOCKS_XZ <= 32, "One row of a slice must fit in a 32-bit mask");
+		const int quads = vertices.size() / 4;
+		if (quads < 2) return;
+
+		// only uniform quads, as groups are merged in both directions at once
+		auto& keys = greedy.keys;
+		auto& corners = greedy.corners;
+		auto& flat = greedy.flat;
+		if (sort_faces(vertices, FLAT_A | FLAT_B, keys, corners, flat) == false) return;
+
+		auto& removed = greedy.removed;
+		removed.assign(quads, false);
+		auto& grid = greedy.grid;
+		grid.resize(BLOCKS_Y * BLOCKS_XZ);
+		std::fill(grid.begin(), grid.end(), -1);
+		// one bit per cell along a, one row per cell along b
+		auto& rows = greedy.rows;
+		rows.assign(BLOCKS_Y, 0);
+
+		size_t begin = 0;
+		while (begin < keys.size())
+		{
+			const uint32_t slice = slice_of(keys[begin]);
+			size_t end = begin;
+			while (end < keys.size() && slice_of(keys[end]) == slice) end++;
+
+			const int n = (slice / (BLOCKS_Y+1)) / 2;
+			const int A = AXIS_A[n], B = AXIS_B[n];
+			for (size_t k = begin; k < end; k++)
+				grid[cell_of(keys[k])] = uint32_t(keys[k]);
+
+			// every quad still in the grid starts a group of quads with the
+			// same winding and attributes, which are then merged all at once
+			for (size_t k = begin; k < end; k++)
+			{
+				const int q = uint32_t(keys[k]);
+				if (grid[cell_of(keys[k])] != q) continue;
+				const vertex_t& first = vertices[q * 4];
+				const int b0 = cell_of(keys[k]) / BLOCKS_XZ;
+				int b1 = b0;
+				for (size_t j = k; j < end; j++)
+				{
+					const int r = uint32_t(keys[j]);
+					const int cell = cell_of(keys[j]);
+					if (grid[cell] != r || corners[r] != corners[q]
+					|| !same_attributes(vertices[r * 4], first)) continue;
+					rows[cell / BLOCKS_XZ] |= 1u << (cell % BLOCKS_XZ);
+					b1 = cell / BLOCKS_XZ;
+				}
+				// the longest run in a row, grown down for as long as the rows
+				// below have the whole run too; consumes every bit of the group
+				for (int b = b0; b <= b1; b++)
+				while (rows[b])
+				{
+					const int a = __builtin_ctz(rows[b]);
+					const int width = __builtin_ctz(~(rows[b] >> a));
+					const uint32_t run = ((1u << width) - 1) << a;
+					rows[b] &= ~run;
+					int height = 1;
+					while (b + height <= b1 && (rows[b + height] & run) == run)
+					{
+						rows[b + height] &= ~run;
+						height++;
+					}
+
+					const int origin = grid[b * BLOCKS_XZ + a];
+					for (int j = 0; j < height; j++)
+					for (int i = 0; i < width; i++)
+					{
+						int& cell = grid[(b + j) * BLOCKS_XZ + a + i];
+						if (cell != origin) removed[cell] = true;
+						cell = -1;
+					}
+					// fluid shaders only use the positions, so any texture
+					// steps will do
+					vertex_t* ov = &vertices[origin * 4];
+					stretch(ov, corners[origin], texture_steps(ov, corners[origin]), A, B, width, height);
+				}
+			}
+			// every quad of the slice was in a group, so the grid is clear
+			begin = end;
+		}
+		compact(vertices, removed);
+	}
+}
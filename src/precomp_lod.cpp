@@ -0,0 +1,160 @@
+#include "precomp_thread.hpp"
+
+#include "renderconst.hpp"
+#include <algorithm>
+
+namespace cppcraft
+{
+	static const int S = RenderConst::VERTEX_SCALE;
+
+	// what a coarse cell can be made of: cubes that hide something, but not
+	// fluids, which keep their (flat) surface, nor models with their own
+	// visibility test, like leaves and crosses
+	static inline bool lod_solid(const Block& block)
+	{
+		const auto& bd = block.db();
+		return !block.isAir() && !block.isLiquid() && bd.visibilityComp == nullptr
+			&& bd.transparentSides != ::db::BlockData::SIDE_ALL;
+	}
+
+	// cube face directions, in the same order as the visible faces mask
+	static const int DIR[6][3] = {
+		{0, 0, 1}, {0, 0, -1}, {0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}
+	};
+
+	/**
+	 * Moves the quad @q of the block at @block over the whole cell starting
+	 * at block @origin, @s blocks wide. Texture coordinates follow along
+	 * each axis with the same step as on the original quad.
+	**/
+	static void stretch_quad(vertex_t* q, const int block[3], const int origin[3], int s)
+	{
+		int du[3] = {0, 0, 0}, dv[3] = {0, 0, 0};
+		for (int i = 1; i < 4; i++)
+		{
+			const int d[3] = { q[i].x - q[0].x, q[i].y - q[0].y, q[i].z - q[0].z };
+			// only the edges along exactly one axis
+			if ((d[0] != 0) + (d[1] != 0) + (d[2] != 0) != 1) continue;
+			const int a = d[0] ? 0 : (d[1] ? 1 : 2);
+			du[a] = (q[i].u - q[0].u) * S / d[a];
+			dv[a] = (q[i].v - q[0].v) * S / d[a];
+		}
+		for (int i = 0; i < 4; i++)
+		{
+			GLshort* p[3] = { &q[i].x, &q[i].y, &q[i].z };
+			for (int a = 0; a < 3; a++)
+			{
+				const int local = *p[a] - block[a] * S;
+				const int moved = origin[a] * S + local * s;
+				q[i].u += du[a] * (moved - *p[a]) / S;
+				q[i].v += dv[a] * (moved - *p[a]) / S;
+				*p[a] = moved;
+			}
+		}
+	}
+
+	void PrecompThread::lodMesh(Precomp& pc, int y1)
+	{
+		const int s = 1 << pc.lod;
+		const int W = BLOCKS_XZ / s;
+		// the cells of this sub-mesh, one more around them, and two above
+		const int cy0 = pc.y0() / s;
+		const int cy1 = std::min((y1 + s-1) / s, pc.y1() / s);
+		const int H = cy1 - cy0 + 3;
+		lodcells.resize((W+2) * H * (W+2));
+		auto cell = [this, W, H, cy0] (int cx, int cy, int cz) -> uint8_t& {
+			return lodcells[((cx+1) * H + (cy - cy0 + 1)) * (W+2) + (cz+1)];
+		};
+
+		// majority vote: a cell is solid when at least half of its blocks are
+		for (int cx = -1; cx <= W; cx++)
+		for (int cz = -1; cz <= W; cz++)
+		for (int cy = cy0 - 1; cy < cy1 + 2; cy++)
+		{
+			int count = 0;
+			// below the world is solid, and above it is air
+			if (cy < 0) count = s * s * s;
+			else if (cy * s < BLOCKS_Y)
+			{
+				for (int x = cx * s; x < (cx+1) * s; x++)
+				for (int z = cz * s; z < (cz+1) * s; z++)
+				for (int y = cy * s; y < (cy+1) * s; y++)
+					count += lod_solid(pc.sector(x, y, z));
+			}
+			cell(cx, cy, cz) = (count * 2 >= s * s * s);
+		}
+
+		for (int cx = 0; cx < W; cx++)
+		for (int cz = 0; cz < W; cz++)
+		for (int cy = cy0; cy < cy1; cy++)
+		{
+			if (cell(cx, cy, cz) == false) continue;
+			// near the surface, the faces towards the neighboring sectors
+			// are kept as skirts, hiding the cracks to meshes of other detail
+			const bool surface = !cell(cx, cy+1, cz) || !cell(cx, cy+2, cz);
+
+			for (int face = 0; face < 6; face++)
+			{
+				const int nx = cx + DIR[face][0];
+				const int nz = cz + DIR[face][2];
+				const bool border = nx < 0 || nx >= W || nz < 0 || nz >= W;
+				if (cell(nx, cy + DIR[face][1], nz) && !(border && surface)) continue;
+				emitCell(pc, cx, cy, cz, face);
+			}
+		}
+
+		// fluids are meshed block by block, as they are mostly a flat surface anyway
+		for (int bx = 0; bx < BLOCKS_XZ; bx++)
+		for (int bz = 0; bz < BLOCKS_XZ; bz++)
+		{
+			const int top = std::min((int) pc.sector(bx, bz).skyLevel, y1);
+			for (int by = pc.y0(); by < top; by++)
+			{
+				const Block& block = pc.sector(bx, by, bz);
+				if (block.isLiquid()) ptd.process_block(block, bx, by, bz);
+			}
+		}
+	}
+
+	void PrecompThread::emitCell(Precomp& pc, int cx, int cy, int cz, int face)
+	{
+		const int s = 1 << pc.lod;
+		// the most common cube in the cell, and of those, the one furthest
+		// out towards @face, so that the light and colors are from the surface
+		struct candidate_t {
+			block_t id;
+			int count;
+			int score;
+			int pos[3];
+		};
+		candidate_t candidates[64];
+		int ncand = 0;
+		for (int x = cx * s; x < (cx+1) * s; x++)
+		for (int z = cz * s; z < (cz+1) * s; z++)
+		for (int y = cy * s; y < (cy+1) * s; y++)
+		{
+			const Block& block = pc.sector(x, y, z);
+			if (lod_solid(block) == false) continue;
+			const int score = x * DIR[face][0] + y * DIR[face][1] + z * DIR[face][2];
+			int c = 0;
+			while (c < ncand && candidates[c].id != block.getID()) c++;
+			if (c == ncand) candidates[ncand++] = { block.getID(), 0, score, {x, y, z} };
+			auto& cand = candidates[c];
+			cand.count++;
+			if (score > cand.score) cand = { cand.id, cand.count, score, {x, y, z} };
+		}
+		// a solid cell has at least half of its blocks in there
+		const candidate_t* best = &candidates[0];
+		for (int c = 1; c < ncand; c++)
+			if (candidates[c].count > best->count) best = &candidates[c];
+
+		const Block& block = pc.sector(best->pos[0], best->pos[1], best->pos[2]);
+		auto& line = ptd.vertices[block.db().shader];
+		const size_t start = line.size();
+		ptd.process_block(block, best->pos[0], best->pos[1], best->pos[2], 1 << face);
+
+		const int origin[3] = { cx * s, cy * s, cz * s };
+		for (size_t q = start; q + 4 <= line.size(); q += 4)
+			stretch_quad(&line[q], best->pos, origin, s);
+	}
+}
@@ -298,49 +298,4 @@ namespace cppcraft
 			pc.vertices[shaderline] = verts;
 		}
 	}
-
-	void PrecompThread::optimizeShadedMesh(Precomp& pc, int shaderline)
-	{
-		static const int WATER_MAX_VERTS = Sector::BLOCKS_XZ * Sector::BLOCKS_XZ * 4;
-
-		int verts = pc.vertices[shaderline];
-		vertex_t* water = &pc.datadump.at(pc.bufferoffset[shaderline]);
-
-		if (verts == WATER_MAX_VERTS)
-		{
-			const auto L = water->light;
-      const auto C = water->color;
-
-			for (int i = 1; i < WATER_MAX_VERTS; i++)
-			{
-				if (water[i].light != L || water[i].color != C)
-            goto optimizeManuallyShaded;
-			}
-
-			water[0].x = 0;
-			water[0].z = 0;
-
-			water[1].x = 0;
-			water[1].z = RenderConst::VERTEX_SCALE * Sector::BLOCKS_XZ;
-
-			water[2].x = RenderConst::VERTEX_SCALE * Sector::BLOCKS_XZ;
-			water[2].z = RenderConst::VERTEX_SCALE * Sector::BLOCKS_XZ;
-
-			water[3].x = RenderConst::VERTEX_SCALE * Sector::BLOCKS_XZ;
-			water[3].z = 0;
-
-			// set final number of vertices
-			pc.vertices[shaderline] = 4;
-		}
-		// try to optimize the water plane manually
-		else if (verts >= 8)
-		{
-		optimizeManuallyShaded:
-      (void) verts;
-			// verts is sent by reference
-			//optimizeShaderPlane(verts, water);
-			// set final number of vertices
-			//pc.vertices[shaderline] = verts;
-		}
-	}
 }
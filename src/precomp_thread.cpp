@@ -1,53 +1,112 @@
 #include "precomp_thread.hpp"
 
 #include <library/log.hpp>
+#include "gameconf.hpp"
 #include "precompiler.hpp"
 #include "renderconst.hpp"
 #include "sectors.hpp"
 #include "tiles.hpp"
+#include <algorithm>
 #include <cstring>
 
 using namespace library;
 
 namespace cppcraft
 {
+	extern bool emitPackedQuad(std::vector<terrain_vertex_t>&, const vertex_t*);
+
 	const int PTD::REPEAT_FACTOR = RenderConst::VERTEX_SCALE / TileDB::TILES_PER_BIG_TILE;
 
+	PrecompThread& PrecompThread::local()
+	{
+		static thread_local PrecompThread worker;
+		return worker;
+	}
+
 	void PrecompThread::precompile(Precomp& pc)
 	{
 		// set sector from precomp
 		ptd.sector = &pc.sector;
+		ptd.resetLighting();
+		// the same thread meshes all the dirty sub-meshes of a sector
+		for (auto& vec : ptd.vertices) vec.clear();
+		ptd.instances.clear();
+		ptd.instancing = gameconf.instanced_models;
 
-		// iterate up to skylevel for each (x, z)
-		for (int bx = 0;  bx < BLOCKS_XZ; bx++)
-		for (int bz = 0;  bz < BLOCKS_XZ; bz++)
-		for (int by = 0;  by < pc.sector(bx, bz).skyLevel; by++)
+		// the highest skylevel decides how much of the sector to scan
+		int height = 0;
+		for (int bx = 0; bx < BLOCKS_XZ; bx++)
+		for (int bz = 0; bz < BLOCKS_XZ; bz++)
+			height = std::max(height, (int) pc.sector(bx, bz).skyLevel);
+		// only the layers of this sub-mesh, and nothing above the sky
+		const int y0 = pc.y0();
+		const int y1 = std::min(pc.y1(), height);
+		if (y0 >= y1) return;
+		// the light around every face of these layers
+		ptd.prepareLighting(std::max(y0 - 1, 0), std::min(y1 + 1, BLOCKS_Y));
+		// distant sectors get a coarser mesh instead
+		if (pc.lod > 0)
+		{
+			lodMesh(pc, y1);
+		}
+		else
 		{
-			// get pointer to current block
-			Block& block = pc.sector(bx, by, bz);
+			// +1 for the faces on top of the highest blocks
+			facemask->build(pc.sector, y0, std::min(y1 + 1, BLOCKS_Y));
 
-			// ignore AIR
-			if (LIKELY(block.getID() != _AIR))
+			// iterate up to skylevel for each (x, z)
+			facemask_t::column_t visible;
+			for (int bx = 0;  bx < BLOCKS_XZ; bx++)
+			for (int bz = 0;  bz < BLOCKS_XZ; bz++)
 			{
-				// process one block id, and potentially add it to mesh
-				// the generated mesh is added to a shaderline determined by its block id
-				ptd.process_block(block, bx, by, bz);
+				facemask->visible(bx, bz, visible);
+				const auto& special = facemask->special(bx, bz);
+				const int top = std::min((int) pc.sector(bx, bz).skyLevel, y1);
+
+				// only the blocks that can have visible faces, bottom to top
+				for (int w = y0 / 64; w < facemask_t::WORDS && w * 64 < top; w++)
+				{
+					uint64_t bits = visible[w] | special[w];
+					if (top - w * 64 < 64) bits &= (1ull << (top - w * 64)) - 1;
+					if (y0 > w * 64) bits &= ~0ull << (y0 - w * 64);
+
+					while (bits)
+					{
+						const int by = w * 64 + __builtin_ctzll(bits);
+						const uint64_t bit = bits & -bits;
+						bits ^= bit;
+						// get pointer to current block
+						const Block& block = pc.sector(bx, by, bz);
+
+						// the generated mesh is added to a shaderline determined by its block id
+						if (special[w] & bit)
+							ptd.process_block(block, bx, by, bz);
+						else
+							ptd.process_block(block, bx, by, bz, facemask->visibleFaces(bx, by, bz));
+					}
+				}
 			}
 		}
 
+		// the surfaces of oceans and lava lakes are merged regardless
+		greedyFluids(ptd.vertices[RenderConst::TX_WATER]);
+		greedyFluids(ptd.vertices[RenderConst::TX_LAVA]);
+		// merge cube faces before AO flipping, which leaves quads alone
+		// when their light and AO only change along one axis
+		if (gameconf.greedy_meshing)
+		{
+			for (auto& vec : ptd.vertices) greedyMesh(vec);
+		}
+
 		// count the number of vertices generated
 		size_t total = 0;
 		for (const auto& vec : ptd.vertices) {
       total += vec.size();
 		}
 
-		if (total == 0)
-		{
-			printf("[!] No vertices (total) for (%d, %d)\n",
-				      pc.sector.wx, pc.sector.wz);
-			// no vertices, we can exit early
-			return;
-		}
+		pc.instancedump.assign(ptd.instances.begin(), ptd.instances.end());
+		// no vertices (eg. sub-meshes in the sky), we can exit early
+		if (total == 0) return;
 
 		// reserve exact number of vertices
 		pc.datadump.reserve(total);
@@ -69,4 +128,30 @@ namespace cppcraft
     assert(pc.datadump.size() == total);
 	}
 
+	void PrecompThread::packTerrain(Precomp& pc)
+	{
+		size_t out = 0;
+		for (int i = 0; i < RenderConst::MAX_UNIQUE_SHADERS; i++)
+		{
+			const size_t begin = pc.bufferoffset[i];
+			const size_t end   = begin + pc.vertices[i];
+			pc.bufferoffset[i] = out;
+			pc.packedoffset[i] = pc.packeddump.size();
+
+			for (size_t v = begin; v < end; v += 4)
+			{
+				// only the lines drawn by the standard block shaders
+				const bool packable =
+					(i == RenderConst::TX_REPEAT || i == RenderConst::TX_SOLID);
+				if (packable && emitPackedQuad(pc.packeddump, &pc.datadump[v])) continue;
+				// keep the rest in order, as full vertices
+				if (out != v) std::copy(&pc.datadump[v], &pc.datadump[v] + 4, &pc.datadump[out]);
+				out += 4;
+			}
+			pc.vertices[i] = out - pc.bufferoffset[i];
+			pc.packed[i]   = pc.packeddump.size() - pc.packedoffset[i];
+		}
+		pc.datadump.resize(out);
+	}
+
 }
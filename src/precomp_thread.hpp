@@ -4,10 +4,12 @@
 #define AMBIENT_OCCLUSION_GRADIENTS
 
 #include "precompiler.hpp"
+#include "precomp_facemask.hpp"
 #include "precomp_thread_data.hpp"
 #include "renderconst.hpp"
 #include "vertex_block.hpp"
 #include <memory>
+#include <vector>
 
 namespace cppcraft
 {
@@ -17,20 +19,53 @@ namespace cppcraft
 	class PrecompThread
 	{
 	public:
+		// the mesher of the calling (worker) thread, which lives as long
+		// as the thread, so that its buffers keep their capacity between jobs
+		static PrecompThread& local();
+
 		PTD ptd;
 
 		// stage 2, generating mesh
 		void precompile(Precomp& pc);
+		// stage 2 for distant sectors, with one cube for each cell of
+		// 2^lod blocks that are mostly solid, up to @y1
+		void lodMesh(Precomp& pc, int y1);
+		// merges whole cube faces with equal attributes into larger quads,
+		// along the axes their light and AO don't change along,
+		// one 2D mask per face direction and slice
+		void greedyMesh(std::vector<vertex_t>& vertices);
+		// merges the faces of fluids, whose shaders only use the positions,
+		// into the largest rectangles of equal attributes, one row mask per cell
+		void greedyFluids(std::vector<vertex_t>& vertices);
 		// stage 3, computing AO
 		void ambientOcclusion(Precomp& pc);
+		// stage 4, moving plain terrain faces to packed vertices
+		void packTerrain(Precomp& pc);
+		// stage 5, counting the triangle indices for each shader line
+		void createIndices(Precomp& pc);
 
 		// ao gradient program, adding corner shadows to a completed mesh
 		void ambientOcclusionGradients(bordered_sector_t& sector, vertex_t* datadump, int vertexCount);
 		// mesh optimizers
 		void optimizeMesh(Precomp& pc, int shaderline, int txsize);
-		void optimizeShadedMesh(Precomp& pc, int shaderline);
 
-		void createIndices(Precomp& pc, int verts);
+	private:
+		void emitCell(Precomp& pc, int cx, int cy, int cz, int face);
+
+		// occupancy and transparency of the sector being meshed,
+		// on the heap as it is too large for the worker stacks
+		std::unique_ptr<facemask_t> facemask = std::make_unique<facemask_t> ();
+		// scratch buffers for the greedy mesher, kept between sectors
+		struct {
+			std::vector<uint64_t> keys;
+			std::vector<uint8_t>  corners;
+			std::vector<uint8_t>  flat;
+			std::vector<bool>     removed;
+			std::vector<int>      grid;
+			std::vector<uint32_t> rows;
+		} greedy;
+		// solid cells of the level of detail mesh, and a ring around them
+		std::vector<uint8_t> lodcells;
 	};
 
 }
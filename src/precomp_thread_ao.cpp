@@ -60,27 +60,12 @@ namespace cppcraft
 		// optimize transparent textures
 		optimizeMesh(precomp, RenderConst::TX_TRANS, RenderConst::VERTEX_SCALE);
 		*/
-		// optimize water & lava meshes
-		//optimizeShadedMesh(precomp, RenderConst::TX_WATER);
-		//optimizeShadedMesh(precomp, RenderConst::TX_LAVA);
 
 #ifdef TIMING
 		logger << Log::INFO << "Optimize time: " << timer.startNewRound() << Log::ENDL;
 #endif
 
-		// recount vertices
-    /*
-		size_t cnt = precomp.vertices[0];
-		for (int i = 1; i < RenderConst::MAX_UNIQUE_SHADERS; i++)
-		{
-			cnt += precomp.vertices[i];
-		}
-
-		createIndices(precomp, cnt);
-		*/
-
 #ifdef TIMING
-		logger << Log::INFO << "Indexing time: " << timer.getTime() << Log::ENDL;
 		timingMutex.unlock();
 #endif
 	}
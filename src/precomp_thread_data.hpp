@@ -18,6 +18,9 @@ namespace cppcraft
 		// working buffers
 		alignas(32)
     std::array<std::vector<vertex_t>, RenderConst::MAX_UNIQUE_SHADERS> vertices;
+		// models drawn with instancing instead, all on the 2-sided line
+		std::vector<model_instance_t> instances;
+		bool instancing = false;
 
 		// all the blocks
 		bordered_sector_t* sector = nullptr;
@@ -54,9 +57,18 @@ namespace cppcraft
 
 		// processes a Block, outputs a mesh w/lighting
 		void process_block(const Block& currentBlock, int bx, int by, int bz);
+		// same, with the visible @sides already known
+		void process_block(const Block& currentBlock, int bx, int by, int bz, uint16_t sides);
+
+		// samples the light of the layers [y0, y1) of the sector, and the
+		// blocks around them, for the face lighting of the next blocks
+		void prepareLighting(int y0, int y1);
+		// forgets the samples, eg. when the sector changes
+		void resetLighting() { light_y0 = light_y1 = 0; }
 
 		// resolve (x, y, z) to vertex lighting
 		light_value_t getLight(int x, int y, int z);
+		// the light at one corner, averaged over the 4 blocks around it
 		light_value_t smoothLight(const Block&,
                               int x1, int y1, int z1,
                               int x2, int y2, int z2,
@@ -69,6 +81,19 @@ namespace cppcraft
 		void faceLighting_NY(const Block&, vtx_iterator, int bx, int by, int bz);
 		void faceLighting_PX(const Block&, vtx_iterator, int bx, int by, int bz);
 		void faceLighting_NX(const Block&, vtx_iterator, int bx, int by, int bz);
+
+	private:
+		// all four corners of a face at once, from the samples of the 3x3
+		// blocks around (bx, by, bz), along the axes with strides @su and @sv
+		void planeLighting(const Block&, vtx_iterator, int bx, int by, int bz,
+		                   int su, int sv, const uint8_t corners[4]) const;
+		bool sampled(int y0, int y1) const noexcept {
+			return y0 >= light_y0 && y1 <= light_y1;
+		}
+
+		// one word per block, with the same lanes as the sums of 4 of them
+		std::vector<uint64_t> light_samples;
+		int light_y0 = 0, light_y1 = 0;
 	};
 
 }
@@ -1,13 +1,104 @@
 #include "precomp_thread_data.hpp"
 
 #include "blocks_bordered.hpp"
-#include <cmath>
 
 namespace cppcraft
 {
+	// ambient occlusion gradients, by the number of blocks around a corner
+	static const unsigned char shadowRamp[] =
+			{ 127, 127 - 28, 127 - 40, 127 - 56, 127 - 64 };
+
+	/**
+	 * The 8-bit lanes of a light sample. The sum of 4 samples still fits in
+	 * each lane, so all the channels of a corner are summed with 3 adds.
+	 * The counts are 0 or 1, with the AO contribution in the high nibble.
+	**/
+	static const int LANE_SKY   = 0;  // skylight, if transparent
+	static const int LANE_TORCH = 8;  // torchlight, if transparent or a light
+	static const int LANE_SKY_COUNT   = 16; // transparent | AO of solid sources
+	static const int LANE_TORCH_COUNT = 24; // transparent or light | AO of transparent sources
+	static const int LANE_RED   = 32; // packed RGB torchlight, like LANE_TORCH
+	static const int LANE_GREEN = 40;
+	static const int LANE_BLUE  = 48;
+	static const int SAMPLES_W  = BLOCKS_XZ + 2;
+
+	static inline int lane(uint64_t sum, int shift)
+	{
+		return (sum >> shift) & 0xFF;
+	}
+	// level * 17 / total, for the 1 to 4 blocks that were counted
+	static inline int average(int sum, int total)
+	{
+		static const int RECIPROCAL[5] = { 0, 65536, 32768, 21846, 16384 };
+		return (sum * 17 * RECIPROCAL[total]) >> 16;
+	}
+
+	void PTD::prepareLighting(int y0, int y1)
+	{
+		light_y0 = y0;
+		light_y1 = y1;
+		light_samples.resize(SAMPLES_W * SAMPLES_W * (y1 - y0));
+		const bool colors = sector->hasTorchColors();
+
+		for (int x = -1; x <= BLOCKS_XZ; x++)
+		for (int z = -1; z <= BLOCKS_XZ; z++)
+		{
+			uint64_t* out = &light_samples[(x+1) * SAMPLES_W + (z+1)];
+			for (int y = y0; y < y1; y++, out += SAMPLES_W * SAMPLES_W)
+			{
+				const Block& blk = sector->get(x, y, z);
+				const auto& db = blk.db();
+				const bool transp = db.transparent;
+				const bool lit    = transp || db.isLight();
+				const bool solid  = db.isBlock();
+				uint64_t sample = uint64_t(transp | solid << 4) << LANE_SKY_COUNT;
+				sample |= uint64_t(lit | (solid || (transp && !blk.isAir())) << 4) << LANE_TORCH_COUNT;
+				if (transp) sample |= uint64_t(blk.getChannel(0)) << LANE_SKY;
+				if (lit)
+				{
+					sample |= uint64_t(blk.getChannel(1)) << LANE_TORCH;
+					if (colors)
+					{
+						const auto color = sector->getTorchColor(x, y, z);
+						sample |= uint64_t(LightColor::red(color))   << LANE_RED;
+						sample |= uint64_t(LightColor::green(color)) << LANE_GREEN;
+						sample |= uint64_t(LightColor::blue(color))  << LANE_BLUE;
+					}
+				}
+				*out = sample;
+			}
+		}
+	}
+
+	// the same as smoothLight, from the sum of the 4 samples around a corner
+	static inline light_value_t resolve(uint64_t sum, int ramp_shift, bool colors)
+	{
+		light_value_t light = 0;
+		const int sky_total = (sum >> LANE_SKY_COUNT) & 0xF;
+		if (sky_total != 0)
+		{
+			light |= average(lane(sum, LANE_SKY), sky_total);
+			light |= shadowRamp[(sum >> ramp_shift) & 0xF] << 16;
+		}
+		const int torch_total = (sum >> LANE_TORCH_COUNT) & 0xF;
+		if (torch_total != 0)
+		{
+			const int V = lane(sum, LANE_TORCH);
+			light |= average(V, torch_total) << 8;
+			// gray when colored lighting is disabled
+			const int R = colors ? lane(sum, LANE_RED)   : V;
+			const int G = colors ? lane(sum, LANE_GREEN) : V;
+			const int B = colors ? lane(sum, LANE_BLUE)  : V;
+			light |= light_value_t(average(R, torch_total)) << 32;
+			light |= light_value_t(average(G, torch_total)) << 40;
+			light |= light_value_t(average(B, torch_total)) << 48;
+		}
+		return light;
+	}
+
 	light_value_t PTD::getLight(int x, int y, int z)
 	{
-		Block& block = sector->get(x, y, z);
+		const Block& block = sector->get(x, y, z);
 
 		light_value_t RGBA = 0;
 		for (int ch = 0; ch < Block::CHANNELS; ch++)
@@ -25,11 +116,14 @@ namespace cppcraft
                                  int x4, int y4, int z4)
 	{
 		// TODO: calculate the actual light values...
-		Block* bl[4];
+		const Block* bl[4];
 		bl[0] = &sector->get(x1, y1, z1);
 		bl[1] = &sector->get(x2, y2, z2);
 		bl[2] = &sector->get(x3, y3, z3);
 		bl[3] = &sector->get(x4, y4, z4);
+		const int vx[4] = {x1, x2, x3, x4};
+		const int vy[4] = {y1, y2, y3, y4};
+		const int vz[4] = {z1, z2, z3, z4};
 
     light_value_t final_light = 0;
     int ramp = 0;
@@ -54,17 +148,34 @@ namespace cppcraft
             total++;
         }
   		}
+      // RGB torchlight, gray when colored lighting is disabled
+      if (ch == 1 && total != 0)
+      {
+        int R = V, G = V, B = V;
+        if (sector->hasTorchColors())
+        {
+          R = G = B = 0;
+          for (int i = 0; i < 4; i++)
+          if (bl[i]->isTransparent() || bl[i]->isLight())
+          {
+            const auto color = sector->getTorchColor(vx[i], vy[i], vz[i]);
+            R += LightColor::red(color);
+            G += LightColor::green(color);
+            B += LightColor::blue(color);
+          }
+        }
+        final_light |= light_value_t(R * 17 / total) << 32;
+        final_light |= light_value_t(G * 17 / total) << 40;
+        final_light |= light_value_t(B * 17 / total) << 48;
+      }
       if (total != 0)
       {
         if (ch == 0)
         {
+          // raw skylight level, the shaders apply the falloff and daylight
           const float lv = (float) V / total;
-          float factor = 1.0f - std::min(y1 , WATERLEVEL) / (float) BLOCKS_Y;
-          float light = powf(0.88f, (15.0f - lv) * factor * factor);
-          final_light |= int(25 + 230.0f * light);
+          final_light |= int(lv * 17);
           // ambient occlusion gradients
-          static unsigned char shadowRamp[] =
-              { 127, 127 - 28, 127 - 40, 127 - 56, 127 - 64 };
           final_light |= shadowRamp[ramp] << 16;
         }
         else
@@ -77,14 +188,50 @@ namespace cppcraft
     return final_light;
 	}
 
-  inline void set_light(vertex_t& vtx, uint32_t light)
+  inline void set_light(vertex_t& vtx, light_value_t light)
   {
     vtx.ao = light >> 16;
     vtx.light = light & 0xFFFF;
+    vtx.lightcolor = light >> 32;
   }
 
+	void PTD::planeLighting(const Block& source, vtx_iterator vtx, int bx, int by, int bz,
+	                        int su, int sv, const uint8_t corners[4]) const
+	{
+		const uint64_t* center =
+			&light_samples[((by - light_y0) * SAMPLES_W + bx + 1) * SAMPLES_W + bz + 1];
+		// pairs along u, then pairs of those along v: the 2x2 sums with
+		// the lowest corner at (-1, -1), (0, -1), (-1, 0) and (0, 0)
+		uint64_t pairs[3][2];
+		for (int j = 0; j < 3; j++)
+		{
+			const uint64_t* row = center + (j-1) * sv;
+			pairs[j][0] = row[-su] + row[0];
+			pairs[j][1] = row[0] + row[su];
+		}
+		const uint64_t sums[4] = {
+			pairs[0][0] + pairs[1][0], pairs[0][1] + pairs[1][1],
+			pairs[1][0] + pairs[2][0], pairs[1][1] + pairs[2][1]
+		};
+		const int ramp_shift = 4 + (source.isTransparent() ? LANE_TORCH_COUNT : LANE_SKY_COUNT);
+		const bool colors = sector->hasTorchColors();
+		for (int i = 0; i < 4; i++)
+			set_light(vtx[i], resolve(sums[corners[i]], ramp_shift, colors));
+	}
+
+	// the 2x2 sum each vertex of a face gets, and the strides of the face plane
+	static const uint8_t CORNERS_A[4] = {0, 1, 3, 2};
+	static const uint8_t CORNERS_B[4] = {0, 2, 3, 1};
+	static const int STRIDE_X = SAMPLES_W;
+	static const int STRIDE_Y = SAMPLES_W * SAMPLES_W;
+	static const int STRIDE_Z = 1;
+
 	void PTD::faceLighting_PZ(const Block& blk, vtx_iterator vtx, int bx, int by, int bz)
 	{
+		if (sampled(by-1, by+2)) {
+			planeLighting(blk, vtx, bx, by, bz, STRIDE_X, STRIDE_Y, CORNERS_A);
+			return;
+		}
 		set_light(vtx[0], smoothLight(blk, bx  , by,   bz,  bx-1,by,bz,   bx-1,by-1,bz,  bx,by-1,bz));
 		set_light(vtx[1], smoothLight(blk, bx+1, by,   bz,  bx, by, bz,   bx,by-1,bz,  bx+1,by-1,bz));
 		set_light(vtx[2], smoothLight(blk, bx+1, by+1, bz,  bx,by+1,bz,   bx,by,bz,    bx+1,by,bz));
@@ -93,6 +240,10 @@ namespace cppcraft
 
 	void PTD::faceLighting_NZ(const Block& blk, vtx_iterator vtx, int bx, int by, int bz)
 	{
+		if (sampled(by-1, by+2)) {
+			planeLighting(blk, vtx, bx, by, bz, STRIDE_X, STRIDE_Y, CORNERS_B);
+			return;
+		}
 		set_light(vtx[0], smoothLight(blk, bx  , by  , bz,   bx-1, by  ,bz,  bx, by-1, bz,  bx-1, by-1, bz));
 		set_light(vtx[1], smoothLight(blk, bx  , by+1, bz,   bx-1, by+1,bz,  bx, by  , bz,  bx-1, by  , bz));
 		set_light(vtx[2], smoothLight(blk, bx+1, by+1, bz,   bx,  by+1, bz,  bx+1, by, bz,  bx, by  ,   bz));
@@ -101,6 +252,10 @@ namespace cppcraft
 
 	void PTD::faceLighting_PY(const Block& blk, vtx_iterator vtx, int bx, int by, int bz)
 	{
+		if (sampled(by, by+1)) {
+			planeLighting(blk, vtx, bx, by, bz, STRIDE_X, STRIDE_Z, CORNERS_B);
+			return;
+		}
 		set_light(vtx[0], smoothLight(blk, bx, by, bz,    bx-1, by, bz,  bx, by, bz-1,  bx-1, by, bz-1));
 		set_light(vtx[1], smoothLight(blk, bx, by, bz+1,  bx-1, by, bz+1,  bx, by, bz,  bx-1, by, bz));
 		set_light(vtx[2], smoothLight(blk, bx+1, by, bz+1,  bx, by, bz+1,  bx+1, by, bz,  bx, by, bz));
@@ -109,6 +264,10 @@ namespace cppcraft
 
 	void PTD::faceLighting_NY(const Block& blk, vtx_iterator vtx, int bx, int by, int bz)
 	{
+		if (sampled(by, by+1)) {
+			planeLighting(blk, vtx, bx, by, bz, STRIDE_X, STRIDE_Z, CORNERS_A);
+			return;
+		}
 		set_light(vtx[0], smoothLight(blk, bx  , by, bz  , bx-1, by, bz,  bx, by, bz-1,  bx-1, by, bz-1));
 		set_light(vtx[1], smoothLight(blk, bx+1, by, bz  , bx, by, bz,  bx+1, by, bz-1,  bx, by, bz-1));
 		set_light(vtx[2], smoothLight(blk, bx+1, by, bz+1, bx, by, bz+1,  bx+1, by, bz,  bx, by, bz));
@@ -117,6 +276,10 @@ namespace cppcraft
 
 	void PTD::faceLighting_PX(const Block& blk, vtx_iterator vtx, int bx, int by, int bz)
 	{
+		if (sampled(by-1, by+2)) {
+			planeLighting(blk, vtx, bx, by, bz, STRIDE_Z, STRIDE_Y, CORNERS_B);
+			return;
+		}
 		set_light(vtx[0], smoothLight(blk, bx, by,   bz  ,   bx,by,bz-1,   bx,by-1,bz-1,   bx,by-1,bz));
 		set_light(vtx[1], smoothLight(blk, bx, by+1, bz  ,   bx,by+1,bz-1, bx,by,bz-1,     bx,by,bz));
 		set_light(vtx[2], smoothLight(blk, bx, by+1, bz+1,   bx,by+1,bz,   bx,by,bz,       bx,by,bz+1));
@@ -125,6 +288,10 @@ namespace cppcraft
 
 	void PTD::faceLighting_NX(const Block& blk, vtx_iterator vtx, int bx, int by, int bz)
 	{
+		if (sampled(by-1, by+2)) {
+			planeLighting(blk, vtx, bx, by, bz, STRIDE_Z, STRIDE_Y, CORNERS_A);
+			return;
+		}
 		set_light(vtx[0], smoothLight(blk, bx, by,   bz  , bx,by,bz-1,   bx,by-1,bz-1,   bx,by-1,bz));
 		set_light(vtx[1], smoothLight(blk, bx, by,   bz+1, bx,by,bz,     bx,by-1,bz,     bx,by-1,bz+1));
 		set_light(vtx[2], smoothLight(blk, bx, by+1, bz+1, bx,by+1,bz,   bx,by,bz,       bx,by,bz+1));
@@ -69,10 +69,10 @@ namespace cppcraft
 		int model = currentBlock.getFacing();
 		
 		// find all direct neighbors
-		Block& mpx = sector->get(bx+1, by, bz);
-		Block& mnx = sector->get(bx-1, by, bz);
-		Block& mpz = sector->get(bx, by, bz+1);
-		Block& mnz = sector->get(bx, by, bz-1);
+		const Block& mpx = sector->get(bx+1, by, bz);
+		const Block& mnx = sector->get(bx-1, by, bz);
+		const Block& mpz = sector->get(bx, by, bz+1);
+		const Block& mnz = sector->get(bx, by, bz-1);
 		
 		// select special models for stair connections
 		// all stairs connect, even if they don't have the same id
@@ -6,6 +6,7 @@
 #include "blocks_bordered.hpp"
 #include "renderconst.hpp"
 #include "vertex_block.hpp"
+#include <chrono>
 #include <deque>
 #include <vector>
 
@@ -16,24 +17,62 @@ namespace cppcraft
 	class alignas(32) Precomp {
 	public:
 		/// this constructor MUST be called from main world thread
-		explicit Precomp(Sector& sect)
-  		: sector(sect) {}
+		Precomp(Sector& sect, int submesh)
+  		: sector(sect), mesh(submesh) {}
+
+		/// reuses the precomp for another job, keeping the capacity of its buffers
+		/// MUST also be called from main world thread
+		void reset(Sector& sect, int submesh)
+		{
+			sector.assign(sect);
+			mesh = submesh;
+			lod  = 0;
+			datadump.clear();
+			packeddump.clear();
+			instancedump.clear();
+			for (int i = 0; i < RenderConst::MAX_UNIQUE_SHADERS; i++)
+			{
+				vertices[i] = bufferoffset[i] = 0;
+				packed[i] = packedoffset[i] = 0;
+				indices[i] = packedindices[i] = 0;
+			}
+		}
 
 		// our source sector (with additional data)
 		bordered_sector_t sector;
+		// the vertical sub-mesh, covering the layers [y0, y1)
+		int mesh;
+		int y0() const noexcept { return mesh * Sector::MESH_LAYERS; }
+		int y1() const noexcept { return y0() + Sector::MESH_LAYERS; }
+		// level of detail, where the mesh has one cube per 2^lod blocks
+		int lod = 0;
+		// when the sector was queued for meshing, and if it was in view then
+		std::chrono::steady_clock::time_point queued;
+		bool inview = false;
     // absolute world position
     int getWX() const noexcept { return sector.wx; };
     int getWZ() const noexcept { return sector.wz; };
+		// the sector has been given new content since the job started,
+		// eg. by a seam transition or a teleport (any thread)
+		bool stale() const noexcept {
+			return sector.source->generation() != sector.generation;
+		}
 		// resulting mesh data
 		std::vector<vertex_t> datadump;
     // total amount of vertices for each shader line
     // DOES NOT EQUAL the size of the vertex datadump
     // due to terrain optimization stages
-    uint32_t vertices    [RenderConst::MAX_UNIQUE_SHADERS];
-    uint32_t bufferoffset[RenderConst::MAX_UNIQUE_SHADERS];
-		// resulting index data
-		//indice_t* indidump;
-		//indice_t indices           [RenderConst::MAX_UNIQUE_SHADERS];
+    uint32_t vertices    [RenderConst::MAX_UNIQUE_SHADERS] {};
+    uint32_t bufferoffset[RenderConst::MAX_UNIQUE_SHADERS] {};
+    // plain terrain cube faces, packed, for each shader line
+    std::vector<terrain_vertex_t> packeddump;
+    uint32_t packed      [RenderConst::MAX_UNIQUE_SHADERS] {};
+    uint32_t packedoffset[RenderConst::MAX_UNIQUE_SHADERS] {};
+    // instanced models, drawn on the 2-sided line
+    std::vector<model_instance_t> instancedump;
+    // number of indices for each shader line, into the shared quad index buffer
+    uint32_t indices      [RenderConst::MAX_UNIQUE_SHADERS] {};
+    uint32_t packedindices[RenderConst::MAX_UNIQUE_SHADERS] {};
 	};
 
 }
@@ -3,8 +3,9 @@
 #include <library/log.hpp>
 #include "compiler_scheduler.hpp"
 #include "gameconf.hpp"
-#include "lighting.hpp"
 #include "minimap.hpp"
+#include "pipeline.hpp"
+#include "player.hpp"
 #include "precomp_thread.hpp"
 #include "precompiler.hpp"
 #include "sectors.hpp"
@@ -12,6 +13,7 @@
 #include <algorithm>
 #include <mutex>
 #include <cassert>
+#include <cmath>
 //#define TIMING
 
 using namespace library;
@@ -19,97 +21,107 @@ using namespace library;
 namespace cppcraft
 {
 	PrecompQ precompq;
+	PrecompQ::~PrecompQ() = default;
 
-	void PrecompQ::add(Sector& sector)
+	void PrecompQ::add(Sector& sector, bool edited)
 	{
 		assert(sector.generated() == true);
-    // dont add if already added
-		if (sector.isUpdatingMesh()) return;
-    // dont add the edge to queue as its going to get auto-updated by seamless
-    if (sector.getX() < 2 || sector.getZ() < 2 || sector.getX() >= sectors.getXZ()-2 || sector.getZ() >= sectors.getXZ()-2)
-          return;
-
-    // Unfortunately we can't do a full check to see if the sector
-    // is completely ready for this queue.
-    // On the edge there are sectors that will "never"
-    // get their objects done, and so will never let their neighbors
-    // qualify for this queue. This happens rarely, but it *DOES* happen.
-
-    // We can at least check if the neighbors are generated:
-    bool at_least_generated = sectors.onNxN(sector, 1, // 3x3
-		[] (Sector& sect) { return sect.generated(); });
-    if (at_least_generated == false) return;
+    // dont add if already added, but an edit moves it up front
+		if (sector.isUpdatingMesh())
+		{
+			if (edited == false) return;
+			for (auto& job : queue)
+				if (job.sector == &sector) job.edited = true;
+			std::make_heap(queue.begin(), queue.end(), later);
+			return;
+		}
+    // until the sectors around it are lit, the dirty meshes wait,
+    // and the pipeline adds the sector once the last one is
+    if (Pipeline::meshReady(sector) == false) return;
 
 		sector.meshgen = true;
-		queue.push_back(&sector);
+		job_t job { &sector, edited, false, 0, clock::now() };
+		score(job);
+		queue.push_back(job);
+		std::push_heap(queue.begin(), queue.end(), later);
 	}
 
-	void PrecompQ::run()
+	void PrecompQ::score(job_t& job) const
 	{
-		if (!AsyncPool::available()) return;
+		const float dx = job.sector->getX() + 0.5f - player.pos.x / BLOCKS_XZ;
+		const float dz = job.sector->getZ() + 0.5f - player.pos.z / BLOCKS_XZ;
+		const float distance = sqrtf(dx*dx + dz*dz);
+		job.distance = distance;
+		// the sectors around the player, and those within a wide cone
+		// around the horizontal look direction, which also covers turning
+		static const float VIEW_COS = 0.34f; // 70 degrees
+		const float lookx =  sinf(player.rot.y);
+		const float lookz = -cosf(player.rot.y);
+		job.inview = distance < 1.5f || (dx * lookx + dz * lookz) > VIEW_COS * distance;
+	}
 
-    //std::sort(queue.begin(), queue.end(), GenerationOrder);
+	void PrecompQ::rescore()
+	{
+		// once the player has moved a quarter sector, or turned 10 degrees
+		const float dx = player.pos.x - score_x;
+		const float dz = player.pos.z - score_z;
+		const bool moved = dx*dx + dz*dz >= (BLOCKS_XZ / 4) * (BLOCKS_XZ / 4);
+		if (moved == false && turned(player.rot.y, score_rot, 0.17f) == false) return;
+		score_x = player.pos.x;
+		score_z = player.pos.z;
+		score_rot = player.rot.y;
+
+		for (auto& job : queue) score(job);
+		std::make_heap(queue.begin(), queue.end(), later);
+	}
+
+	AsyncPool::priority_t PrecompQ::priority(const job_t& job) noexcept
+	{
+		if (job.edited) return AsyncPool::EDIT;
+		return job.inview ? AsyncPool::VISIBLE : AsyncPool::BACKGROUND;
+	}
+
+	void PrecompQ::run()
+	{
+		updateLOD();
+		rescore();
 
 		// since we are the only ones that can take stuff
 		// from the available queue, we should be good to just
 		// check if there are any available, and thats it
-		for (auto it = queue.begin(); it != queue.end(); ++it)
+		while (!queue.empty())
 		{
-			Sector* sector = *it;
+			std::pop_heap(queue.begin(), queue.end(), later);
+			const job_t job = queue.back();
+			queue.pop_back();
+			Sector* sector = job.sector;
       assert(sector != nullptr);
 
       // -= try to clear out old shite =-
-  		// NOTE: there will always be sectors that cannot be finished
-  		// due to objects begin scheduled and not enough room to build them
-      if (sector->generated() == false ||
-          sector->isUpdatingMesh() == false ||
-          sector->getX() < 2 || sector->getZ() < 2 ||
-          sector->getX() >= sectors.getXZ()-2 ||
-          sector->getZ() >= sectors.getXZ()-2)
+      // a neighbor may have been regenerated since, and then
+      // the pipeline adds the sector again once it is lit
+      if (sector->isUpdatingMesh() == false || Pipeline::meshReady(*sector) == false)
       {
         sector->meshgen = false;
-        it = queue.erase(it);
         continue;
       }
 
-			// make sure we have proper light
-			bool is_ready = sectors.onNxN(*sector, 1, // 3x3
-			[] (Sector& sect)
-			{
-				if (sect.atmospherics == false)
-				{
-					if (sect.isReadyForAtmos() == false) { return false; }
-					#ifdef TIMING
-						Timer timer;
-					#endif
-					Lighting::atmosphericFlood(sect);
-					#ifdef TIMING
-						printf("Time spent in that goddamn atm flood: %f\n",
-							timer.getTime());
-					#endif
-          // flood takes some time, so lets not do more in one go
-					return false;
-				}
-        return sect.objects == 0;
-			});
-      // if not ready yet,
-			if (is_ready == false) {
-        // try next in queue
-        queue.splice(queue.end(), queue, it);
-        continue;
+			// check again that the scheduler wants more of these,
+			// and if not, the job keeps its place for the next round
+			if (!AsyncPool::accepts(priority(job))) {
+        queue.push_back(job);
+        std::push_heap(queue.begin(), queue.end(), later);
+        break;
       }
 
-			// check again that there are available slots
-			if (!AsyncPool::available()) break;
-
 			// finally, we can start the job
-			startJob(*sector);
-      it = queue.erase(it);
+			startJob(job);
 		}
 	}
 
-	void PrecompQ::startJob(Sector& sector)
+	void PrecompQ::startJob(const job_t& job)
 	{
+		Sector& sector = *job.sector;
 		// create new Precomp
 		//printf("Precompiler scheduling (%d, %d) size: %lu\n",
 		//	sector->getX(), sector->getZ(), sizeof(Precomp));
@@ -121,32 +133,135 @@ namespace cppcraft
       minimap.setUpdated();
     }
 
-    auto precomp = std::make_unique<Precomp> (sector);
+    // all the sub-meshes change when the level of detail does
+    const int lod = levelOfDetail(sector);
+    if (lod != sector.meshLOD)
+    {
+      sector.meshLOD = lod;
+      sector.dirtyMeshes = (1 << Sector::MESHES) - 1;
+    }
+
+    // one precomp for each dirty sub-mesh, all meshed in the same job
+    std::vector<std::unique_ptr<Precomp>> precomps;
+    for (int mesh = 0; mesh < Sector::MESHES; mesh++)
+    {
+      if (sector.dirtyMeshes & (1 << mesh))
+      {
+        precomps.push_back(acquire(sector, mesh));
+        precomps.back()->lod = lod;
+        precomps.back()->queued = job.queued;
+        precomps.back()->inview = job.inview;
+      }
+    }
+    sector.dirtyMeshes = 0;
+    if (precomps.empty()) return;
 
     // go go go!
-    AsyncPool::sched(
+    AsyncPool::sched(priority(job),
       AsyncPool::job_t::make_packed(
-      [pc = std::move(precomp)] () mutable
+      [jobs = std::move(precomps)] () mutable
       {
-        PrecompThread wset;
-  			// first stage: mesh generation
-  			wset.precompile(*pc);
-  			// second stage: AO
-  			wset.ambientOcclusion(*pc);
-
-  			/////////////////////////
-  			CompilerScheduler::add(std::move(pc));
-  			/////////////////////////
+        PrecompThread& wset = PrecompThread::local();
+        for (auto& pc : jobs)
+        {
+          // no need to mesh what the world has moved past
+          if (pc->stale()) {
+            pc->sector.release();
+            precompq.recycle(std::move(pc));
+            continue;
+          }
+    			// first stage: mesh generation
+    			wset.precompile(*pc);
+    			// second stage: AO
+    			wset.ambientOcclusion(*pc);
+          // third stage: packing what can be packed
+          if (gameconf.packed_vertices) wset.packTerrain(*pc);
+          // last stage: triangle indices
+          wset.createIndices(*pc);
+          // the blocks are no longer needed, let the sectors have them back
+          pc->sector.release();
 
-  			AsyncPool::release();
+    			/////////////////////////
+    			CompilerScheduler::add(std::move(pc));
+    			/////////////////////////
+        }
       }));
 	}
 
+  std::unique_ptr<Precomp> PrecompQ::acquire(Sector& sector, int mesh)
+  {
+    std::unique_ptr<Precomp> precomp;
+    {
+      std::lock_guard<std::mutex> lock(pool_mtx);
+      if (!pool.empty()) {
+        precomp = std::move(pool.back());
+        pool.pop_back();
+      }
+    }
+    if (precomp == nullptr) return std::make_unique<Precomp> (sector, mesh);
+    precomp->reset(sector, mesh);
+    return precomp;
+  }
+  void PrecompQ::recycle(std::unique_ptr<Precomp> precomp)
+  {
+    std::lock_guard<std::mutex> lock(pool_mtx);
+    if (pool.size() < POOL_SIZE) pool.push_back(std::move(precomp));
+  }
+
+  int PrecompQ::lodLevel(float distance)
+  {
+    int lod = 0;
+    for (int i = 0; i < Sector::LOD_LEVELS-1; i++)
+    {
+      if (gameconf.lod_distance[i] > 0 && distance > gameconf.lod_distance[i]) lod = i + 1;
+    }
+    return lod;
+  }
+  int PrecompQ::levelOfDetail(const Sector& sector) const
+  {
+    const float dx = sector.getX() + 0.5f - player.pos.x / BLOCKS_XZ;
+    const float dz = sector.getZ() + 0.5f - player.pos.z / BLOCKS_XZ;
+    const float distance = sqrtf(dx*dx + dz*dz);
+    // one sector of slack either way, so that walking
+    // along a boundary doesn't remesh the sectors on it
+    const int current = sector.meshLOD;
+    if (lodLevel(distance - 1.0f) > current) return lodLevel(distance - 1.0f);
+    if (lodLevel(distance + 1.0f) < current) return lodLevel(distance + 1.0f);
+    return current;
+  }
+  void PrecompQ::updateLOD()
+  {
+    // only once the player has moved half a sector
+    const float dx = player.pos.x - lod_x;
+    const float dz = player.pos.z - lod_z;
+    if (dx*dx + dz*dz < (BLOCKS_XZ / 2) * (BLOCKS_XZ / 2)) return;
+    lod_x = player.pos.x;
+    lod_z = player.pos.z;
+
+    for (int x = 2; x < sectors.getXZ()-2; x++)
+    for (int z = 2; z < sectors.getXZ()-2; z++)
+    {
+      Sector& sector = sectors(x, z);
+      if (sector.generated() && !sector.isUpdatingMesh() &&
+          levelOfDetail(sector) != sector.meshLOD) sector.updateAllMeshes();
+    }
+  }
+
   bool PrecompQ::contains(Sector& sector) const
   {
-    for (const auto* s : queue) {
+    for (const auto& job : queue) {
+      const auto* s = job.sector;
       if (s->getX() == sector.getX() && s->getZ() == sector.getZ()) return true;
     }
     return false;
   }
+
+  void PrecompQ::uploaded(const Precomp& precomp)
+  {
+    if (precomp.inview == false) return;
+    const std::chrono::duration<double, std::milli> time = clock::now() - precomp.queued;
+    m_upload_latency.count++;
+    m_upload_latency.total += time.count();
+    m_upload_latency.worst = std::max(m_upload_latency.worst, time.count());
+  }
 }
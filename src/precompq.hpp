@@ -1,8 +1,13 @@
 #ifndef PRECOMPQ_HPP
 #define PRECOMPQ_HPP
 
+#include "threadpool.hpp"
+#include <chrono>
+#include <cmath>
 #include <cstdint>
-#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace cppcraft
 {
@@ -11,8 +16,11 @@ namespace cppcraft
 
 	class PrecompQ {
 	public:
-		//! \brief Queues a sector for the mesh generator subsystem
-		void add(Sector& sector);
+		~PrecompQ();
+
+		//! \brief Queues a sector for the mesh generator subsystem,
+		//! ahead of the others when the player @edited its blocks
+		void add(Sector& sector, bool edited = false);
 
 		//! \brief executes one round of mesh generation scheduling
 		//! \warn  very time consuming, running N threads in parallell and waits for them to finish
@@ -26,12 +34,85 @@ namespace cppcraft
     // for debugging purposes
     bool contains(Sector&) const;
 
+		//! \brief the level of detail for sectors @distance sectors away
+		static int lodLevel(float distance);
+
+		//! \brief takes back a precomp once its mesh is uploaded, so that
+		//! the next job can reuse it without allocating new buffers
+		void recycle(std::unique_ptr<Precomp> precomp);
+
+		typedef std::chrono::steady_clock clock;
+		//! \brief how long the meshes of sectors in view took, from being
+		//! queued to being uploaded, in milliseconds (render thread)
+		//! \note does not include the time before the sector was queued,
+		//! such as generation and lighting, nor the wait for the next frame
+		struct latency_t
+		{
+			int64_t count = 0;
+			double  total = 0.0;
+			double  worst = 0.0;
+			double average() const noexcept { return count ? total / count : 0.0; }
+		};
+		const latency_t& uploadLatency() const noexcept { return m_upload_latency; }
+		//! \brief the mesh of @precomp is now uploaded (render thread)
+		void uploaded(const Precomp& precomp);
+
+		//! \brief a sector waiting for its meshes, ordered by priority: edits first,
+		//! then those in view, the nearest, and those that have waited longest
+		struct job_t
+		{
+			Sector* sector;
+			bool    edited;
+			bool    inview;
+			int     distance; // in whole sectors
+			clock::time_point queued;
+		};
+		//! \brief true if @a should be meshed after @b, as the heap order
+		static bool later(const job_t& a, const job_t& b) noexcept
+		{
+			if (a.edited != b.edited) return b.edited;
+			if (a.inview != b.inview) return b.inview;
+			if (a.distance != b.distance) return a.distance > b.distance;
+			return a.queued > b.queued;
+		}
+		//! \brief true if the look direction @rot is more than @limit radians
+		//! away from @scored, the shortest way around
+		static bool turned(float rot, float scored, float limit) noexcept
+		{
+			const float PI2 = 8 * atan(1);
+			return fabsf(remainderf(rot - scored, PI2)) >= limit;
+		}
+
 	private:
+		// the scheduler priority of the meshing job
+		static AsyncPool::priority_t priority(const job_t& job) noexcept;
+		// the priority of @job for the current view
+		void score(job_t& job) const;
+		// scores everything again, but only once the view has changed
+		void rescore();
+		// where the player was, and looked, when the queue was scored
+		float score_x = -1e9f, score_z = -1e9f, score_rot = -1e9f;
+
 		// starting a job is actually a little complicated
-		void startJob(Sector& sector);
+		void startJob(const job_t& job);
+		std::unique_ptr<Precomp> acquire(Sector& sector, int mesh);
+		// the level of detail to mesh @sector at, which only changes
+		// once the sector is well past a boundary
+		int levelOfDetail(const Sector& sector) const;
+		// remeshes the sectors that are at the wrong level of detail
+		void updateLOD();
+		// where the player was at the last level of detail update
+		float lod_x = -1e9f, lod_z = -1e9f;
+
+		// finished precomps, returned by the renderer and reused by the world
+		static const size_t POOL_SIZE = 32;
+		std::vector<std::unique_ptr<Precomp>> pool;
+		std::mutex pool_mtx;
+
+		// queue of sectors waiting for mesh generation, as a heap
+		std::vector<job_t> queue;
 
-		// queue of sectors waiting for mesh generation
-		std::list<Sector*> queue;
+		latency_t m_upload_latency;
 	};
 	extern PrecompQ precompq;
 }
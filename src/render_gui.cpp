@@ -4,6 +4,9 @@
 #include <library/opengl/window.hpp>
 #include "camera.hpp"
 #include "chat.hpp"
+#include "columns.hpp"
+#include "compiler_scheduler.hpp"
+#include "frame_budget.hpp"
 #include "game.hpp"
 #include "minimap.hpp"
 #include "generator/objectq.hpp"
@@ -20,9 +23,11 @@
 #include "player.hpp"
 #include "spiders.hpp"
 #include "generator.hpp"
+#include "pipeline.hpp"
 #include "precompq.hpp"
 #include "generator/terrain/terrains.hpp"
 #include "sun.hpp"
+#include "threadpool.hpp"
 
 using namespace library;
 
@@ -34,17 +39,29 @@ namespace cppcraft
   static nanogui::IntBox<size_t>* drawbox = nullptr;
   static nanogui::IntBox<size_t>* genbox = nullptr;
   static nanogui::IntBox<size_t>* prqbox = nullptr;
+  static nanogui::IntBox<size_t>* lightqbox = nullptr;
   static nanogui::IntBox<size_t>* objbox = nullptr;
   static nanogui::IntBox<size_t>* objretrybox = nullptr;
   // sector //
   static nanogui::IntBox<int>* sectlts = nullptr;
-  static nanogui::IntBox<int>* sectstage = nullptr;
+  static nanogui::TextBox* sectstage = nullptr;
   static nanogui::IntBox<int>* sectobjs = nullptr;
   static nanogui::IntBox<int>* sectatmos = nullptr;
 
   static nanogui::TextBox* trnbox = nullptr;
   static nanogui::IntBox<int>* skybox = nullptr;
   static nanogui::IntBox<int>* gndbox = nullptr;
+  // meshes, for each level of detail //
+  static std::array<nanogui::TextBox*, Sector::LOD_LEVELS> lodbox {};
+  // time from queued to uploaded, for meshes in view //
+  static nanogui::TextBox* latencybox = nullptr;
+  // scheduler queues, for each priority //
+  static std::array<nanogui::TextBox*, AsyncPool::PRIORITIES> taskbox {};
+  // results waiting for the world and render threads //
+  static nanogui::TextBox* genhandoffbox = nullptr;
+  static nanogui::TextBox* meshhandoffbox = nullptr;
+  // time budgets of the world stages, and the uploads //
+  static std::vector<nanogui::TextBox*> budgetboxes;
 
 	void GUIRenderer::init(Renderer& renderer)
 	{
@@ -93,6 +110,11 @@ namespace cppcraft
     prqbox->setEditable(false);
     prqbox->setFixedSize(Vector2i(100, 20));
 
+    new Label(main, "LightQ");
+    lightqbox = new nanogui::IntBox<size_t>(main);
+    lightqbox->setEditable(false);
+    lightqbox->setFixedSize(Vector2i(100, 20));
+
     new Label(main, "ObjectQ");
     objbox = new nanogui::IntBox<size_t>(main);
     objbox->setEditable(false);
@@ -129,10 +151,10 @@ namespace cppcraft
     sectlts->setEditable(false);
     sectlts->setFixedSize(Vector2i(50, 20));
 
-    new Label(sector, "Meshgen");
-    sectstage = new nanogui::IntBox<int>(sector);
+    new Label(sector, "Stage");
+    sectstage = new nanogui::TextBox(sector);
     sectstage->setEditable(false);
-    sectstage->setFixedSize(Vector2i(25, 20));
+    sectstage->setFixedSize(Vector2i(80, 20));
 
     new Label(sector, "Objects");
     sectobjs = new nanogui::IntBox<int>(sector);
@@ -144,6 +166,67 @@ namespace cppcraft
     sectatmos->setEditable(false);
     sectatmos->setFixedSize(Vector2i(25, 20));
 
+    // mesh stats, to see what the levels of detail save
+    auto* meshes = new Widget(stats);
+    meshes->setLayout(new BoxLayout(Orientation::Horizontal,
+                      Alignment::Middle, 0, 20));
+    new Label(meshes, "Meshes (vertices / KiB)");
+    for (int lod = 0; lod < Sector::LOD_LEVELS; lod++)
+    {
+      new Label(meshes, std::to_string(1 << lod) + "x");
+      lodbox[lod] = new nanogui::TextBox(meshes);
+      lodbox[lod]->setEditable(false);
+      lodbox[lod]->setFixedSize(Vector2i(140, 20));
+    }
+    new Label(meshes, "Queued to upload (ms)");
+    latencybox = new nanogui::TextBox(meshes);
+    latencybox->setEditable(false);
+    latencybox->setFixedSize(Vector2i(140, 20));
+
+    // scheduler queues, to see what waits behind what
+    auto* tasks = new Widget(stats);
+    tasks->setLayout(new BoxLayout(Orientation::Horizontal,
+                     Alignment::Middle, 0, 20));
+    new Label(tasks, "Jobs (queued / wait ms)");
+    static const char* PRIORITY_NAMES[AsyncPool::PRIORITIES] = {
+      "Edit", "Visible", "Generation", "Background"
+    };
+    for (int p = 0; p < AsyncPool::PRIORITIES; p++)
+    {
+      new Label(tasks, PRIORITY_NAMES[p]);
+      taskbox[p] = new nanogui::TextBox(tasks);
+      taskbox[p]->setEditable(false);
+      taskbox[p]->setFixedSize(Vector2i(100, 20));
+    }
+
+    // worker results, until they are picked up
+    auto* handoff = new Widget(stats);
+    handoff->setLayout(new BoxLayout(Orientation::Horizontal,
+                       Alignment::Middle, 0, 20));
+    new Label(handoff, "Handoff (avg / worst ms)");
+    new Label(handoff, "Terrain");
+    genhandoffbox = new nanogui::TextBox(handoff);
+    genhandoffbox->setEditable(false);
+    genhandoffbox->setFixedSize(Vector2i(100, 20));
+    new Label(handoff, "Meshes");
+    meshhandoffbox = new nanogui::TextBox(handoff);
+    meshhandoffbox->setEditable(false);
+    meshhandoffbox->setFixedSize(Vector2i(100, 20));
+
+    // the time budgets, and what they were spent on
+    auto* budgets = new Widget(stats);
+    budgets->setLayout(new BoxLayout(Orientation::Horizontal,
+                       Alignment::Middle, 0, 20));
+    new Label(budgets, "Budget (ms / spent / backlog)");
+    for (const FrameBudget* fb : {&worldbudget, &uploadbudget})
+    for (int i = 0; i < fb->stages(); i++)
+    {
+      new Label(budgets, fb->counters(i).name);
+      budgetboxes.push_back(new nanogui::TextBox(budgets));
+      budgetboxes.back()->setEditable(false);
+      budgetboxes.back()->setFixedSize(Vector2i(120, 20));
+    }
+
     stats->setPosition({0, 0});
     game.gui().screen()->performLayout();
 	}
@@ -188,28 +271,60 @@ namespace cppcraft
 
     genbox->setValue(Generator::size());
     prqbox->setValue(precompq.size());
+    lightqbox->setValue(Pipeline::size());
     objbox->setValue(terragen::ObjectQueue::size());
     objretrybox->setValue(terragen::ObjectQueue::retry_size());
 
     trnbox->setValue(plogic.terrain().name);
-    auto* sector = sectors.sectorAt(player.pos.x, player.pos.z);
-		if (sector)
     {
-      sectlts->setValue(sector->getLightCount());
-      sectstage->setValue(sector->isUpdatingMesh());
-      sectobjs->setValue(sector->objects);
-      sectatmos->setValue(sector->atmospherics);
-      // only show flatland values when generated
-      if (sector->generated())
+      // the player and the grid only move together under this lock
+      std::lock_guard<std::mutex> lock(mtx.playermove);
+      auto* sector = sectors.sectorAt(player.pos.x, player.pos.z);
+      if (sector)
       {
-        int x = int(player.pos.x);
-        int z = int(player.pos.z);
-        auto& flat = sector->flat()(x & (BLOCKS_XZ-1), z & (BLOCKS_XZ-1));
-        skybox->setValue(flat.skyLevel);
-        gndbox->setValue(flat.groundLevel);
+        sectlts->setValue(sector->shownLights);
+        sectstage->setValue(Pipeline::name((Pipeline::stage_t) sector->shownStage));
+        sectobjs->setValue(sector->objects);
+        sectatmos->setValue(sector->atmospherics);
+        // only show flatland values when generated
+        if (sector->generated())
+        {
+          int x = int(player.pos.x);
+          int z = int(player.pos.z);
+          auto& flat = sector->flat()(x & (BLOCKS_XZ-1), z & (BLOCKS_XZ-1));
+          skybox->setValue(flat.skyLevel);
+          gndbox->setValue(flat.groundLevel);
+        }
       }
     }
 
+    for (int lod = 0; lod < Sector::LOD_LEVELS; lod++)
+    {
+      const auto& st = columns.stats(lod);
+      lodbox[lod]->setValue(std::to_string(st.vertices) + " / " + std::to_string(st.bytes / 1024));
+    }
+    // average / worst
+    const auto& latency = precompq.uploadLatency();
+    latencybox->setValue(std::to_string(int(latency.average())) + " / " + std::to_string(int(latency.worst)));
+    for (int p = 0; p < AsyncPool::PRIORITIES; p++)
+    {
+      const auto st = AsyncPool::stats((AsyncPool::priority_t) p);
+      taskbox[p]->setValue(std::to_string(st.queued) + " / " + std::to_string(int(st.wait_ms)));
+    }
+    const auto gen = Generator::handoff();
+    genhandoffbox->setValue(std::to_string(int(gen.avg_ms)) + " / " + std::to_string(int(gen.worst_ms)));
+    const auto mesh = CompilerScheduler::stats();
+    meshhandoffbox->setValue(std::to_string(int(mesh.avg_ms)) + " / " + std::to_string(int(mesh.worst_ms)));
+    size_t box = 0;
+    for (const FrameBudget* fb : {&worldbudget, &uploadbudget})
+    for (int i = 0; i < fb->stages(); i++)
+    {
+      const auto c = fb->counters(i);
+      char buffer[64];
+      snprintf(buffer, sizeof(buffer), "%.1f / %.1f / %zu", c.budget_ms, c.spent_ms, c.backlog);
+      budgetboxes[box++]->setValue(buffer);
+    }
+
     /// render graphical interfaces ///
     game.gui().render();
 
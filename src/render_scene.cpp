@@ -4,6 +4,7 @@
 #include <library/opengl/fbo.hpp>
 #include <library/opengl/opengl.hpp>
 #include "camera.hpp"
+#include "columns.hpp"
 #include "drawq.hpp"
 #include "gameconf.hpp"
 #include "minimap.hpp"
@@ -17,7 +18,6 @@
 #include "renderconst.hpp"
 #include "sector.hpp"
 #include "shaderman.hpp"
-#include "spiders.hpp"
 #include "sun.hpp"
 #include "textureman.hpp"
 #include "threading.hpp"
@@ -175,9 +175,12 @@ namespace cppcraft
 		/// and recalculate rendering queue if necessary ///
 		////////////////////////////////////////////////////
 
-		//if (mtx.sectorseam.try_lock())
-		mtx.sectorseam.lock();
 		{
+			// the world thread moves the player and the world together, and
+			// the columns that came into view since the last frame are reset here
+			int moved_x = 0, moved_z = 0;
+			bool teleported = false;
+
 			mtx.playermove.lock();
 			{
 				//------------------------------------//
@@ -215,9 +218,8 @@ namespace cppcraft
 				this->playerSectorX = (int)playerPos.x / BLOCKS_XZ;
 				this->playerSectorZ = (int)playerPos.z / BLOCKS_XZ;
 
-				// underwater snapshot
-				Block blk = Spiders::testArea(playerPos.x, playerPos.y - camera.getZNear(), playerPos.z);
-				if (blk.isFluid())
+				// underwater snapshot, taken by the world thread
+				if (player.snap_eye.isFluid())
 				{
 					//if (blockID == _WATER)
 						this->underwater = 1;
@@ -233,9 +235,25 @@ namespace cppcraft
 				// or something new has shown up and we need to force-update
 				frustumRecalc = (dist > 0.01) || camera.recalc;
 				camera.recalc = false;
+
+				/// world coordinate snapshots ///
+				moved_x = world.getWX() - this->snapWX;
+				moved_z = world.getWZ() - this->snapWZ;
+				teleported = world.teleports() != this->m_teleports;
+				this->snapWX = world.getWX();
+				this->snapWZ = world.getWZ();
+				const auto delta = world.getDelta();
+				this->m_delta_x = delta.x;
+				this->m_delta_z = delta.z;
+				this->m_teleports = world.teleports();
 			}
 			mtx.playermove.unlock();
 
+			if (teleported)
+				columns.resetAll();
+			else if (moved_x || moved_z)
+				columns.moved(moved_x, moved_z, m_delta_x, m_delta_z);
+
 			if (frustumRecalc)
 			{
 				/// update matview matrix using player snapshot ///
@@ -243,12 +261,6 @@ namespace cppcraft
 				reflectionCamera.setWorldOffset(playerPos.x, playerPos.y, playerPos.z);
 			}
 
-			/// world coordinate snapshots ///
-			this->snapWX = world.getWX();
-			this->snapWZ = world.getWZ();
-      this->m_delta_x = world.getDeltaX();
-			this->m_delta_z = world.getDeltaZ();
-
 			/// update minimap ///
 			minimap.update(playerPos.x, playerPos.z);
 
@@ -303,7 +315,6 @@ namespace cppcraft
 					camera.needsupd = 2;
 				}
 			}
-			mtx.sectorseam.unlock();
 		}
 
 		// compress rendering queue to minimal size by occlusion culling
@@ -5,6 +5,12 @@
 **/
 #pragma once
 #include <glm/vec3.hpp>
+#include <vector>
+
+namespace library
+{
+	class Shader;
+}
 
 namespace cppcraft
 {
@@ -43,6 +49,7 @@ namespace cppcraft
 		int playerSectorX, playerSectorZ;
 		int snapWX = 0, snapWZ = 0;
     int m_delta_x = 0, m_delta_z = 0;
+    int m_teleports = 0;
 		bool playerMoved = true;
 		char underwater = 0;
 
@@ -65,7 +72,10 @@ namespace cppcraft
 		void renderSceneWater();
 
     static void renderColumn(Column*, int i);
+    static void renderPackedColumn(Column*, int i);
     void renderColumnSet(int i);
+    static void renderPackedSet(library::Shader&, const std::vector<Column*>&, int i);
+    static void renderInstancedSet(library::Shader&, const std::vector<Column*>&, int i);
 
 		friend class SkyRenderer;
 		friend class GUIRenderer;
@@ -58,21 +58,18 @@ namespace cppcraft
 		}
 		else if (plogic.Ladderized)
 		{
-			if (plogic.block)
+			// determine what block we are standing on
+			if (plogic.block.isLadder() || plogic.block.isAir())
 			{
-				// determine what block we are standing on
-				if (plogic.block->isLadder() || plogic.block->isAir())
-				{
-					// ladder, air --> ladder
-					LADDER_CAMERA_DEV();
-					deviating = true;
-				}
-				else
-				{
-					// something else --> normal
-					NORMAL_CAMERA_DEV();
-					deviating = true;
-				}
+				// ladder, air --> ladder
+				LADDER_CAMERA_DEV();
+				deviating = true;
+			}
+			else
+			{
+				// something else --> normal
+				NORMAL_CAMERA_DEV();
+				deviating = true;
 			}
 		}
 		else if (motionTimed != 0)
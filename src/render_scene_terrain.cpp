@@ -156,11 +156,28 @@ namespace cppcraft
     m_buffer_texture->upload(m_bt_data.get(), columns.size() * 3 * sizeof(float));
 	}
 
+	// indexed triangles, two per quad, using the shared quad index buffer
+	static inline void drawQuads(uint32_t first, uint32_t count)
+	{
+		quad_indices::draws(first, count,
+		[] (uint32_t n, uint32_t basevertex) {
+			glDrawElementsBaseVertex(GL_TRIANGLES, n, GL_UNSIGNED_SHORT, nullptr, basevertex);
+		});
+	}
+
 	void SceneRenderer::renderColumn(Column* cv, int i)
 	{
+		if (cv->indices[i] == 0) return;
 		glBindVertexArray(cv->vao);
-		//glDrawElements(GL_TRIANGLES, cv->indices[i], GL_UNSIGNED_SHORT, (GLvoid*) (intptr_t) cv->indexoffset[i]);
-		glDrawArrays(GL_QUADS, cv->bufferoffset[i], cv->vertices[i]);
+		drawQuads(cv->bufferoffset[i], cv->indices[i]);
+	}
+	void SceneRenderer::renderPackedColumn(Column* cv, int i)
+	{
+		if (cv->packedindices[i] == 0) return;
+		glBindVertexArray(cv->pvao);
+		// packed vertices don't carry the column index
+		glVertexAttrib4f(0, 0.0f, 0.0f, 0.0f, (float) cv->index());
+		drawQuads(cv->packedoffset[i], cv->packedindices[i]);
 	}
 
 	void SceneRenderer::renderColumnSet(int i)
@@ -171,6 +188,32 @@ namespace cppcraft
 			renderColumn(column, i);
 		}
 	}
+	void SceneRenderer::renderPackedSet(Shader& shd, const std::vector<Column*>& queue, int i)
+	{
+		if (i != RenderConst::TX_REPEAT && i != RenderConst::TX_SOLID) return;
+		shd.sendInteger("packedVertices", 1);
+		for (auto* column : queue)
+		{
+			renderPackedColumn(column, i);
+		}
+		shd.sendInteger("packedVertices", 0);
+	}
+
+	void SceneRenderer::renderInstancedSet(Shader& shd, const std::vector<Column*>& queue, int i)
+	{
+		if (i != RenderConst::TX_TRANS_2SIDED) return;
+		shd.sendInteger("instancedModels", 1);
+		for (auto* cv : queue)
+		{
+			if (cv->instances == 0) continue;
+			glBindVertexArray(cv->ivao);
+			glVertexAttrib4f(0, 0.0f, 0.0f, 0.0f, (float) cv->index());
+			// the two quads of a cross, for every instance
+			glDrawElementsInstanced(GL_TRIANGLES, 2 * quad_indices::PER_QUAD,
+			                        GL_UNSIGNED_SHORT, nullptr, cv->instances);
+		}
+		shd.sendInteger("instancedModels", 0);
+	}
 
 	void handleSceneUniforms(
 			double frameCounter,
@@ -270,6 +313,8 @@ namespace cppcraft
 
 			// render it all
 			renderColumnSet(i);
+			renderPackedSet(shaderman[Shaderman::STD_BLOCKS], drawq[i], i);
+			renderInstancedSet(shaderman[Shaderman::ALPHA_BLOCKS], drawq[i], i);
 
 		} // next shaderline
 	}
@@ -321,6 +366,8 @@ namespace cppcraft
 			{
 				renderColumn(cv, i);
 			}
+			renderPackedSet(shaderman[Shaderman::BLOCKS_REFLECT], reflectionq[i], i);
+			renderInstancedSet(shaderman[Shaderman::BLOCKS_REFLECT], reflectionq[i], i);
 		} // next shaderline
 
 	} // renderReflectedScene()
@@ -82,6 +82,18 @@ namespace cppcraft
 		glColorMask(1, 1, 1, 1);
 	}
 
+	// the sun as it is placed on the sky, which is the only part of it
+	// that needs the camera, so it lives here with the rest of the sky
+	glm::mat4 SunClass::getSunMatrix() const
+	{
+		glm::mat4 mattemp = rotationMatrix(0.0f, float(-PI / 2.0), 0.0f);
+		glm::mat4 matsun = rotationMatrix(thesun.getRealtimeRadianAngle(), 0.0, 0.0);
+		mattemp *= matsun;
+		mattemp *= glm::translate(glm::vec3(0.f, 0.f, -thesun.renderDist));
+		
+		return camera.getRotationMatrix() * mattemp;
+	}
+
 	void SkyRenderer::renderSun()
 	{
 		//if ogl.lastsun(1) < -0.15 then return
@@ -8,12 +8,9 @@
 
 #include "seamless.hpp"
 
-#include "columns.hpp"
-#include "camera.hpp"
 #include "generator.hpp"
 #include "minimap.hpp"
 #include "player.hpp"
-#include "precompq.hpp"
 #include "sectors.hpp"
 #include "threading.hpp"
 #include "world.hpp"
@@ -67,7 +64,9 @@ namespace cppcraft
 	public:
 		static void resetSectorColumn(Sector& sector)
   	{
-  		// we have to load new block content
+  		// we have to load new block content, and the jobs
+  		// for what it was before are now stale
+  		sector.nextGeneration();
   		sector.gen_flags = 0;
   		// add to generator queue
   		Generator::add(sector);
@@ -78,11 +77,26 @@ namespace cppcraft
 
   		// if the sector was generated, we will regenerate mesh
   		if (sector.generated() && sector.isUpdatingMesh() == false)
-          precompq.add(sector);
+          sector.updateAllMeshes();
 
   	} // updateSectorColumn
 	};
 
+	void Seamless::shift(int dx, int dz)
+	{
+		// the sectors and columns are ring buffers rotated by the world delta,
+		// so this is all it takes to move them. The renderer takes the player
+		// and the world position together, and resets the new columns on its own
+		std::lock_guard<std::mutex> lock(mtx.playermove);
+		player.pos.x -= dx * Sector::BLOCKS_XZ;
+		player.pos.z -= dz * Sector::BLOCKS_XZ;
+		player.snap_pos.x -= dx * Sector::BLOCKS_XZ;
+		player.snap_pos.z -= dz * Sector::BLOCKS_XZ;
+		world.worldCoords.x += dx;
+		world.worldCoords.z += dz;
+		world.increaseDelta(dx, dz);
+	}
+
 	// big huge monster function
 	bool Seamless::seamlessness()
 	{
@@ -92,80 +106,36 @@ namespace cppcraft
 		// if player is beyond negative seam offset point on x axis
 		if (player.pos.x <= halfworld - Seamless::OFFSET)
 		{
-			mtx.sectorseam.lock();
+			// move player forward one sector, and offset world x by -1
+			shift(-1, 0);
 
-			// move player forward one sector (in blocks)
-			player.pos.x += Sector::BLOCKS_XZ;
-			player.snap_pos.x += Sector::BLOCKS_XZ;
-			// offset world x by -1
-			world.worldCoords.x -= 1;
-			world.increaseDelta(-1, 0);
-
-			// only 25% left on the negative side
+			// the sectors at the end of the x-axis are now the first ones
 			for (int z = 0; z < sectors.getXZ(); z++)
 			{
-				// remember old sector, at the end of x-axis
-				auto oldpointer = sectors.extract(sectors.getXZ()-1, z);
-
-				// move forward on the x-axis
-				for (int x = sectors.getXZ() - 1; x >= 1; x--)
-				{
-					// move sector columns on x
-					sectors.replace(x,z, x-1,z);
-				}
-
-				// set first column on x-axis to old pointer
-        sectors.emplace(0, z, std::move(oldpointer));
-
 				// reset it completely
 				Seamstress::resetSectorColumn(sectors(0, z));
 				// flag neighboring sector as dirty, if necessary
 				Seamstress::updateSectorColumn(EDGE_NO, z);
 
-				// reset edge columns
-				columns(0, z, world.getDeltaX(), world.getDeltaZ()).reset();
-
 			} // sectors z
-			mtx.sectorseam.unlock();
       // minimap rollover +x
 			minimap.roll(-1, 0);
 			returnvalue = true;
 		}
 		else if (player.pos.x >= halfworld + Seamless::OFFSET)
 		{
-			mtx.sectorseam.lock();
-
-			// move player back one sector (in blocks)
-			player.pos.x -= Sector::BLOCKS_XZ;
-			player.snap_pos.x -= Sector::BLOCKS_XZ;
-			// offset world x by +1
-			world.worldCoords.x += 1;
-			world.increaseDelta(1, 0);
+			// move player back one sector, and offset world x by +1
+			shift(1, 0);
 
-			// only 25% left on the positive side
+			// the first sectors on the x-axis are now at the end of it
 			for (int z = 0; z < sectors.getXZ(); z++)
 			{
-				// remember first sector on x-axis
-				auto oldpointer = sectors.extract(0, z);
-
-				for (int x = 0; x < sectors.getXZ()-1; x++)
-				{
-					sectors.replace(x,z, x+1,z);
-				}
-
-				// move oldpointer-sector to end of x-axis
-        sectors.emplace(sectors.getXZ()-1, z, std::move(oldpointer));
-
 				// reset sector completely
 				Seamstress::resetSectorColumn(sectors(sectors.getXZ()-1, z));
 				// update neighbor
 				Seamstress::updateSectorColumn(sectors.getXZ()-1-EDGE_NO, z);
 
-				// reset edge columns
-				columns(sectors.getXZ()-1, z, world.getDeltaX(), world.getDeltaZ()).reset();
-
 			} // sectors z
-		  mtx.sectorseam.unlock();
       // minimap rollover -x
 			minimap.roll(1, 0);
 			returnvalue = true;
@@ -176,76 +146,36 @@ namespace cppcraft
 
 		if (player.pos.z <= halfworld - Seamless::OFFSET)
 		{
-			mtx.sectorseam.lock();
-
-			// offset player +z
-			player.pos.z += Sector::BLOCKS_XZ;
-			player.snap_pos.z += Sector::BLOCKS_XZ;
-			// offset world -z
-			world.worldCoords.z -= 1;
-			world.increaseDelta(0, -1);
+			// offset player +z, and world -z
+			shift(0, -1);
 
-			// only 25% left on the negative side
+			// the sectors at the end of the z-axis are now the first ones
 			for (int x = 0; x < sectors.getXZ(); x++)
 			{
-				// recursively move the sector
-				auto oldpointer = sectors.extract(x, sectors.getXZ()-1);
-
-				for (int z = sectors.getXZ()-1; z >= 1; z--)
-				{
-					sectors.replace(x,z,  x,z-1);
-				}
-				// move old pointer to beginning of z axis
-        sectors.emplace(x, 0, std::move(oldpointer));
-
-				// reset oldpointer column
+				// reset the new edge
 				Seamstress::resetSectorColumn(sectors(x, 0));
 				// only need to update 1 row for Z
 				Seamstress::updateSectorColumn(x, EDGE_NO);
 
-				// reset edge columns
-				columns(x, 0, world.getDeltaX(), world.getDeltaZ()).reset();
-
 			} // sectors x
-			mtx.sectorseam.unlock();
       // minimap rollover +z
 			minimap.roll(0, -1);
 			return true;
 		}
 		else if (player.pos.z >= halfworld + Seamless::OFFSET)
 		{
-			mtx.sectorseam.lock();
-
-			// move player backward on the Z axis
-			player.pos.z -= Sector::BLOCKS_XZ;
-			player.snap_pos.z -= Sector::BLOCKS_XZ;
-			// move world forward on the Z axis
-			world.worldCoords.z += 1;
-			world.increaseDelta(0, 1);
+			// move player backward on the Z axis, and the world forward
+			shift(0, 1);
 
-			// move sectors forwards +z (and rollback last line)
+			// the first sectors on the z-axis are now at the end of it
 			for (int x = 0; x < sectors.getXZ(); x++)
 			{
-				auto oldpointer = sectors.extract(x, 0);
-
-				// recursively move sectors
-				for (int z = 0; z < sectors.getXZ()-1; z++)
-				{
-					sectors.replace(x,z, x,z+1);
-				}
-				// move sector to end of z axis
-        sectors.emplace(x, sectors.getXZ()-1, std::move(oldpointer));
-
-				// reset oldpointer column
+				// reset the new edge
 				Seamstress::resetSectorColumn(sectors(x, sectors.getXZ()-1));
 				// only need to update 1 row for Z
 				Seamstress::updateSectorColumn(x, sectors.getXZ()-1-EDGE_NO);
 
-				// reset edge columns
-				columns(x, sectors.getXZ()-1, world.getDeltaX(), world.getDeltaZ()).reset();
-
 			} // sectors x
-			mtx.sectorseam.unlock();
       // minimap rollover -z
 			minimap.roll(0, 1);
 			return true;
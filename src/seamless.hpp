@@ -15,6 +15,8 @@ namespace cppcraft
 
 	private:
 		static bool seamlessness();
+		// moves the player and the world by (dx, dz) sectors
+		static void shift(int dx, int dz);
 	};
 
 }
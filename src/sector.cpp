@@ -4,6 +4,7 @@
 #include "precompq.hpp"
 #include "sectors.hpp"
 #include "world.hpp"
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <cmath>
@@ -12,14 +13,25 @@ using namespace library;
 
 namespace cppcraft
 {
+	// the grid is a ring buffer, which is rotated by the world delta
+	int Sector::getX() const noexcept
+	{
+		const int x = this->slot_x - world.getDeltaX();
+		return (x >= 0) ? x : x + sectors.getXZ();
+	}
+	int Sector::getZ() const noexcept
+	{
+		const int z = this->slot_z - world.getDeltaZ();
+		return (z >= 0) ? z : z + sectors.getXZ();
+	}
 	// returns the world absolute coordinates for this sector X and Z
 	int Sector::getWX() const
 	{
-		return world.getWX() + this->x;
+		return world.getWX() + getX();
 	}
 	int Sector::getWZ() const
 	{
-		return world.getWZ() + this->z;
+		return world.getWZ() + getZ();
 	}
 
 	float Sector::distanceTo(const Sector& sector, int bx, int bz) const
@@ -41,20 +53,37 @@ namespace cppcraft
 	}
 	void Sector::updateAllMeshes()
 	{
+		this->dirtyMeshes = (1 << MESHES) - 1;
+		precompq.add(*this);
+	}
+	void Sector::updateMeshes(uint16_t mask)
+	{
+		this->dirtyMeshes |= mask;
 		precompq.add(*this);
 	}
 
   void Sector::clear()
   {
-    for (auto& bl : m_blocks->b)
+    auto& blocks = getBlocks();
+    for (auto& bl : blocks.b)
         bl = Block(_AIR, 0, 0, 15);
+    blocks.clearTorchColors();
     this->gen_flags = GENERATED;
     this->objects   = 0;
     this->atmospherics = false;
   }
 
+  void Sector::detach()
+  {
+    // a mesh job is still reading the old blocks, so write to a copy
+    auto blocks = std::make_shared<sectorblock_t> (*m_blocks);
+    blocks->next_version();
+    m_blocks = std::move(blocks);
+  }
+
 	void Sector::regenerate()
 	{
+		nextGeneration();
 		gen_flags    = 0;
 		objects      = 0;
 		atmospherics = false;
@@ -4,6 +4,8 @@
 #include <common.hpp>
 #include <sectorblock.hpp>
 #include "flatland.hpp"
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
@@ -15,9 +17,16 @@ namespace cppcraft
 		// sector size constants
 		static const int BLOCKS_XZ = cppcraft::BLOCKS_XZ;
 		static const int BLOCKS_Y  = cppcraft::BLOCKS_Y;
+		// the mesh is split into vertical sub-meshes of MESH_LAYERS each,
+		// which are rebuilt and culled independently
+		static const int MESH_LAYERS = 32;
+		static const int MESHES = BLOCKS_Y / MESH_LAYERS;
+		// distant sectors are meshed with 1, 2 or 4 blocks per cube
+		static const int LOD_LEVELS = 3;
 
 		static const int GENERATED  = 0x1;
 		static const int GENERATING = 0x2;
+		static const int LIGHTING   = 0x4; // waiting for its atmospheric flood
     static const int MINIMAP    = 0x8;
 
 		struct sectordata_t
@@ -40,19 +49,16 @@ namespace cppcraft
 			std::unordered_map<uint16_t, void*> data;
 		};
 
-		// creates a sector with location (x, z)
-		Sector(int xx, int zz) : x(xx), z(zz)
+		// creates a sector in the slot (x, z) of the grid
+		Sector(int xx, int zz) : slot_x(xx), slot_z(zz)
     {
-      m_blocks =  std::make_unique<sectorblock_t> ();
+      m_blocks =  std::make_shared<sectorblock_t> ();
     }
 
-		// returns the local coordinates for this sector X and Z
-		int getX() const noexcept {
-			return this->x;
-		}
-		int getZ() const noexcept {
-			return this->z;
-		}
+		// returns the local coordinates for this sector X and Z, which
+		// change as the world moves while the sector stays in its slot
+		int getX() const noexcept;
+		int getZ() const noexcept;
 		// returns the world absolute coordinates for this sector X and Z
 		int getWX() const;
 		int getWZ() const;
@@ -78,17 +84,35 @@ namespace cppcraft
 		// that are already properly generated, or on an edge
 		bool isReadyForAtmos() const;
 
-		// update relevant parts of this sectors mesh
+		// update all of this sectors mesh
 		void updateAllMeshes();
+		// update the sub-meshes that can see the blocks in layers [y0, y1]
+		void updateMeshes(int y0, int y1) {
+			updateMeshes(meshMask(y0, y1));
+		}
+		void updateMesh(int y) {
+			updateMeshes(y, y);
+		}
+		// update the sub-meshes in the mask, as collected by meshMask()
+		void updateMeshes(uint16_t mask);
+		// the sub-meshes that can see the blocks in layers [y0, y1], since the
+		// faces, AO and smooth lighting of the neighboring blocks can change too
+		static uint16_t meshMask(int y0, int y1) noexcept
+		{
+			const int m0 = std::max(y0 - 1, 0) / MESH_LAYERS;
+			const int m1 = std::min(y1 + 1, BLOCKS_Y-1) / MESH_LAYERS;
+			return ((1 << (m1 + 1)) - 1) & ~((1 << m0) - 1);
+		}
 
-		// returns reference to a Block at (x, y, z)
+		// returns reference to a Block at (x, y, z), where only the
+		// non-const one is for writing and makes the blocks writable
 		const Block& operator() (int x, int y, int z) const
 		{
 			return m_blocks->operator()(x, y, z);
 		}
 		Block& operator() (int x, int y, int z)
 		{
-			return m_blocks->operator()(x, y, z);
+			return writable()(x, y, z);
 		}
 		// returns a reference to the special section, if one exists
 		// otherwise, GOD HELP US ALL
@@ -109,15 +133,29 @@ namespace cppcraft
 		// distance to another sector (in block units)
 		float distanceTo(const Sector& sector, int bx, int bz) const;
 
-		sectorblock_t& getBlocks()
+		// the blocks, for reading
+		const sectorblock_t& blocks() const
 		{
       assert(m_blocks != nullptr);
 			return *m_blocks;
 		}
+		// the blocks, for writing (moves on to a copy while a snapshot is held)
+		sectorblock_t& getBlocks()
+		{
+      assert(m_blocks != nullptr);
+			return writable();
+		}
 		void assignBlocks(std::unique_ptr<sectorblock_t> blocks)
 		{
 			this->m_blocks = std::move(blocks); // in with the new
 		}
+		// an immutable view of the blocks as they are now, for other threads.
+		// it stays the same until it is released, as the next write to
+		// the blocks makes the sector move on to a copy (with a new version)
+		std::shared_ptr<const sectorblock_t> snapshot() const
+		{
+			return m_blocks;
+		}
 
 		std::string to_string() const
 		{
@@ -133,6 +171,12 @@ namespace cppcraft
 
     // make this sector use Generator (delayed)
     void regenerate();
+		// changes each time the sector is given new content, so that the
+		// jobs started before can tell that they are stale (any thread)
+		uint32_t generation() const noexcept
+		{
+			return m_generation.load(std::memory_order_acquire);
+		}
 
 		bool generated() const noexcept
 		{
@@ -153,8 +197,28 @@ namespace cppcraft
     }
 
 	private:
-		// blocks
-		std::unique_ptr<sectorblock_t> m_blocks = nullptr;
+		static_assert(BLOCKS_Y % MESH_LAYERS == 0 && MESHES <= 16,
+		              "The sub-meshes must cover the sector, and fit in the dirty mask");
+		static_assert(MESH_LAYERS % (1 << (LOD_LEVELS-1)) == 0 && BLOCKS_XZ % (1 << (LOD_LEVELS-1)) == 0,
+		              "The sub-meshes must be whole cells at every level of detail");
+
+		sectorblock_t& writable()
+		{
+			// only a snapshot would be holding a reference
+			if (UNLIKELY(m_blocks.use_count() > 1)) detach();
+			// the reader that let go of its snapshot must be done with it
+			else std::atomic_thread_fence(std::memory_order_acquire);
+			return *m_blocks;
+		}
+		void detach();
+		// the content of the sector is about to be replaced
+		void nextGeneration() noexcept
+		{
+			m_generation.fetch_add(1, std::memory_order_release);
+		}
+
+		// blocks, shared with snapshots
+		std::shared_ptr<sectorblock_t> m_blocks = nullptr;
 		// data section
 		std::unique_ptr<sectordata_t> datasect = nullptr;
 		// 2d data (just a container!)
@@ -168,16 +232,24 @@ namespace cppcraft
 		uint8_t gen_flags = 0;
 		// non-zero when objects are scheduled directly on this sector
 		uint8_t objects = 0;
-    // 8 bits to signify which parts of sector needs update
 		// when an update is needed,
 		bool meshgen = false;
+		// 1 bit for each sub-mesh that needs to be rebuilt
+		uint16_t dirtyMeshes = 0;
+		// the level of detail of the current mesh
+		uint8_t meshLOD = 0;
 
 		// we flooded this with light, or it needs flooding if the player looks at it?
 		bool atmospherics = false;
+		// the light count and pipeline stage for the stats window, copied by
+		// the world thread, so that the renderer never reads the blocks
+		uint16_t shownLights = 0;
+		uint8_t  shownStage  = 0;
 
   private:
-		// grid position
-		int x, z;
+		// position in the ring buffer of the grid
+		int slot_x, slot_z;
+		std::atomic<uint32_t> m_generation {0};
 	};
 }
 
@@ -51,8 +51,10 @@ namespace cppcraft
 	{
     for (auto& sector : sectors)
 		{
-			// clear generated flag and add to generator queue
-			sector->gen_flags &= ~1;
+			// clear the flags, which drops the jobs in flight,
+			// and add to generator queue
+			sector->nextGeneration();
+			sector->gen_flags = 0;
 			Generator::add(*sector);
 		}
 	}
@@ -3,6 +3,8 @@
 
 #include "sector.hpp"
 #include "delegate.hpp"
+#include "world.hpp"
+#include <vector>
 
 namespace cppcraft
 {
@@ -45,49 +47,31 @@ namespace cppcraft
 		//! the result @bool is only true when all results are true
     bool onNxN(const Sector&, int size, delegate<bool(Sector&)> lambda);
 
-		// updates all sectors, for eg. when sun-position changed
+		// remeshes all sectors, for eg. when the block textures changed
 		void updateAll();
 		// regenerate all sectors, for eg. teleport
 		void regenerateAll();
 
 	private:
-		// returns a pointer to the sector at (x, z)
+		// returns a pointer to the sector at (x, z), which is in the slot
+		// that the world delta has rotated it to. (x, z) may be up to one
+		// grid outside on either side, and wraps around to the other edge
 		inline Sector* getSector(int x, int z)
 		{
+			const auto delta = world.getDelta();
+			x += delta.x;
+			if (x >= sectors_XZ) x -= sectors_XZ; else if (x < 0) x += sectors_XZ;
+			z += delta.z;
+			if (z >= sectors_XZ) z -= sectors_XZ; else if (z < 0) z += sectors_XZ;
 			return this->sectors.at(x * sectors_XZ + z).get();
 		}
-		// returns a reference to a pointer to a sector, which is ONLY used by Seamless
-		inline auto& getSectorRef(int x, int z)
-		{
-			return this->sectors[x * sectors_XZ + z];
-		}
-
-    // replace sector (x, z) with (x2, z2)
-		inline void replace(int x, int z, int x2, int z2)
-		{
-      auto& dest = getSectorRef(x2, z2);
-      // move to new position
-      dest->x = x;
-			dest->z = z;
-			getSectorRef(x, z) = std::move(dest);
-		}
-    inline auto extract(int x, int z)
-    {
-      return std::move(getSectorRef(x, z));
-    }
-    inline void emplace(int x, int z, std::unique_ptr<Sector> sector)
-		{
-      sector->x = x;
-			sector->z = z;
-			getSectorRef(x, z) = std::move(sector);
-		}
 
-		// 3d and 2d data containers
+		// 3d and 2d data containers, as a ring buffer on both axes. A seam
+		// transition only moves the world delta, and the row of sectors that
+		// fell off one edge is now the row on the opposite edge
 		std::vector<std::unique_ptr<Sector>> sectors;
 		// sectors XZ-axes size
 		int sectors_XZ = 0;
-
-		friend class Seamless;
 	};
 	extern Sectors sectors;
 
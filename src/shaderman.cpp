@@ -40,6 +40,10 @@ namespace cppcraft
 		{
 			text += " = " + std::to_string(WATERLEVEL) + ".0;";
 		}
+		else if (text == "const float BLOCKS_Y")
+		{
+			text += " = " + std::to_string(BLOCKS_Y) + ".0;";
+		}
 		// settings
 		else if (text == "#define POSTPROCESS")
 		{
@@ -68,7 +72,10 @@ namespace cppcraft
 		linkstage.emplace_back("in_texture");
 		linkstage.emplace_back("in_biome");
     linkstage.emplace_back("in_data1");
-    linkstage.emplace_back("in_data2");
+    linkstage.emplace_back("in_lightcolor");
+    linkstage.emplace_back("in_packed");
+    linkstage.emplace_back("in_instance");
+    linkstage.emplace_back("in_instcolor");
 
 		// block shaders
 		for (int i = 0; i < 8; i++)
@@ -11,25 +11,25 @@ namespace cppcraft
 	// _AIR block with max lighting
 	Block air_block(_AIR);
 
-	Block& Spiders::getBlock(int x, int y, int z)
+	const Block& Spiders::getBlock(int x, int y, int z)
 	{
-		Sector* ptr = wrap(x, y, z);
+		const Sector* ptr = wrap(x, y, z);
 		if (ptr) {
 			return ptr[0](x, y, z);
 		}
 		return air_block;
 	}
 
-	Block& Spiders::getBlock(Sector& s, int x, int y, int z)
+	const Block& Spiders::getBlock(Sector& s, int x, int y, int z)
 	{
-		Sector* ptr = Spiders::wrap(s, x, y, z);
+		const Sector* ptr = Spiders::wrap(s, x, y, z);
 		if (ptr) {
 			return ptr[0](x, y, z);
 		}
 		return air_block;
 	}
 
-	Block& Spiders::getBlock(float x, float y, float z, float size)
+	const Block& Spiders::getBlock(float x, float y, float z, float size)
 	{
 		// make damn sure!
 		if (y < 0.0f) return air_block;
@@ -42,7 +42,7 @@ namespace cppcraft
 		for (dz = z-size; dz <= z+size; dz += size)
 		for (dx = x-size; dx <= x+size; dx += size)
 		{
-			Block& b = getBlock(int(dx), by, int(dz));
+			const Block& b = getBlock(int(dx), by, int(dz));
 			if (b.getID())
 			{
 				float fx = dx - int(dx);
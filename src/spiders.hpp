@@ -9,10 +9,10 @@ namespace cppcraft
 {
 	class Spiders {
 	public:
-		// various block getters
-		static Block& getBlock(int x, int y, int z);
-		static Block& getBlock(Sector&, int x, int y, int z);
-		static Block& getBlock(float x, float y, float z, float size_xz);
+		// various block getters, for reading (use setBlock and friends to modify)
+		static const Block& getBlock(int x, int y, int z);
+		static const Block& getBlock(Sector&, int x, int y, int z);
+		static const Block& getBlock(float x, float y, float z, float size_xz);
 
 		// converts a position (x, y, z) to an explicit in-system position
 		// returns false if the position would become out of bounds (after conversion)
@@ -30,7 +30,7 @@ namespace cppcraft
 		// set bitfield directly
 		block.setBits(bits);
 		// make sure the mesh is updated
-		sector.updateAllMeshes();
+		sector.updateMesh(by);
 		// write updated sector to disk
 		//chunks.addSector(*s);
 		return true;
@@ -56,8 +56,10 @@ namespace cppcraft
 			return false;
 		}
     ::total_blocks_placed++;
-		// set new block
+		// set new block, remembering the light that was there
 		Block& blk = sector(bx, by, bz);
+		if (UNLIKELY(blk.isLight())) sector.getBlocks().removeLight(bx, by, bz);
+		const auto old_skylight = blk.getSkyLight();
 		blk = newblock;
 		// if setting this block changes the skylevel, propagate zero-light down
 		int skylevel = sector.flat()(bx, bz).skyLevel;
@@ -67,6 +69,7 @@ namespace cppcraft
 			for (int y = skylevel; y <= by; y++) {
 				sector(bx, y, bz).setSkyLight(0);
       }
+      sector.updateMeshes(skylevel, by);
 
 			// re-flood skylight down to old skylevel
 			if (sector.atmospherics) {
@@ -80,7 +83,7 @@ namespace cppcraft
 		}
 		else
 		{
-      auto level = blk.getSkyLight();
+      auto level = old_skylight;
       blk.setSkyLight(0);
 			// for all 6 sides of the block we added, theres a possibility that we blocked off light
 			// re-flood light on all sides
@@ -93,10 +96,12 @@ namespace cppcraft
 		// for lights, we will flood lighting outwards
 		if (UNLIKELY(blk.isLight()))
 		{
-      // mark light existing at by
-      sector.getBlocks().setLight(by);
+      // add to the sectors light emitters
+      sector.getBlocks().addLight(bx, by, bz);
       // set light source level for block
-			blk.setTorchLight(blk.getOpacity(0));
+			blk.setTorchLight(blk.getLightLevel());
+      if (Lighting::coloredTorchlight())
+        sector.getBlocks().torchColor(bx, by, bz) = LightColor::fromOpacity(blk.db().opacity);
       // start flooding
 			Lighting::floodOutof(sector.getX()*BLOCKS_XZ + bx,
                            by,
@@ -107,7 +112,7 @@ namespace cppcraft
 		// write updated sector to disk
 		//chunks.addSector(sector);
     // update mesh
-		sector.updateAllMeshes();
+		sector.updateMesh(by);
 		// update nearby sectors only if we are at certain edges
 		updateSurroundings(sector, bx, by, bz);
 		return true;
@@ -151,6 +156,7 @@ namespace cppcraft
 
     // to remove lights we will have to do a more.. thorough job
 		if (block.isLight()) {
+      sector.getBlocks().removeLight(bx, by, bz);
 			Lighting::removeLight(block, sector.getX()*BLOCKS_XZ + bx,
                                    by,
                                    sector.getZ()*BLOCKS_XZ + bz);
@@ -162,19 +168,19 @@ namespace cppcraft
 		// write updated sector to disk
 		//chunks.addSector(*s);
     // update the mesh, so we can see the change!
-		sector.updateAllMeshes();
+		sector.updateMesh(by);
 		// update neighboring sectors (depending on edges)
 		updateSurroundings(sector, bx, by, bz);
 		// return COPY of block
 		return block;
 	}
 
-	inline void updateNeighboringSector(Sector& sector, int)
+	inline void updateNeighboringSector(Sector& sector, int by)
 	{
 		// if the sector in question has blocks already,
 		if (sector.generated())
-			// just regenerate his mesh
-			sector.updateAllMeshes();
+			// just regenerate the part of his mesh next to the block
+			sector.updateMesh(by);
 	}
 
 	void Spiders::updateSurroundings(Sector& sector, int bx, int by, int bz)
@@ -2,11 +2,7 @@
 
 #include <library/log.hpp>
 #include <library/timing/timer.hpp>
-#include "camera.hpp"
-#include "sectors.hpp"
-#include <glm/geometric.hpp>
-#include <glm/gtx/transform.hpp>
-#include <library/math/matrix.hpp>
+#include <glm/glm.hpp>
 #include <cmath>
 
 using namespace library;
@@ -77,8 +73,8 @@ namespace cppcraft
 			setRadianAngle(radianAngle + getStepValue());
 			// reset timer & traveldistance
 			suntimer.restart();
-			// update world
-			sectors.updateAll();
+			// meshes only hold raw light levels, so the world does not need
+			// to be rebuilt: daylight is a uniform for the terrain shaders
 		}
 	}
 	
@@ -140,14 +136,4 @@ namespace cppcraft
 		this->realViewAngle = mat3(matrot) * realAngle;
 	}
 	
-	glm::mat4 SunClass::getSunMatrix() const
-	{
-		glm::mat4 mattemp = rotationMatrix(0.0f, -PI / 2.0f, 0.0f);
-		glm::mat4 matsun = rotationMatrix(thesun.getRealtimeRadianAngle(), 0.0, 0.0);
-		mattemp *= matsun;
-		mattemp *= glm::translate(vec3(0.f, 0.f, -thesun.renderDist));
-		
-		return camera.getRotationMatrix() * mattemp;
-	}
-	
 }
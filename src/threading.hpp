@@ -14,7 +14,6 @@ namespace cppcraft
 		std::thread worldman;
 
 		// mutexes
-		std::mutex sectorseam;
 		std::mutex playermove;
 		std::mutex playerselection;
 		std::mutex objects;
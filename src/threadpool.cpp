@@ -1,41 +1,178 @@
 #include "threadpool.hpp"
 
-#include <ThreadPool/thread_pool.hpp>
-#include "gameconf.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <cassert>
 
 namespace cppcraft
 {
-	static std::unique_ptr<ThreadPool> threadpool = nullptr;
-	static int free_jobs = 0;
+	typedef std::chrono::steady_clock clock;
+	static const int PRIORITIES = AsyncPool::PRIORITIES;
 
-	void AsyncPool::init()
+	struct task_t
 	{
-		// create dormant thread pool
-		free_jobs = config.get("world.threads", 2);
-		threadpool.reset(new ThreadPool(free_jobs));
+		task_t() {}
+		task_t(AsyncPool::job_t j)
+			: job(std::move(j)), scheduled(clock::now()) {}
+
+		AsyncPool::job_t job;
+		clock::time_point scheduled;
+	};
+	// one deque for each priority, behind one lock
+	struct task_queue_t
+	{
+		std::mutex mtx;
+		std::deque<task_t> tasks[PRIORITIES];
+	};
+	struct worker_t
+	{
+		task_queue_t queue;
+		std::thread  thread;
+	};
+
+	static std::vector<std::unique_ptr<worker_t>> pool;
+	// jobs scheduled from outside the workers
+	static task_queue_t injected;
+	// the workers sleep when there is nothing to do
+	static std::mutex sleep_mtx;
+	static std::condition_variable wakeup;
+	static bool running = false;
+	static int  total_queued = 0; // guarded by sleep_mtx
+
+	static std::atomic<int>     queued   [PRIORITIES];
+	static std::atomic<int64_t> completed[PRIORITIES];
+	static std::atomic<int64_t> waited_us[PRIORITIES];
+	// the worker running on this thread, if any
+	static thread_local int current_worker = -1;
+
+	static void push(int prio, task_t task)
+	{
+		// the own deque of a worker, or the shared one
+		task_queue_t& q = (current_worker >= 0) ? pool[current_worker]->queue : injected;
+		{
+			std::lock_guard<std::mutex> lock(q.mtx);
+			q.tasks[prio].push_back(std::move(task));
+		}
+		queued[prio]++;
+		{
+			std::lock_guard<std::mutex> lock(sleep_mtx);
+			total_queued++;
+		}
+		wakeup.notify_one();
+	}
+
+	// takes the oldest (@front) or the newest task of @prio from @q
+	static bool take(task_queue_t& q, int prio, bool front, task_t& task)
+	{
+		std::lock_guard<std::mutex> lock(q.mtx);
+		auto& tasks = q.tasks[prio];
+		if (tasks.empty()) return false;
+		if (front) {
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		} else {
+			task = std::move(tasks.back());
+			tasks.pop_back();
+		}
+		return true;
+	}
+
+	// the most urgent task: the newest of our own, else the oldest of the
+	// shared queue, else the oldest of another worker
+	static int find(int self, task_t& task)
+	{
+		const int n = pool.size();
+		for (int prio = 0; prio < PRIORITIES; prio++)
+		{
+			if (queued[prio] <= 0) continue;
+			if (take(pool[self]->queue, prio, false, task)) return prio;
+			if (take(injected, prio, true, task)) return prio;
+			for (int i = 1; i < n; i++)
+				if (take(pool[(self + i) % n]->queue, prio, true, task)) return prio;
+		}
+		return -1;
+	}
+
+	static void worker_loop(int self)
+	{
+		current_worker = self;
+		while (true)
+		{
+			task_t task;
+			const int prio = find(self, task);
+			if (prio < 0)
+			{
+				std::unique_lock<std::mutex> lock(sleep_mtx);
+				if (running == false && total_queued == 0) return;
+				wakeup.wait(lock, [] { return total_queued > 0 || running == false; });
+				continue;
+			}
+			queued[prio]--;
+			{
+				std::lock_guard<std::mutex> lock(sleep_mtx);
+				total_queued--;
+			}
+			const auto waited = clock::now() - task.scheduled;
+			waited_us[prio] += std::chrono::duration_cast<std::chrono::microseconds>(waited).count();
+
+			task.job();
+			completed[prio]++;
+		}
 	}
 
-	void AsyncPool::sched(job_t job)
+	void AsyncPool::init(int threads)
 	{
-    __sync_fetch_and_sub(&free_jobs, 1);
-    assert(free_jobs >= 0);
+		assert(pool.empty() && threads > 0);
+		running = true;
+		for (int p = 0; p < PRIORITIES; p++) {
+			queued[p] = 0;
+			completed[p] = 0;
+			waited_us[p] = 0;
+		}
+		// all the deques exist before any worker looks for work
+		for (int i = 0; i < threads; i++) pool.emplace_back(new worker_t);
+		for (int i = 0; i < threads; i++)
+			pool[i]->thread = std::thread(worker_loop, i);
+	}
 
-		threadpool->enqueue(job);
+	void AsyncPool::sched(priority_t prio, job_t job)
+	{
+		push(prio, task_t(std::move(job)));
 	}
-	void AsyncPool::release(int count)
+
+	bool AsyncPool::accepts(priority_t prio)
 	{
-    __sync_fetch_and_add(&free_jobs, count);
+		return queued[prio] < (int) pool.size();
 	}
 
-	bool AsyncPool::available()
+	AsyncPool::stats_t AsyncPool::stats(priority_t prio)
+	{
+		stats_t st;
+		st.queued    = std::max(0, queued[prio].load());
+		st.completed = completed[prio];
+		if (st.completed > 0) st.wait_ms = waited_us[prio] / 1000.0 / st.completed;
+		return st;
+	}
+	int AsyncPool::workers()
 	{
-		return free_jobs > 0;
+		return pool.size();
 	}
 
-  void AsyncPool::stop()
-  {
-    threadpool = nullptr;
-  }
+	void AsyncPool::stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleep_mtx);
+			running = false;
+		}
+		wakeup.notify_all();
+		for (auto& worker : pool) worker->thread.join();
+		pool.clear();
+	}
 }
@@ -1,24 +1,46 @@
 #pragma once
 #include "delegate.hpp"
-//#include <functional>
+#include <cstdint>
 
 namespace cppcraft
 {
+	/**
+	 * Work-stealing task scheduler. Every worker has its own deques for the
+	 * jobs it schedules itself, and runs the newest of those first, while
+	 * idle workers steal the oldest. Jobs from other threads go to a shared
+	 * queue. The most urgent priority that has a job anywhere runs first.
+	**/
 	struct AsyncPool
 	{
     typedef delegate<void()> job_t;
 
-		static void init();
+    enum priority_t {
+      EDIT = 0,   // remeshing after the player changed blocks
+      VISIBLE,    // meshes in view
+      GENERATION, // terrain generation
+      BACKGROUND, // the rest, eg. meshes out of view
+      PRIORITIES
+    };
 
-		//! \brief Schedules a job
-		static void sched(job_t job);
+		static void init(int threads);
 
-		//! \brief releases a job
-		static void release(int count = 1);
+		//! \brief Schedules a job, after the more urgent ones
+		static void sched(priority_t, job_t job);
 
-		//! \brief returns true if there are free slots
-		static bool available();
+		//! \brief returns true while fewer @prio jobs are waiting than there are
+		//! workers, so that callers can keep their own queues in order until then
+		static bool accepts(priority_t prio);
 
+		struct stats_t
+		{
+			int     queued    = 0; // waiting to be run
+			int64_t completed = 0;
+			double  wait_ms   = 0.0; // on average, from scheduled to started
+		};
+		static stats_t stats(priority_t);
+		static int workers();
+
+    //! \brief runs the jobs that are left, and stops the workers
     static void stop();
 	};
 }
@@ -1,6 +1,9 @@
 #ifndef VERTEX_BLOCK_HPP
 #define VERTEX_BLOCK_HPP
 
+#include "renderconst.hpp"
+#include <cstdint>
+
 namespace cppcraft
 {
 	typedef float GLfloat;
@@ -31,12 +34,164 @@ namespace cppcraft
 		GLuint color; // 20
 
     GLuint data1; // 24
-    GLuint data2; // 28
+    // 3-channels torchlight color (RGB8, same scale as torchlight)
+    GLuint lightcolor; // 28
 
 	}; // 32
   static_assert(sizeof(vertex_t) == 32, "Vertex should be exactly 32 bytes");
 
+	/**
+	 * Packed vertex for plain terrain cube faces, decoded by the shaders
+	 * in unpack_vertex.glsl. The column index comes from the draw call.
+	 * p0: x (5 bits), y (9), z (5), in whole blocks, face (3), ao (8)
+	 * p1: u (12), v (12), in UV_UNITs
+	 * p2: tile (16), light (16)
+	 * p3: terrain color
+	 * The torchlight color is gray, the same as the torchlight level,
+	 * so vertices near colored lights stay as vertex_t.
+	**/
+	struct terrain_vertex_t
+	{
+		uint32_t p0, p1, p2, p3;
+
+		static const int S = RenderConst::VERTEX_SCALE;
+		// a quarter of a tile, which is also the texture step of big tiles
+		static const int UV_UNIT = S / 4;
+		static const int UV_MAX  = 4095;
+
+		// the cube face normals, in the same order as the blockmodels
+		static int faceOf(const vertex_t& v) noexcept
+		{
+			if (v.nx == 0 && v.ny == 0) return (v.nz == 127) ? 0 : ((v.nz == -128) ? 1 : -1);
+			if (v.nx == 0 && v.nz == 0) return (v.ny == 127) ? 2 : ((v.ny == -128) ? 3 : -1);
+			if (v.ny == 0 && v.nz == 0) return (v.nx == 127) ? 4 : ((v.nx == -128) ? 5 : -1);
+			return -1;
+		}
+
+		// returns false if @v can't be represented exactly
+		bool pack(const vertex_t& v) noexcept
+		{
+			const int face = faceOf(v);
+			if (face < 0 || v.ao < 0 || v.data1 != 0) return false;
+			if ((v.x | v.y | v.z) & (S-1)) return false;
+			if (v.x < 0 || v.x > 16 * S || v.z < 0 || v.z > 16 * S) return false;
+			if (v.y < 0 || v.y > BLOCKS_Y * S) return false;
+			if (v.u < 0 || v.v < 0 || (v.u | v.v) % UV_UNIT) return false;
+			if (v.u / UV_UNIT > UV_MAX || v.v / UV_UNIT > UV_MAX) return false;
+			if (v.w < 0) return false;
+			const uint32_t torch = v.light >> 8;
+			if (v.lightcolor != (torch | torch << 8 | torch << 16)) return false;
+
+			p0 = (v.x / S) | (v.y / S) << 5 | (v.z / S) << 14 | face << 19 | uint32_t(v.ao) << 22;
+			p1 = (v.u / UV_UNIT) | (v.v / UV_UNIT) << 12;
+			p2 = uint16_t(v.w) | uint32_t(v.light) << 16;
+			p3 = v.color;
+			return true;
+		}
+		// the vertex as the shaders see it, without the column index
+		vertex_t unpack() const noexcept
+		{
+			static const GLbyte normals[6][3] = {
+				{0, 0, 127}, {0, 0, -128}, {0, 127, 0}, {0, -128, 0}, {127, 0, 0}, {-128, 0, 0}
+			};
+			const int face = (p0 >> 19) & 7;
+			vertex_t v {};
+			v.x = (p0 & 31) * S;
+			v.y = ((p0 >> 5) & 511) * S;
+			v.z = ((p0 >> 14) & 31) * S;
+			v.nx = normals[face][0];
+			v.ny = normals[face][1];
+			v.nz = normals[face][2];
+			v.ao = p0 >> 22;
+			v.u = (p1 & 4095) * UV_UNIT;
+			v.v = ((p1 >> 12) & 4095) * UV_UNIT;
+			v.w = p2 & 0xFFFF;
+			v.light = p2 >> 16;
+			v.color = p3;
+			const uint32_t torch = v.light >> 8;
+			v.lightcolor = torch | torch << 8 | torch << 16;
+			return v;
+		}
+	}; // 16
+	static_assert(sizeof(terrain_vertex_t) == 16, "Packed terrain vertex should be 16 bytes");
+	static_assert(BLOCKS_XZ < 32 && BLOCKS_Y < 512, "Packed terrain vertex positions are 5 and 9 bits");
+
+	/**
+	 * One instance of a model from the blockmodels, eg. a cross, which the
+	 * shaders in unpack_instance.glsl turn into the vertices of the model.
+	 * The column index comes from the draw call, like for packed vertices.
+	 * pos:   x (5 bits), y (9), z (5), in whole blocks
+	 * tile:  tile (16), model (8)
+	 * light: light (16) of corners 0 and 1, then of corners 2 and 3
+	 * color: terrain color of each corner
+	 * The corners are at (0, 0), (1, 1), (1, 0) and (0, 1) of the block.
+	**/
+	struct model_instance_t
+	{
+		uint32_t pos, tile;
+		uint32_t light[2];
+		uint32_t color[4];
+
+		static const int CORNERS = 4;
+
+		model_instance_t() = default;
+		model_instance_t(int bx, int by, int bz, int model, short tile_id) noexcept
+			: pos(bx | by << 5 | bz << 14),
+			  tile(uint16_t(tile_id) | uint32_t(model) << 16), light {}, color {} {}
+
+		int x() const noexcept { return pos & 31; }
+		int y() const noexcept { return (pos >> 5) & 511; }
+		int z() const noexcept { return (pos >> 14) & 31; }
+		int model() const noexcept { return tile >> 16; }
+
+		void setLight(int corner, uint16_t value) noexcept
+		{
+			const int shift = (corner & 1) * 16;
+			light[corner / 2] = (light[corner / 2] & ~(0xFFFFu << shift)) | uint32_t(value) << shift;
+		}
+		uint16_t getLight(int corner) const noexcept
+		{
+			return light[corner / 2] >> ((corner & 1) * 16);
+		}
+	}; // 32
+	static_assert(sizeof(model_instance_t) == 32, "Model instance should be 32 bytes");
+
 	typedef GLushort indice_t;
+
+	/**
+	 * Quads are drawn as two triangles each, (0, 1, 2) and (0, 2, 3), using
+	 * one static index buffer shared by all columns. The base vertex of each
+	 * draw selects the quads, and larger draws are split so that the 16-bit
+	 * indices can address all of their vertices.
+	**/
+	struct quad_indices
+	{
+		static const int PER_QUAD = 6;
+		static const uint32_t MAX_QUADS = 65536 / 4;
+		static const uint32_t MAX_INDICES = MAX_QUADS * PER_QUAD;
+
+		// the pattern for @quads quads, into @dest
+		static void generate(indice_t* dest, uint32_t quads) noexcept
+		{
+			for (uint32_t q = 0; q < quads; q++, dest += PER_QUAD)
+			{
+				const indice_t v = q * 4;
+				dest[0] = v;     dest[1] = v + 1; dest[2] = v + 2;
+				dest[3] = v;     dest[4] = v + 2; dest[5] = v + 3;
+			}
+		}
+		// calls @draw(count, basevertex) for each draw needed to render
+		// @count indices of the quads starting at vertex @first
+		template <typename Func>
+		static void draws(uint32_t first, uint32_t count, Func draw)
+		{
+			for (uint32_t i = 0; i < count; i += MAX_INDICES)
+			{
+				const uint32_t n = (count - i < MAX_INDICES) ? count - i : MAX_INDICES;
+				draw(n, first + i / PER_QUAD * 4);
+			}
+		}
+	};
 }
 
 #endif
@@ -45,10 +45,8 @@ namespace cppcraft
 			this->folder = worldFolder;
 		}
 
-		// initialize internal coordinates
-		world.internal.x = 0;
-		world.internal.y = 0;
-		world.internal.z = 0;
+		// initialize the grid delta
+		m_delta.store(0, std::memory_order_release);
 	}
 
 	void World::load()
@@ -72,17 +70,23 @@ namespace cppcraft
 
 	void World::increaseDelta(int dx, int dz)
 	{
-		internal.x += dx;
-		while (internal.x < 0) internal.x += sectors.getXZ();
-		internal.z += dz;
-		while (internal.z < 0) internal.z += sectors.getXZ();
+		// the delta is the rotation of the grid, which is a ring buffer.
+		// it is wrapped here and then published as one, so that the other
+		// threads never see it outside the grid, or one axis of a move
+		const int xz = sectors.getXZ();
+		const delta_t delta = getDelta();
+		int x = (delta.x + dx) % xz;
+		if (x < 0) x += xz;
+		int z = (delta.z + dz) % xz;
+		if (z < 0) z += xz;
+		m_delta.store(uint32_t(x) << 16 | uint32_t(z), std::memory_order_release);
 	}
 
 	void World::transitionTo(int wx, int wz)
 	{
-		internal.x = 0;
-		internal.z = 0;
+		m_delta.store(0, std::memory_order_release);
 		this->worldCoords.x = wx;
 		this->worldCoords.z = wz;
+		this->m_teleports++;
 	}
 }
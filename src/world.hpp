@@ -16,6 +16,8 @@
 #ifndef WORLD_HPP
 #define WORLD_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 
 namespace cppcraft
@@ -46,9 +48,21 @@ namespace cppcraft
 		wcoord_t getWY() const { return worldCoords.y; }
 		wcoord_t getWZ() const { return worldCoords.z; }
 
-		wcoord_t getDeltaX() const { return internal.x; }
-		wcoord_t getDeltaY() const { return internal.y; }
-		wcoord_t getDeltaZ() const { return internal.z; }
+		// the rotation of the sector grid on both axes, always inside the
+		// grid and always a pair that was published together (any thread)
+		struct delta_t
+		{
+			wcoord_t x, z;
+		};
+		delta_t getDelta() const noexcept
+		{
+			const uint32_t delta = m_delta.load(std::memory_order_acquire);
+			return { wcoord_t(delta >> 16), wcoord_t(delta & 0xFFFF) };
+		}
+		wcoord_t getDeltaX() const noexcept { return getDelta().x; }
+		wcoord_t getDeltaZ() const noexcept { return getDelta().z; }
+		// the number of teleports so far, after which nothing is where it was
+		int teleports() const { return m_teleports; }
 
 		void load();
 		void save();
@@ -56,7 +70,9 @@ namespace cppcraft
 	private:
 		std::string folder;
 		world_t worldCoords{0, 0, 0};
-		world_t internal{0, 0, 0};
+		// the grid delta, as (x << 16) | z
+		std::atomic<uint32_t> m_delta {0};
+		int m_teleports = 0;
 
 		void increaseDelta(int dx, int dz);
 
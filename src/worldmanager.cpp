@@ -4,15 +4,18 @@
 #include <library/timing/timer.hpp>
 #include <library/sleep.hpp>
 #include "chunks.hpp"
+#include "frame_budget.hpp"
 #include "game.hpp"
 #include "generator.hpp"
 #include "generator/objectq.hpp"
 #include "generator/simulation/simulator.hpp"
 #include "lighting.hpp"
 #include "particles.hpp"
+#include "pipeline.hpp"
 #include "player.hpp"
 #include "precompq.hpp"
 #include "seamless.hpp"
+#include "sectors.hpp"
 #include "soundman.hpp"
 #include "sun.hpp"
 #include "world.hpp"
@@ -22,6 +25,12 @@ using namespace library;
 
 namespace cppcraft
 {
+	// the stages of the world thread that share its time
+	enum { B_OBJECTS, B_LIGHT, B_MESH, B_GENERATOR };
+	FrameBudget worldbudget({
+		{"Objects", true}, {"Light", true}, {"Mesh", false}, {"Generator", false}
+	});
+
 	void WorldManager::submain()
 	{
 		main();
@@ -109,50 +118,43 @@ namespace cppcraft
 #endif
         if (transition) break;
 
-				double timeOut = localTime + MAX_TIMING_WAIT;
+				// the rest must be done before the next player tick,
+				// and is shared out by how much each stage has waiting
+				double available = _ticktimer + TIMING_TICKTIMER - timer.getTime();
+				if (available > MAX_TIMING_WAIT) available = MAX_TIMING_WAIT;
+				worldbudget.backlog(B_OBJECTS, terragen::ObjectQueue::size());
+				worldbudget.backlog(B_LIGHT, Pipeline::size());
+				// the level of detail is checked every round as well
+				worldbudget.backlog(B_MESH, precompq.size() + 1);
+				worldbudget.backlog(B_GENERATOR, Generator::size() + Generator::results());
+				worldbudget.begin(available * 1000.0);
 
 				///----------------------------------///
 				/// ---------- OBJECT GEN ---------- ///
 				///----------------------------------///
-#ifdef TIMING
-        Timer objectq_timer;
-#endif
-				terragen::ObjectQueue::run();
-#ifdef TIMING
-        timings[1] = objectq_timer.getTime();
-#endif
+				worldbudget.run(B_OBJECTS,
+				[] { return terragen::ObjectQueue::run(); });
 
-				// check for timeout
-				if (timer.getTime() > timeOut) break;
+				///----------------------------------///
+				/// -------- ATMOSPHERICS ---------- ///
+				///----------------------------------///
+				// flood the sectors that are ready for light
+				worldbudget.run(B_LIGHT,
+				[] { return Pipeline::run(); });
 
 				///----------------------------------///
 				/// --------- PRECOMPILER ---------- ///
 				///----------------------------------///
-#ifdef TIMING
-        Timer meshgen_timer;
-#endif
 				// start scheduling sectors for meshgen
-				precompq.run();
-#ifdef TIMING
-        timings[2] = meshgen_timer.getTime();
-#endif
-
-        // check for timeout
-				if (timer.getTime() > timeOut) break;
+				worldbudget.run(B_MESH,
+				[] { precompq.run(); return false; });
 
 				///----------------------------------///
 				/// ---------- GENERATOR ----------- ///
 				///----------------------------------///
-#ifdef TIMING
-        Timer generator_timer;
-#endif
-				Generator::run();
-#ifdef TIMING
-        timings[3] = generator_timer.getTime();
-#endif
-
-        // check for timeout
-				if (timer.getTime() > timeOut) break;
+				worldbudget.run(B_GENERATOR,
+				[] { Generator::run(); return false; });
+				worldbudget.end();
 
 				// update shadows if sun has travelled far
 				// but not when connected to a network
@@ -171,14 +173,25 @@ namespace cppcraft
 #ifdef TIMING
         timings[4] = lighting_timer.getTime();
 #endif
+        // what the stats window shows of the sector the player is in
+        if (Sector* sector = sectors.sectorAt(player.pos.x, player.pos.z))
+        {
+          sector->shownLights = sector->getLightCount();
+          sector->shownStage  = Pipeline::stage(*sector);
+        }
 				break;
 			} // world tick
 
 #ifdef TIMING
-      double sum = timings[0] + timings[1] + timings[2] + timings[3] + timings[4];
+      double sum = timings[0] + timings[4];
+      for (int i = 0; i < worldbudget.stages(); i++) sum += worldbudget.counters(i).spent_ms / 1000.0;
       if (sum > 0.001) {
-      printf("Timings: SEAM %f  OBJQ %f  MESH %f  GEN %f  LIGHT %f\n",
-            timings[0], timings[1], timings[2], timings[3], timings[4]);
+      printf("Timings: SEAM %f  LIGHT %f", timings[0], timings[4]);
+      for (int i = 0; i < worldbudget.stages(); i++) {
+        const auto c = worldbudget.counters(i);
+        printf("  %s %f/%f", c.name, c.spent_ms / 1000.0, c.budget_ms / 1000.0);
+      }
+      printf("\n");
       }
 #endif
 			// send & receive stuff
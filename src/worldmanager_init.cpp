@@ -2,6 +2,7 @@
 
 #include "blockmodels.hpp"
 #include "chunks.hpp"
+#include "gameconf.hpp"
 #include "lighting.hpp"
 #include "generator.hpp"
 #include "particles.hpp"
@@ -30,7 +31,7 @@ namespace cppcraft
 		// initialize chunk systems
 		chunks.initChunks();
 		// initialize threads
-		AsyncPool::init();
+		AsyncPool::init(config.get("world.threads", 2));
 		// initialize lighting
 		Lighting::init();
 
@@ -2,7 +2,6 @@
 
 #include <library/opengl/opengl.hpp>
 #include "chunks.hpp"
-#include "columns.hpp"
 #include "game.hpp"
 #include "player.hpp"
 #include "compiler_scheduler.hpp"
@@ -52,27 +51,17 @@ namespace cppcraft
 		// clear precomp scheduler
 		CompilerScheduler::reset();
 
-		mtx.sectorseam.lock();
 		{
+			// the renderer sees the teleport with the player, and resets the columns
+			std::lock_guard<std::mutex> lock(mtx.playermove);
 			// transition to new location
 			world.transitionTo(teleport_wcoords.x, teleport_wcoords.z);
-
-			// invalidate ALL sectors
-			sectors.regenerateAll();
-
 			// move player to:
 			// center grid, center sector, center block
 			player.pos = teleport_xyz;
-
-			// disable all terrain meshes
-			for (int x = 0; x < sectors.getXZ(); x++)
-			for (int z = 0; z < sectors.getXZ(); z++)
-			for (int y = 0; y < columns.getHeight(); y++)
-			{
-				columns(x, z, world.getDeltaX(), world.getDeltaZ()).reset();
-			}
 		}
-		mtx.sectorseam.unlock();
+		// invalidate ALL sectors, which also drops the jobs in flight
+		sectors.regenerateAll();
 	}
 
 }
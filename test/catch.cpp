@@ -1,2 +1,12 @@
-#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_RUNNER
 #include "catch.hpp"
+
+namespace cppcraft {
+  extern void mock_init_blocks();
+}
+
+int main(int argc, char* argv[])
+{
+  cppcraft::mock_init_blocks();
+  return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,351 @@
+#pragma once
+/**
+ * The blocks, synthetic worlds and mesh driver shared by the tests and by
+ * mesh_bench, so that the benchmark measures what the tests check.
+ * World coordinates are grid coordinates, where x and z span all sectors.
+**/
+#include "biomes.hpp"
+#include "blockmodels.hpp"
+#include "gameconf.hpp"
+#include "lighting.hpp"
+#include "precomp_thread.hpp"
+#include "precompiler.hpp"
+#include "sectors.hpp"
+#include <memory>
+#include <vector>
+
+namespace cppcraft
+{
+  extern void emitCube(PTD&, int bx, int by, int bz, block_t);
+  extern void emitCross(PTD&, int bx, int by, int bz, block_t);
+}
+
+namespace fixtures
+{
+  using namespace cppcraft;
+  static const int TORCH_LEVEL = 13;
+
+  // the neighbors in the plane of the face that are the same block, as bits
+  inline short connected_tile(const connected_textures_t& ct, uint8_t face)
+  {
+    short tile = face << 8;
+    for (int i = 0, bit = 0; i < 9; i++)
+    {
+      if (i == 4) continue;
+      if (ct.blocks[i].getID() == ct.blocks[4].getID()) tile |= 1 << bit;
+      bit++;
+    }
+    return tile;
+  }
+
+  struct test_blocks_t
+  {
+    block_t stone, soil, leaf, torch, water, glass, grass;
+  };
+  // registered once, in the same order every run, so that the block IDs
+  // of a world saved by mesh_bench stay the same
+  inline const test_blocks_t& test_blocks()
+  {
+    static test_blocks_t tb = [] {
+      blockmodels.init();
+      auto& db = db::BlockDB::get();
+      test_blocks_t result;
+      result.stone = db.create("test_stone").getID();
+      db[result.stone].shader = RenderConst::TX_SOLID;
+      db[result.stone].emit = emitCube;
+      // terrain colored, with big repeating tiles
+      result.soil = db.create("test_soil").getID();
+      db[result.soil].shader = RenderConst::TX_REPEAT;
+      db[result.soil].setColorIndex(0);
+      db[result.soil].emit = emitCube;
+      // has its own visibility test, like fluids
+      result.leaf = db.create("test_leaf").getID();
+      db[result.leaf].transparent = true;
+      db[result.leaf].transparentSides = db::BlockData::SIDE_ALL;
+      db[result.leaf].shader = RenderConst::TX_TRANS_2SIDED;
+      db[result.leaf].emit = emitCube;
+      db[result.leaf].visibilityComp =
+        [] (const Block& src, const Block& dst, uint16_t mask) -> uint16_t {
+          return (src.getID() == dst.getID()) ? 0 : (mask & dst.getTransparentSides());
+        };
+      result.torch = db.create("test_torch").getID();
+      db[result.torch].transparent = true;
+      db[result.torch].transparentSides = db::BlockData::SIDE_ALL;
+      db[result.torch].setLightColor(TORCH_LEVEL, TORCH_LEVEL, TORCH_LEVEL);
+      db[result.torch].shader = RenderConst::TX_SOLID;
+      db[result.torch].emit = emitCube;
+      // a fluid, as made by BlockData::createFluid, which is not linked in here
+      result.water = db.create("test_water").getID();
+      db[result.water].liquid = true;
+      db[result.water].transparent = true;
+      db[result.water].transparentSides = db::BlockData::SIDE_ALL;
+      db[result.water].shader = RenderConst::TX_WATER;
+      db[result.water].setColorIndex(Biomes::CL_WATER);
+      db[result.water].emit = emitCube;
+      db[result.water].visibilityComp = db[result.leaf].visibilityComp;
+      // connected textures, with a different tile for every face and neighbor set
+      result.glass = db.create("test_glass").getID();
+      db[result.glass].shader = RenderConst::TX_SOLID;
+      db[result.glass].emit = emitCube;
+      db[result.glass].useConnectedTexture(connected_tile);
+      // a cross, as made by BlockData::createCross
+      result.grass = db.create("test_grass").getID();
+      db[result.grass].cross = true;
+      db[result.grass].transparent = true;
+      db[result.grass].setBlock(false);
+      db[result.grass].transparentSides = db::BlockData::SIDE_ALL;
+      db[result.grass].shader = RenderConst::TX_TRANS_2SIDED;
+      db[result.grass].emit = emitCross;
+      db[result.grass].setColorIndex(Biomes::CL_GRASS);
+      db[result.grass].visibilityComp =
+        [] (const Block&, const Block&, uint16_t mask) -> uint16_t { return mask; };
+      return result;
+    }();
+    return tb;
+  }
+
+  inline uint32_t hash3(int x, int y, int z)
+  {
+    uint32_t h = x * 73856093u ^ y * 19349663u ^ z * 83492791u;
+    h ^= h >> 13; h *= 0x5bd1e995u; h ^= h >> 15;
+    return h;
+  }
+  // smooth noise in [0, 1), from a lattice of @scale blocks
+  inline float value_noise(int x, int z, int scale)
+  {
+    const int x0 = x / scale, z0 = z / scale;
+    const float fx = float(x % scale) / scale, fz = float(z % scale) / scale;
+    auto corner = [] (int x, int z) { return (hash3(x, 7, z) & 0xFFFF) / 65536.0f; };
+    const float a = corner(x0, z0)   + (corner(x0+1, z0)   - corner(x0, z0))   * fx;
+    const float b = corner(x0, z0+1) + (corner(x0+1, z0+1) - corner(x0, z0+1)) * fx;
+    return a + (b - a) * fz;
+  }
+  inline Block& block_at(int x, int y, int z)
+  {
+    return sectors(x / BLOCKS_XZ, z / BLOCKS_XZ)(x & (BLOCKS_XZ-1), y, z & (BLOCKS_XZ-1));
+  }
+  // every sector from (x0, z0) to (x1, z1), inclusive
+  template <typename F>
+  inline void for_sectors(int x0, int z0, int x1, int z1, F func)
+  {
+    for (int sx = x0; sx <= x1; sx++)
+    for (int sz = z0; sz <= z1; sz++)
+      func(sectors(sx, sz));
+  }
+  inline void flood_sectors(int x0, int z0, int x1, int z1)
+  {
+    for_sectors(x0, z0, x1, z1,
+    [] (Sector& sector) {
+      Lighting::atmosphericFlood(sector);
+    });
+  }
+
+  // columns of stone up to @height, with no light below the skylevel
+  // until it has been flooded
+  inline void generate_columns(int x0, int z0, int x1, int z1, int (*height)(int, int))
+  {
+    const auto& tb = test_blocks();
+    for_sectors(x0, z0, x1, z1,
+    [&tb, height] (Sector& sector)
+    {
+      sector.flat().assign_new();
+      sector.clear();
+      sector.getBlocks().clearLights();
+
+      for (int x = 0; x < BLOCKS_XZ; x++)
+      for (int z = 0; z < BLOCKS_XZ; z++)
+      {
+        const int h = height(sector.getX() * BLOCKS_XZ + x, sector.getZ() * BLOCKS_XZ + z);
+        for (int y = 0; y < h; y++) {
+          sector(x, y, z) = Block(tb.stone);
+          sector(x, y, z).setLight(0, 0);
+        }
+        sector.flat()(x, z).skyLevel = h;
+      }
+    });
+  }
+
+  struct scene_t
+  {
+    const char* name;
+    bool caves;
+    bool overhangs;
+    bool water;
+    int  torches; // per center sector
+  };
+  static const int SCENE_WATER_LEVEL = 44;
+
+  // stone with caves, overhangs and lakes around the sector (cx, cz), with
+  // @pad sectors of padding, and torches in the covered air of the 3x3 center
+  inline void generate_scene(const scene_t& scene, int cx, int cz, int pad)
+  {
+    const auto& tb = test_blocks();
+    for_sectors(cx - pad, cz - pad, cx + pad, cz + pad,
+    [&scene, &tb] (Sector& sector)
+    {
+      sector.flat().assign_new();
+      // air with full skylight everywhere
+      sector.clear();
+      auto& sb = sector.getBlocks();
+      sb.clearLights();
+      sb.highest_light_y = 0;
+      sb.light_count = 0;
+
+      for (int x = 0; x < BLOCKS_XZ; x++)
+      for (int z = 0; z < BLOCKS_XZ; z++)
+      {
+        const int wx = sector.getX() * BLOCKS_XZ + x;
+        const int wz = sector.getZ() * BLOCKS_XZ + z;
+        const int h = 36 + hash3(wx >> 2, 0, wz >> 2) % 14;
+
+        for (int y = 0; y < h; y++)
+          sector(x, y, z) = Block(tb.stone);
+        if (scene.caves)
+        for (int y = 4; y < h - 4; y++)
+          if (hash3(wx >> 2, y >> 2, wz >> 2) % 4 == 0)
+            sector(x, y, z) = Block(_AIR);
+
+        int top = h;
+        if (scene.overhangs && hash3(wx >> 3, 1, wz >> 3) % 3 == 0)
+        {
+          sector(x, h+4, z) = Block(tb.stone);
+          sector(x, h+5, z) = Block(tb.stone);
+          top = h + 6;
+        }
+        if (scene.water && top < SCENE_WATER_LEVEL)
+        {
+          for (int y = top; y < SCENE_WATER_LEVEL; y++)
+            sector(x, y, z) = Block(tb.water);
+          top = SCENE_WATER_LEVEL;
+        }
+        sector.flat()(x, z).skyLevel = top;
+        // no light below the skylevel, until it has been flooded
+        for (int y = 0; y < top; y++)
+          sector(x, y, z).setLight(0, 0);
+      }
+    });
+
+    uint32_t seed = 1;
+    for_sectors(cx - 1, cz - 1, cx + 1, cz + 1,
+    [&scene, &tb, &seed] (Sector& sector)
+    {
+      int placed = 0;
+      for (int attempt = 0; attempt < scene.torches * 50 && placed < scene.torches; attempt++)
+      {
+        seed = seed * 1103515245u + 12345u;
+        const int x = (seed >> 4) & 15;
+        const int z = (seed >> 8) & 15;
+        const int y = 2 + (seed >> 12) % 60;
+        if (sector(x, y, z).isAir() && y < sector.flat()(x, z).skyLevel)
+        {
+          sector(x, y, z) = Block(tb.torch);
+          sector.getBlocks().addLight(x, y, z);
+          placed++;
+        }
+      }
+    });
+  }
+
+  // rolling hills of soil on stone, with caves, torches and trees, and
+  // water up to @sealevel, flooded with light
+  inline void generate_hills(int x0, int z0, int x1, int z1, int sealevel)
+  {
+    const auto& tb = test_blocks();
+    for_sectors(x0, z0, x1, z1,
+    [&tb, sealevel] (Sector& sector)
+    {
+      sector.flat().assign_new();
+      sector.clear();
+      sector.getBlocks().clearLights();
+
+      for (int x = 0; x < BLOCKS_XZ; x++)
+      for (int z = 0; z < BLOCKS_XZ; z++)
+      {
+        const int wx = sector.getX() * BLOCKS_XZ + x;
+        const int wz = sector.getZ() * BLOCKS_XZ + z;
+        const int h = 40 + value_noise(wx, wz, 32) * 40 + value_noise(wx, wz, 8) * 8;
+        for (int y = 0; y < h; y++)
+          sector(x, y, z) = Block((y < h - 3) ? tb.stone : tb.soil);
+        for (int y = h; y < sealevel; y++)
+          sector(x, y, z) = Block(tb.water);
+        for (int y = 4; y < h - 6; y++)
+          if (hash3(wx >> 2, y >> 2, wz >> 2) % 5 == 0)
+            sector(x, y, z) = Block(_AIR);
+
+        auto& flat = sector.flat()(x, z);
+        flat.fcolor[0] = 0xFF30A040 + (hash3(wx, 0, wz) & 0x0F0F0F);
+        flat.fcolor[Biomes::CL_WATER] = 0xFF804020;
+        flat.skyLevel = h;
+      }
+    });
+
+    for_sectors(x0, z0, x1, z1,
+    [&tb, sealevel] (Sector& sector)
+    {
+      for (int x = 2; x < BLOCKS_XZ-2; x += 5)
+      for (int z = 2; z < BLOCKS_XZ-2; z += 5)
+      {
+        const int wx = sector.getX() * BLOCKS_XZ + x;
+        const int wz = sector.getZ() * BLOCKS_XZ + z;
+        const uint32_t h = hash3(wx, 3, wz);
+        // a torch down in a cave
+        const int ty = 6 + h % 30;
+        if (sector(x, ty, z).isAir() && ty < sector.flat()(x, z).skyLevel)
+        {
+          sector(x, ty, z) = Block(tb.torch);
+          sector.getBlocks().addLight(x, ty, z);
+        }
+        // a tree, reaching into the neighbors
+        const int ground = sector.flat()(x, z).skyLevel;
+        if (h % 3 != 0 || ground < sealevel) continue;
+        for (int y = ground; y < ground + 4; y++) sector(x, y, z) = Block(tb.stone);
+        for (int dx = -2; dx <= 2; dx++)
+        for (int dz = -2; dz <= 2; dz++)
+        for (int y = ground + 3; y < ground + 6; y++)
+        {
+          Block& blk = block_at(wx + dx, y, wz + dz);
+          if (blk.isAir()) blk = Block(tb.leaf);
+        }
+      }
+    });
+
+    for_sectors(x0, z0, x1, z1,
+    [] (Sector& sector)
+    {
+      for (int x = 0; x < BLOCKS_XZ; x++)
+      for (int z = 0; z < BLOCKS_XZ; z++)
+      {
+        int top = BLOCKS_Y;
+        while (top > 0 && sector(x, top-1, z).isAir()) top--;
+        sector.flat()(x, z).skyLevel = top;
+        // no light below the skylevel, until it has been flooded
+        for (int y = 0; y < top; y++) sector(x, y, z).setLight(0, 0);
+      }
+    });
+    flood_sectors(x0, z0, x1, z1);
+  }
+
+  // the stages of a mesh job, in the order the precompiler threads run them
+  inline void mesh_job(PrecompThread& pt, Precomp& pc)
+  {
+    pt.precompile(pc);
+    pt.ambientOcclusion(pc);
+    if (gameconf.packed_vertices) pt.packTerrain(pc);
+    pt.createIndices(pc);
+  }
+  // meshes every sub-mesh of @sector as a mesh job, and returns the
+  // vertices that were not packed, in order
+  inline std::vector<vertex_t> mesh_sector(Sector& sector, int lod = 0)
+  {
+    std::vector<vertex_t> mesh;
+    std::unique_ptr<PrecompThread> pt(new PrecompThread);
+    for (int m = 0; m < Sector::MESHES; m++)
+    {
+      std::unique_ptr<Precomp> pc(new Precomp(sector, m));
+      pc->lod = lod;
+      mesh_job(*pt, *pc);
+      mesh.insert(mesh.end(), pc->datadump.begin(), pc->datadump.end());
+    }
+    return mesh;
+  }
+}
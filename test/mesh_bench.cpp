@@ -0,0 +1,256 @@
+/**
+ * Headless meshing benchmark, running the precompiler stages the same way
+ * the mesh jobs of PrecompQ do, but without OpenGL or the rest of the game.
+ * The world is either the hills of the test fixtures, or a world saved by
+ * an earlier run.
+ * Prints vertices per sector, sectors per second, and a hash of all the
+ * mesh output, which must stay the same for changes that only make meshing
+ * faster. With --expect, a different hash makes the run fail.
+ *
+ * mesh_bench [-r rounds] [-t threads] [-w width] [-l lod] [-s sealevel]
+ *            [--greedy] [--packed] [--connected] [--save file | --load file]
+ *            [--expect hash]
+ * With a sea level, the valleys are filled with water up to it, and -s 76
+ * gives a world that is mostly ocean. With --connected, the stone has
+ * connected textures, which should cost about the same as plain tiles.
+**/
+#include "fixtures.hpp"
+#include <library/timing/timer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cppcraft;
+using namespace fixtures;
+
+namespace cppcraft
+{
+  Sectors sectors(32);
+  extern void mock_init_blocks();
+}
+
+// the meshed sectors start here, with one ring of neighbors around them
+static const int ORIGIN = 1;
+
+struct bench_options_t
+{
+  int rounds  = 10;
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  int width   = 6;
+  int lod     = 0;
+  int sealevel = 0;
+  bool greedy = false;
+  bool packed = false;
+  bool connected = false;
+  const char* save   = nullptr;
+  const char* load   = nullptr;
+  const char* expect = nullptr;
+};
+
+template <typename F>
+static void for_world(const bench_options_t& opt, F func)
+{
+  for_sectors(ORIGIN-1, ORIGIN-1, ORIGIN + opt.width, ORIGIN + opt.width, func);
+}
+
+// a saved world is the blocks and 2D data of every sector, as they are
+static const uint32_t WORLD_MAGIC = 0x4243434D; // "MCCB"
+
+static bool save_world(const bench_options_t& opt, const char* path)
+{
+  FILE* f = fopen(path, "wb");
+  if (f == nullptr) return false;
+  const uint32_t header[3] = { WORLD_MAGIC, (uint32_t) opt.width, (uint32_t) sizeof(Block) };
+  bool ok = fwrite(header, sizeof(header), 1, f) == 1;
+  for_world(opt,
+  [f, &ok] (Sector& sector)
+  {
+    const auto& blocks = sector.getBlocks().b;
+    ok = ok && fwrite(blocks.data(), sizeof(blocks), 1, f) == 1;
+    for (int x = 0; x < BLOCKS_XZ; x++)
+    for (int z = 0; z < BLOCKS_XZ; z++)
+      ok = ok && fwrite(&sector.flat()(x, z), sizeof(Flatland::flatland_t), 1, f) == 1;
+  });
+  return fclose(f) == 0 && ok;
+}
+static bool load_world(bench_options_t& opt, const char* path)
+{
+  FILE* f = fopen(path, "rb");
+  if (f == nullptr) return false;
+  uint32_t header[3];
+  bool ok = fread(header, sizeof(header), 1, f) == 1
+         && header[0] == WORLD_MAGIC && header[2] == sizeof(Block)
+         && header[1] > 0 && int(header[1]) + 2 <= sectors.getXZ();
+  if (ok)
+  {
+    test_blocks(); // same block IDs as when it was saved
+    opt.width = header[1];
+    for_world(opt,
+    [f, &ok] (Sector& sector)
+    {
+      sector.flat().assign_new();
+      sector.clear();
+      auto& blocks = sector.getBlocks().b;
+      ok = ok && fread(blocks.data(), sizeof(blocks), 1, f) == 1;
+      for (int x = 0; x < BLOCKS_XZ; x++)
+      for (int z = 0; z < BLOCKS_XZ; z++)
+        ok = ok && fread(&sector.flat()(x, z), sizeof(Flatland::flatland_t), 1, f) == 1;
+    });
+  }
+  fclose(f);
+  return ok;
+}
+
+// FNV-1a, over everything the compilers would upload
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t len)
+{
+  const auto* bytes = (const uint8_t*) data;
+  for (size_t i = 0; i < len; i++) hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+  return hash;
+}
+static uint64_t hash_precomp(uint64_t hash, const Precomp& pc)
+{
+  hash = hash_bytes(hash, pc.datadump.data(), pc.datadump.size() * sizeof(vertex_t));
+  hash = hash_bytes(hash, pc.packeddump.data(), pc.packeddump.size() * sizeof(terrain_vertex_t));
+  hash = hash_bytes(hash, pc.instancedump.data(), pc.instancedump.size() * sizeof(model_instance_t));
+  hash = hash_bytes(hash, pc.vertices, sizeof(pc.vertices));
+  hash = hash_bytes(hash, pc.bufferoffset, sizeof(pc.bufferoffset));
+  hash = hash_bytes(hash, pc.packed, sizeof(pc.packed));
+  hash = hash_bytes(hash, pc.packedoffset, sizeof(pc.packedoffset));
+  hash = hash_bytes(hash, pc.indices, sizeof(pc.indices));
+  return hash_bytes(hash, pc.packedindices, sizeof(pc.packedindices));
+}
+
+static bool parse_options(int argc, char** argv, bench_options_t& opt)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if      (arg == "-r" && has_value) opt.rounds  = atoi(argv[++i]);
+    else if (arg == "-t" && has_value) opt.threads = atoi(argv[++i]);
+    else if (arg == "-w" && has_value) opt.width   = atoi(argv[++i]);
+    else if (arg == "-l" && has_value) opt.lod     = atoi(argv[++i]);
+    else if (arg == "-s" && has_value) opt.sealevel = atoi(argv[++i]);
+    else if (arg == "--greedy") opt.greedy = true;
+    else if (arg == "--packed") opt.packed = true;
+    else if (arg == "--connected") opt.connected = true;
+    else if (arg == "--save" && has_value)   opt.save   = argv[++i];
+    else if (arg == "--load" && has_value)   opt.load   = argv[++i];
+    else if (arg == "--expect" && has_value) opt.expect = argv[++i];
+    else return false;
+  }
+  return opt.rounds > 0 && opt.threads > 0 && opt.width > 0
+      && opt.width + 2 <= sectors.getXZ() && opt.lod >= 0 && opt.lod < Sector::LOD_LEVELS
+      && opt.sealevel >= 0 && opt.sealevel < BLOCKS_Y;
+}
+
+int main(int argc, char** argv)
+{
+  mock_init_blocks();
+  bench_options_t opt;
+  if (parse_options(argc, argv, opt) == false)
+  {
+    fprintf(stderr, "usage: %s [-r rounds] [-t threads] [-w width] [-l lod] [-s sealevel]\n"
+                    "       [--greedy] [--packed] [--connected] [--save file | --load file]\n"
+                    "       [--expect hash]\n", argv[0]);
+    return 2;
+  }
+  if (opt.load) {
+    if (load_world(opt, opt.load) == false) {
+      fprintf(stderr, "Could not load world from %s\n", opt.load);
+      return 2;
+    }
+  }
+  else generate_hills(ORIGIN-1, ORIGIN-1, ORIGIN + opt.width, ORIGIN + opt.width,
+                      opt.sealevel);
+  if (opt.save && save_world(opt, opt.save) == false) {
+    fprintf(stderr, "Could not save world to %s\n", opt.save);
+    return 2;
+  }
+  gameconf.greedy_meshing  = opt.greedy;
+  gameconf.packed_vertices = opt.packed;
+  if (opt.connected)
+  {
+    // a tile for each set of edges that continue in the plane of the face
+    db::BlockDB::get()[test_blocks().stone].useConnectedTexture(
+    [] (const connected_textures_t& ct, uint8_t) -> short {
+      const int self = ct.blocks[4].getID();
+      return (ct.blocks[1].getID() == self) | (ct.blocks[3].getID() == self) << 1
+           | (ct.blocks[5].getID() == self) << 2 | (ct.blocks[7].getID() == self) << 3;
+    });
+  }
+
+  // one precomp per sub-mesh, reused every round like PrecompQ does
+  std::vector<std::unique_ptr<Precomp>> jobs;
+  double meshing = 0.0;
+  for (int round = 0; round < opt.rounds; round++)
+  {
+    size_t job = 0;
+    for (int sx = ORIGIN; sx < ORIGIN + opt.width; sx++)
+    for (int sz = ORIGIN; sz < ORIGIN + opt.width; sz++)
+    for (int m = 0; m < Sector::MESHES; m++, job++)
+    {
+      if (job == jobs.size())
+        jobs.push_back(std::make_unique<Precomp> (sectors(sx, sz), m));
+      else
+        jobs[job]->reset(sectors(sx, sz), m);
+      jobs[job]->lod = opt.lod;
+    }
+
+    library::Timer timer;
+    std::atomic<size_t> next {0};
+    auto worker = [&jobs, &next] {
+      PrecompThread& wset = PrecompThread::local();
+      for (size_t i = next++; i < jobs.size(); i = next++)
+      {
+        Precomp& pc = *jobs[i];
+        mesh_job(wset, pc);
+        pc.sector.release();
+      }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < opt.threads; t++) threads.emplace_back(worker);
+    worker();
+    for (auto& thr : threads) thr.join();
+    meshing += timer.getTime();
+  }
+
+  size_t vertices = 0, packed = 0, fluids = 0;
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const auto& pc : jobs)
+  {
+    vertices += pc->datadump.size();
+    packed   += pc->packeddump.size();
+    fluids   += pc->vertices[RenderConst::TX_WATER] + pc->vertices[RenderConst::TX_LAVA];
+    hash = hash_precomp(hash, *pc);
+  }
+  const int count = opt.width * opt.width;
+  const size_t bytes = vertices * sizeof(vertex_t) + packed * sizeof(terrain_vertex_t);
+  printf("mesh_bench: %d sectors, %d threads, %d rounds, lod %d, sea level %d%s%s%s\n",
+         count, opt.threads, opt.rounds, opt.lod, opt.sealevel,
+         opt.greedy ? ", greedy" : "", opt.packed ? ", packed" : "",
+         opt.connected ? ", connected" : "");
+  printf("  vertices/sector: %zu (%zu packed), %.1f KiB/sector\n",
+         (vertices + packed) / count, packed / count, bytes / 1024.0 / count);
+  printf("  fluid vertices/sector: %zu\n", fluids / count);
+  printf("  sectors/second:  %.1f (%.3f ms/sector)\n",
+         count * opt.rounds / meshing, meshing * 1e3 / (count * opt.rounds));
+  printf("  hash: %016llx\n", (unsigned long long) hash);
+
+  if (opt.expect)
+  {
+    if (strtoull(opt.expect, nullptr, 16) != hash) {
+      printf("Mesh output does not match the expected hash %s\n", opt.expect);
+      return 1;
+    }
+    printf("Mesh output matches the expected hash\n");
+  }
+  return 0;
+}
@@ -1,10 +1,12 @@
 #include "precompq.hpp"
+#include "precompiler.hpp"
 
 namespace cppcraft
 {
   PrecompQ precompq;
+  PrecompQ::~PrecompQ() = default;
 
-  void PrecompQ::add(Sector&)
+  void PrecompQ::add(Sector&, bool)
   {
 
   }
@@ -1,18 +1,35 @@
 #include "minimap.hpp"
+#include "threading.hpp"
 #include "tiles.hpp"
+#include "block.hpp"
 
 namespace cppcraft
 {
   Minimap minimap;
   TileDB  tiledb;
+  ThreadingClass mtx;
 
   Minimap::Minimap()
   {
 
+  }
+  void Minimap::roll(int, int) noexcept
+  {
+
   }
 
   void TileDB::init()
   {
     
   }
+
+  // ** the first Block *MUST* be _AIR **, just like init_blocks(),
+  // so this is called by the test mains before anything else
+  void mock_init_blocks()
+  {
+    auto& air = db::BlockDB::get().create("air");
+    air.transparent = true;
+    air.transparentSides = db::BlockData::SIDE_ALL;
+    air.setBlock(false);
+  }
 }
@@ -0,0 +1,85 @@
+#include "frame_budget.hpp"
+
+#include <chrono>
+
+#include <catch.hpp>
+using namespace cppcraft;
+
+static void busy_ms(double ms)
+{
+  const auto until = std::chrono::steady_clock::now()
+      + std::chrono::microseconds(int64_t(ms * 1000.0));
+  while (std::chrono::steady_clock::now() < until);
+}
+
+TEST_CASE("Frame budget shares the round by backlog")
+{
+  enum { A, B };
+  FrameBudget fb({{"A", true}, {"B", false}});
+  int calls[2] = {0, 0};
+  auto round = [&] (double available) {
+    fb.begin(available);
+    fb.run(A, [&] { calls[A]++; busy_ms(1.0); return true; });
+    fb.run(B, [&] { calls[B]++; busy_ms(1.0); return true; });
+    fb.end();
+  };
+
+  // nothing waiting, nothing runs
+  round(10.0);
+  REQUIRE(calls[A] == 0);
+  REQUIRE(calls[B] == 0);
+  REQUIRE(fb.counters(A).budget_ms == 0.0);
+
+  // before they are measured, the stages share evenly
+  fb.backlog(A, 100);
+  fb.backlog(B, 1);
+  round(40.0);
+  REQUIRE(fb.counters(A).budget_ms == Approx(20.0));
+  REQUIRE(calls[A] > 1);
+  REQUIRE(calls[A] <= 20);
+  REQUIRE(calls[B] == 1);
+  REQUIRE(fb.counters(A).cost_ms >= 1.0);
+
+  // and then by the time their backlogs would take
+  round(40.0);
+  REQUIRE(fb.counters(A).budget_ms > 36.0);
+  REQUIRE(fb.counters(A).calls > 1);
+  REQUIRE(fb.work(A) == Approx(100 * fb.counters(A).cost_ms));
+}
+
+TEST_CASE("Frame budget gives the time a stage didn't use to the next one")
+{
+  enum { A, B };
+  FrameBudget fb({{"A", true}, {"B", true}});
+  fb.backlog(A, 100);
+  fb.backlog(B, 100);
+  int calls[2] = {0, 0};
+  fb.begin(40.0);
+  // A runs out of work after one call, long before its half of the round
+  fb.run(A, [&] { calls[A]++; busy_ms(1.0); return false; });
+  fb.run(B, [&] { calls[B]++; busy_ms(1.0); return true; });
+  fb.end();
+
+  REQUIRE(calls[A] == 1);
+  REQUIRE(fb.counters(A).budget_ms == Approx(20.0));
+  REQUIRE(fb.counters(B).budget_ms > 30.0);
+  REQUIRE(calls[B] > 20);
+  REQUIRE(fb.counters(A).spent_ms + fb.counters(B).spent_ms <= 41.0);
+}
+
+TEST_CASE("Frame budget runs a starved stage once in a while")
+{
+  FrameBudget fb({{"Once", false}});
+  int calls = 0;
+  fb.backlog(0, 1);
+  for (int i = 0; i < FrameBudget::STARVED; i++)
+  {
+    // no time at all
+    fb.begin(0.0);
+    fb.run(0, [&calls] { calls++; return true; });
+    fb.end();
+    if (i < FrameBudget::STARVED-1) REQUIRE(calls == 0);
+  }
+  REQUIRE(calls == 1);
+  REQUIRE(fb.counters(0).skipped == FrameBudget::STARVED-1);
+}
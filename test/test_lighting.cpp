@@ -1,6 +1,8 @@
 #include "lighting.hpp"
 #include "sectors.hpp"
 #include "spiders.hpp"
+#include <library/timing/timer.hpp>
+#include <vector>
 
 #include <catch.hpp>
 using namespace cppcraft;
@@ -96,6 +98,8 @@ TEST_CASE("Various light filling tests")
 
   // place block right on sunray
   Spiders::setBlock(16, START_Y, 16, Block(SOLID));
+  // skylight removal is deferred
+  Lighting::handleDeferred();
   for (int x = 0; x < 32; x++)
   for (int z = 0; z < 32; z++)
   for (int y = START_Y; y >= 1; y--) {
@@ -103,3 +107,145 @@ TEST_CASE("Various light filling tests")
   }
 
 }
+
+// fills a 5x5 area of sectors with air, and scatters lights in the center 3x3
+static void torch_world(int SX, int SZ, block_t light_id, int lights)
+{
+  for (int sx = SX-2; sx <= SX+2; sx++)
+  for (int sz = SZ-2; sz <= SZ+2; sz++)
+  {
+    auto& sector = sectors(sx, sz);
+    for (auto& blk : sector.getBlocks().b) blk = Block(_AIR);
+    sector.getBlocks().clearTorchColors();
+    sector.getBlocks().clearLights();
+    sector.getBlocks().highest_light_y = 0;
+    close_sector(sector);
+  }
+  // deterministic placement
+  uint32_t seed = 1234;
+  for (int sx = SX-1; sx <= SX+1; sx++)
+  for (int sz = SZ-1; sz <= SZ+1; sz++)
+  {
+    auto& sector = sectors(sx, sz);
+    for (int i = 0; i < lights; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      const int x = (seed >> 8) & 15;
+      const int z = (seed >> 12) & 15;
+      const int y = 1 + ((seed >> 16) % 62);
+      sector(x, y, z) = Block(light_id);
+      sector.getBlocks().addLight(x, y, z);
+    }
+  }
+}
+static void torch_flood(int SX, int SZ)
+{
+  for (int sx = SX-1; sx <= SX+1; sx++)
+  for (int sz = SZ-1; sz <= SZ+1; sz++)
+    Lighting::torchlight(sectors(sx, sz));
+}
+
+TEST_CASE("Colored torchlight matches single-channel torchlight")
+{
+  auto& db = db::BlockDB::get();
+  // creating blocks can move the database storage, so keep IDs only
+  const block_t WHITE = db.create("white_light").getID();
+  db[WHITE].transparent = true;
+  db[WHITE].setLightColor(14, 14, 14);
+  const block_t RED = db.create("red_light").getID();
+  db[RED].transparent = true;
+  db[RED].setLightColor(12, 0, 0);
+
+  static const int SX = 8, SZ = 8;
+  torch_world(SX, SZ, WHITE, 4);
+  Lighting::setColoredTorchlight(false);
+  torch_flood(SX, SZ);
+  // remember the single-channel result
+  std::vector<Block::light_t> mono;
+  for (int sx = SX-2; sx <= SX+2; sx++)
+  for (int sz = SZ-2; sz <= SZ+2; sz++)
+    for (auto& blk : sectors(sx, sz).getBlocks().b)
+      mono.push_back(blk.getTorchLight());
+
+  torch_world(SX, SZ, WHITE, 4);
+  Lighting::setColoredTorchlight(true);
+  torch_flood(SX, SZ);
+  size_t i = 0;
+  for (int sx = SX-2; sx <= SX+2; sx++)
+  for (int sz = SZ-2; sz <= SZ+2; sz++)
+  {
+    auto& sb = sectors(sx, sz).getBlocks();
+    for (int x = 0; x < Sector::BLOCKS_XZ; x++)
+    for (int z = 0; z < Sector::BLOCKS_XZ; z++)
+    for (int y = 0; y < Sector::BLOCKS_Y; y++)
+    {
+      const auto color = sb.torchColor(x, y, z);
+      // white light has the same level in all lanes
+      REQUIRE(color == LightColor::gray(LightColor::red(color)));
+      REQUIRE(sb(x, y, z).getTorchLight() == LightColor::intensity(color));
+    }
+    // x, z, y order is the same as the block array
+    for (auto& blk : sb.b) REQUIRE(blk.getTorchLight() == mono.at(i++));
+  }
+
+  // pure red light never leaks into the other lanes
+  torch_world(SX, SZ, RED, 2);
+  torch_flood(SX, SZ);
+  int lit = 0;
+  auto& sb = sectors(SX, SZ).getBlocks();
+  for (int x = 0; x < Sector::BLOCKS_XZ; x++)
+  for (int z = 0; z < Sector::BLOCKS_XZ; z++)
+  for (int y = 1; y < 64; y++)
+  {
+    const auto color = sb.torchColor(x, y, z);
+    REQUIRE(LightColor::green(color) == 0);
+    REQUIRE(LightColor::blue(color) == 0);
+    if (color) lit++;
+  }
+  REQUIRE(lit > 0);
+  Lighting::setColoredTorchlight(false);
+}
+
+TEST_CASE("Flooding into a block pulls light from every side")
+{
+  auto& sector = sectors(8, 8);
+  for (auto& blk : sector.getBlocks().b) blk = Block(_AIR);
+  const int X = 7, Y = 40, Z = 7;
+  const int offsets[6][3] = {
+    {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+  };
+  for (const auto& off : offsets)
+  {
+    INFO("lit neighbor at " << off[0] << ", " << off[1] << ", " << off[2]);
+    for (auto& blk : sector.getBlocks().b) blk.setTorchLight(0);
+    sector(X + off[0], Y + off[1], Z + off[2]).setTorchLight(10);
+    Lighting::floodInto(&sector, X, Y, Z, 1);
+    REQUIRE(sector(X, Y, Z).getTorchLight() == 9);
+  }
+}
+
+TEST_CASE("Colored torchlight benchmark", "[.][benchmark]")
+{
+  auto& db = db::BlockDB::get();
+  auto& warm = db.create("warm_light");
+  warm.transparent = true;
+  warm.setLightColor(14, 11, 6);
+
+  static const int SX = 20, SZ = 20;
+  static const int ROUNDS = 5;
+  double times[2] = {0.0, 0.0};
+  for (int round = 0; round < ROUNDS; round++)
+  for (int colored = 0; colored < 2; colored++)
+  {
+    torch_world(SX, SZ, warm.getID(), 24);
+    Lighting::setColoredTorchlight(colored);
+    library::Timer timer;
+    torch_flood(SX, SZ);
+    times[colored] += timer.getTime();
+  }
+  Lighting::setColoredTorchlight(false);
+  printf("Torchlight: single-channel %.2f ms, colored %.2f ms (%.2fx)\n",
+         times[0] * 1000.0 / ROUNDS, times[1] * 1000.0 / ROUNDS, times[1] / times[0]);
+  // colored light must stay within 1.5x of the single-channel cost
+  REQUIRE(times[1] < times[0] * 1.5);
+}
@@ -0,0 +1,382 @@
+#include "fixtures.hpp"
+#include "spiders.hpp"
+#include <library/timing/timer.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <catch.hpp>
+using namespace cppcraft;
+using namespace fixtures;
+
+// synthetic worlds are built around this sector, with a ring of padding
+// sectors around the 3x3 center so that light can spill over the edges
+static const int CX = 26, CZ = 26;
+static const int PAD = 2;
+
+static const scene_t SCENES[] = {
+  {"caves",         true,  false, false, 8},
+  {"overhangs",     false, true,  false, 4},
+  {"dense torches", true,  true,  false, 64},
+  {"water",         true,  false, true,  8},
+};
+
+template <typename F>
+static void for_center(F func)
+{
+  for_sectors(CX-1, CZ-1, CX+1, CZ+1, func);
+}
+template <typename F>
+static void for_region(F func)
+{
+  for_sectors(CX-PAD, CZ-PAD, CX+PAD, CZ+PAD, func);
+}
+
+static void generate_scene(const scene_t& scene)
+{
+  generate_scene(scene, CX, CZ, PAD);
+}
+static void flood_scene()
+{
+  flood_sectors(CX-1, CZ-1, CX+1, CZ+1);
+}
+
+static std::vector<Block::light_t> snapshot()
+{
+  std::vector<Block::light_t> result;
+  for_region(
+  [&result] (Sector& sector) {
+    for (auto& blk : sector.getBlocks().b) result.push_back(blk.getChannel(0) | blk.getChannel(1) << 4);
+  });
+  return result;
+}
+static int count_differences(const std::vector<Block::light_t>& a,
+                             const std::vector<Block::light_t>& b)
+{
+  int diff = 0;
+  for (size_t i = 0; i < a.size(); i++) diff += (a[i] != b[i]);
+  return diff;
+}
+
+// every lit block must be explained by a brighter neighbor or a light source,
+// and nothing can be brighter than the source that lit it
+static void check_light_invariants(const scene_t& scene)
+{
+  INFO("Scene: " << scene.name);
+  static const int dx[6] = {1, -1, 0, 0, 0, 0};
+  static const int dy[6] = {0, 0, 1, -1, 0, 0};
+  static const int dz[6] = {0, 0, 0, 0, 1, -1};
+  int failures = 0;
+
+  for_center(
+  [&failures] (Sector& sector)
+  {
+    for (int bx = 0; bx < BLOCKS_XZ; bx++)
+    for (int bz = 0; bz < BLOCKS_XZ; bz++)
+    {
+      const int x = sector.getX() * BLOCKS_XZ + bx;
+      const int z = sector.getZ() * BLOCKS_XZ + bz;
+      const int sky = sector.flat()(bx, bz).skyLevel;
+
+      for (int y = 1; y < BLOCKS_Y-1; y++)
+      {
+        const Block& blk = block_at(x, y, z);
+        if (blk.getChannel(1) > TORCH_LEVEL) failures++;
+        if (blk.isLight()) {
+          if (blk.getChannel(1) != blk.getLightLevel()) failures++;
+        }
+        // above the skylevel everything is fully lit
+        if (y >= sky) {
+          if (blk.getSkyLight() != Block::SKYLIGHT_MAX) failures++;
+        }
+
+        for (int ch = 0; ch < Block::CHANNELS; ch++)
+        {
+          const int level = blk.getChannel(ch);
+          if (level == 0) continue;
+          if (ch == 0 && y >= sky) continue;
+          if (ch == 1 && blk.isLight()) continue;
+          // monotone decay: some neighbor must be brighter by at least the cost of entering
+          bool supported = false;
+          for (int dir = 0; dir < 6; dir++)
+          {
+            const Block& nb = block_at(x + dx[dir], y + dy[dir], z + dz[dir]);
+            if (nb.getChannel(ch) - Lighting::lightPenetrate(blk) >= level) {
+              supported = true; break;
+            }
+          }
+          if (!supported) {
+            if (failures < 5)
+                printf("Unsupported light ch=%d lvl=%d at (%d, %d, %d)\n", ch, level, x, y, z);
+            failures++;
+          }
+        }
+      }
+    }
+  });
+  REQUIRE(failures == 0);
+}
+
+TEST_CASE("Lighting invariants on synthetic worlds")
+{
+  for (const auto& scene : SCENES)
+  {
+    generate_scene(scene);
+    flood_scene();
+    check_light_invariants(scene);
+  }
+}
+
+TEST_CASE("Single torch decays by one per block in open air")
+{
+  const auto& tb = test_blocks();
+  for (int colored = 0; colored < 2; colored++)
+  {
+    generate_scene({"empty", false, false, false, 0});
+    // darken everything, so that only the torch is visible
+    for_region(
+    [] (Sector& sector) {
+      for (auto& blk : sector.getBlocks().b) blk = Block(_AIR);
+      sector.getBlocks().clearTorchColors();
+    });
+    const int TX = CX * BLOCKS_XZ + 7, TY = 100, TZ = CZ * BLOCKS_XZ + 9;
+    auto& center = sectors(CX, CZ);
+    center(7, TY, 9) = Block(tb.torch);
+    center.getBlocks().addLight(7, TY, 9);
+    Lighting::setColoredTorchlight(colored);
+    Lighting::torchlight(center);
+    Lighting::setColoredTorchlight(false);
+
+    for (int x = TX - 16; x <= TX + 16; x++)
+    for (int z = TZ - 16; z <= TZ + 16; z++)
+    for (int y = TY - 16; y <= TY + 16; y++)
+    {
+      const int dist = abs(x - TX) + abs(y - TY) + abs(z - TZ);
+      const int expected = std::max(0, TORCH_LEVEL - dist);
+      INFO("colored " << colored << " at " << x-TX << ", " << y-TY << ", " << z-TZ);
+      REQUIRE(block_at(x, y, z).getTorchLight() == expected);
+    }
+  }
+}
+
+TEST_CASE("Removing and re-adding blocks restores lighting")
+{
+  const auto& tb = test_blocks();
+  int torches = 0;
+  for (const auto& scene : SCENES)
+  {
+    INFO("Scene: " << scene.name);
+    generate_scene(scene);
+    flood_scene();
+
+    // remove and put back every torch in the center sector
+    auto& center = sectors(CX, CZ);
+    for (int x = 0; x < BLOCKS_XZ; x++)
+    for (int z = 0; z < BLOCKS_XZ; z++)
+    for (int y = 1; y < BLOCKS_Y-1; y++)
+    if (center(x, y, z).getID() == tb.torch)
+    {
+      const auto before = snapshot();
+      Spiders::removeBlock(center, x, y, z);
+      Spiders::setBlock(center, x, y, z, Block(tb.torch));
+      Lighting::handleDeferred();
+      REQUIRE(count_differences(before, snapshot()) == 0);
+      torches++;
+    }
+
+    // remove and put back a few surface blocks, changing the skylevel
+    for (int i = 0; i < 8; i++)
+    {
+      const int x = (i * 5) & 15, z = (i * 11) & 15;
+      const int y = center.flat()(x, z).skyLevel - 1;
+      if (center(x, y, z).getID() != tb.stone) continue;
+
+      const auto before = snapshot();
+      Spiders::removeBlock(center, x, y, z);
+      Spiders::setBlock(center, x, y, z, Block(tb.stone));
+      Lighting::handleDeferred();
+      REQUIRE(count_differences(before, snapshot()) == 0);
+    }
+  }
+  REQUIRE(torches > 0);
+}
+
+TEST_CASE("Blocking off covered light leaves no stale light behind")
+{
+  const auto& tb = test_blocks();
+  const scene_t& scene = SCENES[1]; // overhangs
+  generate_scene(scene);
+  flood_scene();
+
+  // fill lit air below the overhangs, which only ever had skylight from the sides
+  int placed = 0;
+  for_center(
+  [&tb, &placed] (Sector& sector) {
+    for (int x = 0; x < BLOCKS_XZ; x++)
+    for (int z = 0; z < BLOCKS_XZ; z++)
+    {
+      const int sky = sector.flat()(x, z).skyLevel;
+      for (int y = 2; y < sky; y++)
+      if (sector(x, y, z).isAir() && sector(x, y, z).getSkyLight() > 2
+       && sector(x, y, z).getTorchLight() == 0)
+      {
+        Spiders::setBlock(sector, x, y, z, Block(tb.stone));
+        placed++;
+        break;
+      }
+    }
+  });
+  Lighting::handleDeferred();
+  REQUIRE(placed > 0);
+  check_light_invariants(scene);
+}
+
+TEST_CASE("Covering and uncovering water restores the light in it")
+{
+  const auto& tb = test_blocks();
+  const scene_t& scene = SCENES[3]; // water
+  generate_scene(scene);
+  flood_scene();
+
+  auto& center = sectors(CX, CZ);
+  int covered = 0;
+  for (int i = 0; i < 16; i++)
+  {
+    const int x = (i * 5) & 15, z = (i * 11) & 15;
+    const int y = center.flat()(x, z).skyLevel;
+    if (center(x, y-1, z).getID() != tb.water) continue;
+
+    const auto before = snapshot();
+    Spiders::setBlock(center, x, y, z, Block(tb.stone));
+    Lighting::handleDeferred();
+    Spiders::removeBlock(center, x, y, z);
+    REQUIRE(count_differences(before, snapshot()) == 0);
+    covered++;
+  }
+  REQUIRE(covered > 0);
+}
+
+TEST_CASE("Placing water in covered light lets the light back in")
+{
+  const auto& tb = test_blocks();
+  static const int dx[6] = {1, -1, 0, 0, 0, 0};
+  static const int dy[6] = {0, 0, 1, -1, 0, 0};
+  static const int dz[6] = {0, 0, 0, 0, 1, -1};
+  const scene_t& scene = SCENES[1]; // overhangs
+  generate_scene(scene);
+  flood_scene();
+
+  struct position_t { int x, y, z; };
+  std::vector<position_t> placed;
+  // every other column, to stay below the removals done per frame
+  for_center(
+  [&tb, &placed] (Sector& sector) {
+    for (int x = 0; x < BLOCKS_XZ; x += 2)
+    for (int z = 0; z < BLOCKS_XZ; z += 2)
+    {
+      const int sky = sector.flat()(x, z).skyLevel;
+      for (int y = 2; y < sky; y++)
+      if (sector(x, y, z).isAir() && sector(x, y, z).getSkyLight() > 2
+       && sector(x, y, z).getTorchLight() == 0)
+      {
+        Spiders::setBlock(sector, x, y, z, Block(tb.water));
+        placed.push_back({sector.getX() * BLOCKS_XZ + x, y, sector.getZ() * BLOCKS_XZ + z});
+        break;
+      }
+    }
+  });
+  Lighting::handleDeferred();
+  REQUIRE(!placed.empty());
+
+  // the water takes the light of its brightest neighbor, minus its own penetration
+  for (auto& pos : placed)
+  {
+    const Block& water = block_at(pos.x, pos.y, pos.z);
+    int brightest = 0;
+    for (int dir = 0; dir < 6; dir++)
+      brightest = std::max(brightest,
+          (int) block_at(pos.x + dx[dir], pos.y + dy[dir], pos.z + dz[dir]).getSkyLight());
+    const int expected = std::max(0, brightest - (int) Lighting::lightPenetrate(water));
+    INFO("Water at " << pos.x << ", " << pos.y << ", " << pos.z);
+    REQUIRE(water.getSkyLight() == expected);
+  }
+  check_light_invariants(scene);
+}
+
+/// throughput ///
+
+static void clear_torchlight()
+{
+  for_region(
+  [] (Sector& sector) {
+    for (auto& blk : sector.getBlocks().b) blk.setTorchLight(0);
+  });
+}
+static void report(const char* what, double blocks, double seconds)
+{
+  printf("%-18s %8.2f ms  %10.0f blocks/s\n",
+         what, seconds * 1000.0, blocks / seconds);
+}
+static const double CENTER_BLOCKS = 9.0 * BLOCKS_XZ * BLOCKS_XZ * BLOCKS_Y;
+
+TEST_CASE("Lighting throughput", "[.][benchmark]")
+{
+  static const int ROUNDS = 4;
+  for (const auto& scene : SCENES)
+  {
+    printf("--- %s ---\n", scene.name);
+    double t_atmos = 0.0, t_torch = 0.0;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+      generate_scene(scene);
+      library::Timer timer;
+      flood_scene();
+      t_atmos += timer.getTime();
+
+      clear_torchlight();
+      timer.restart();
+      for_center([] (Sector& sector) { Lighting::torchlight(sector); });
+      t_torch += timer.getTime();
+    }
+    report("atmosphericFlood", CENTER_BLOCKS, t_atmos / ROUNDS);
+    report("torchlight", CENTER_BLOCKS, t_torch / ROUNDS);
+
+    // re-flood every torch, counting the blocks that got lit
+    clear_torchlight();
+    struct position_t { int x, y, z; };
+    std::vector<position_t> torches;
+    const block_t TORCH = test_blocks().torch;
+    for_center(
+    [&torches, TORCH] (Sector& sector) {
+      for (int x = 0; x < BLOCKS_XZ; x++)
+      for (int z = 0; z < BLOCKS_XZ; z++)
+      for (int y = 1; y < BLOCKS_Y-1; y++)
+      if (sector(x, y, z).getID() == TORCH) {
+        sector(x, y, z).setTorchLight(TORCH_LEVEL);
+        torches.push_back({sector.getX() * BLOCKS_XZ + x, y, sector.getZ() * BLOCKS_XZ + z});
+      }
+    });
+    if (!torches.empty())
+    {
+      const auto before = snapshot();
+      library::Timer timer;
+      for (auto& pos : torches)
+        Lighting::floodOutof(pos.x, pos.y, pos.z, 1, TORCH_LEVEL);
+      const double t_flood = timer.getTime();
+      report("floodOutof", count_differences(before, snapshot()), t_flood);
+    }
+
+    // cover the surface with blocks, then time the deferred skylight removal
+    {
+      auto& center = sectors(CX, CZ);
+      const auto before = snapshot();
+      for (int x = 0; x < BLOCKS_XZ; x++)
+      for (int z = 0; z < BLOCKS_XZ; z++)
+        Spiders::setBlock(center, x, center.flat()(x, z).skyLevel + 2, z, Block(test_blocks().stone));
+      library::Timer timer;
+      Lighting::handleDeferred();
+      const double t_deferred = timer.getTime();
+      report("deferredRemove", count_differences(before, snapshot()), t_deferred);
+    }
+  }
+}
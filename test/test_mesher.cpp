@@ -0,0 +1,915 @@
+#include "blocks_vfaces.hpp"
+#include "fixtures.hpp"
+#include "precomp_facemask.hpp"
+#include "sun.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <vector>
+
+#include <library/timing/timer.hpp>
+#include <catch.hpp>
+using namespace cppcraft;
+using namespace fixtures;
+
+namespace cppcraft {
+  extern vertex_t* expandCross(const model_instance_t&, std::vector<vertex_t>&);
+}
+
+// synthetic terrain is meshed around this sector, with one ring of neighbors
+static const int MX = 14, MZ = 14;
+// a sealed room under the center sector
+static const int CAVE_X0 = 4, CAVE_X1 = 11;
+static const int CAVE_Y0 = 10, CAVE_Y1 = 14;
+
+// the mesher settings a test changes, put back even when a REQUIRE fails
+struct mesher_settings_t
+{
+  mesher_settings_t()
+    : greedy(gameconf.greedy_meshing), packed(gameconf.packed_vertices),
+      instanced(gameconf.instanced_models), colored(Lighting::coloredTorchlight()),
+      torch(db::BlockDB::get()[test_blocks().torch].opacity) {}
+  ~mesher_settings_t()
+  {
+    gameconf.greedy_meshing   = greedy;
+    gameconf.packed_vertices  = packed;
+    gameconf.instanced_models = instanced;
+    Lighting::setColoredTorchlight(colored);
+    db::BlockDB::get()[test_blocks().torch].opacity = torch;
+  }
+  const bool greedy, packed, instanced, colored;
+  const uint16_t torch;
+};
+
+static inline int terrain_height(int wx, int wz)
+{
+  return 40 + ((wx * 7 + wz * 13) >> 3) % 6;
+}
+// the sub-mesh with most of the surface
+static const int SURFACE_MESH = 40 / Sector::MESH_LAYERS;
+
+// wide terraces, where most of the surface is flat
+static inline int terrace_height(int wx, int wz)
+{
+  return 40 + ((wx >> 3) + (wz >> 3)) % 3;
+}
+
+static void generate_terrain(int (*height)(int, int) = terrain_height)
+{
+  generate_columns(MX-1, MZ-1, MX+1, MZ+1, height);
+  // hollow out the room, with one torch in it
+  auto& center = sectors(MX, MZ);
+  for (int x = CAVE_X0; x <= CAVE_X1; x++)
+  for (int z = CAVE_X0; z <= CAVE_X1; z++)
+  for (int y = CAVE_Y0; y <= CAVE_Y1; y++)
+    center(x, y, z) = Block(_AIR);
+  center(CAVE_X0, CAVE_Y0, CAVE_X0) = Block(test_blocks().torch);
+  center.getBlocks().addLight(CAVE_X0, CAVE_Y0, CAVE_X0);
+  flood_sectors(MX-1, MZ-1, MX+1, MZ+1);
+}
+
+static inline bool inside_cave(const vertex_t& v)
+{
+  const int S = RenderConst::VERTEX_SCALE;
+  return v.x >= CAVE_X0 * S && v.x <= (CAVE_X1+1) * S
+      && v.z >= CAVE_X0 * S && v.z <= (CAVE_X1+1) * S
+      && v.y >= CAVE_Y0 * S && v.y <= (CAVE_Y1+1) * S;
+}
+
+// sets the sun to stand at the given angle, right away
+static void set_time_of_day(float radians)
+{
+  thesun.init(radians);
+  thesun.integrate(1.0f);
+}
+
+TEST_CASE("Terrain meshes carry raw light levels, independent of time of day")
+{
+  const float PI = 4 * atan(1);
+  generate_terrain();
+  auto& center = sectors(MX, MZ);
+  // noon
+  set_time_of_day(PI / 2);
+  const float noon = thesun.getRealtimeDaylight();
+  const auto mesh = mesh_sector(center);
+  REQUIRE(!mesh.empty());
+  REQUIRE(mesh.size() % 4 == 0);
+
+  int open_tops = 0, cave_faces = 0, torch_lit = 0;
+  for (const auto& v : mesh)
+  {
+    const int sky   = v.light & 0xFF;
+    const int torch = v.light >> 8;
+    if (inside_cave(v))
+    {
+      // no skylight reaches the sealed room, at any time of day
+      REQUIRE(sky == 0);
+      cave_faces++;
+      if (torch > 0) torch_lit++;
+    }
+    else if (v.ny > 0 && v.y >= 40 * RenderConst::VERTEX_SCALE)
+    {
+      // the surface sees the sky: full level, without any falloff baked in
+      REQUIRE(sky == 15 * 17);
+      open_tops++;
+    }
+    REQUIRE(torch <= TORCH_LEVEL * 17);
+  }
+  REQUIRE(open_tops > 0);
+  REQUIRE(cave_faces > 0);
+  REQUIRE(torch_lit > 0);
+
+  // meshing again at midnight gives the exact same bytes
+  set_time_of_day(-PI / 2);
+  REQUIRE(thesun.getRealtimeDaylight() != noon);
+  const auto night = mesh_sector(center);
+  REQUIRE(night.size() == mesh.size());
+  REQUIRE(memcmp(night.data(), mesh.data(), mesh.size() * sizeof(vertex_t)) == 0);
+}
+
+// one unit cell of a rasterized face, with what it looks like there
+struct raster_cell_t
+{
+  // everything but the position, texture coordinates and face,
+  // at each corner of the cell (+a is bit 0, and +b is bit 1)
+  vertex_t attr[4];
+  int u, v;      // texture coordinates at the cell origin, modulo one tile
+  int coverage;
+};
+typedef std::tuple<int, int, int, int> raster_key_t; // normal axis + sign, plane, a, b
+
+static inline int axis_coord(const vertex_t& v, int axis)
+{
+  return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+}
+static inline int wrap_tile(int x)
+{
+  return x & (RenderConst::VERTEX_SCALE-1);
+}
+
+// splits every axis-aligned quad into unit cells
+static std::map<raster_key_t, raster_cell_t> rasterize(const std::vector<vertex_t>& mesh)
+{
+  static const int AXIS_A[3] = {2, 0, 0};
+  static const int AXIS_B[3] = {1, 2, 1};
+  const int S = RenderConst::VERTEX_SCALE;
+  std::map<raster_key_t, raster_cell_t> result;
+
+  for (size_t i = 0; i < mesh.size(); i += 4)
+  {
+    const vertex_t* q = &mesh[i];
+    const int n = (q->nx != 0) ? 0 : ((q->ny != 0) ? 1 : 2);
+    const int sign = (n == 0) ? q->nx : ((n == 1) ? q->ny : q->nz);
+    const int A = AXIS_A[n], B = AXIS_B[n];
+    int a0 = 1 << 30, b0 = 1 << 30, a1 = -a0, b1 = -b0;
+    for (int k = 0; k < 4; k++) {
+      a0 = std::min(a0, axis_coord(q[k], A)); a1 = std::max(a1, axis_coord(q[k], A));
+      b0 = std::min(b0, axis_coord(q[k], B)); b1 = std::max(b1, axis_coord(q[k], B));
+    }
+    // texture coordinates are affine over the quad
+    vertex_t corner[4];
+    for (int k = 0; k < 4; k++) {
+      const int a = axis_coord(q[k], A), b = axis_coord(q[k], B);
+      corner[(a == a1) | (b == b1) << 1] = q[k];
+    }
+    const vertex_t *v00 = &corner[0], *v10 = &corner[1], *v01 = &corner[2];
+    const int cells_a = (a1 - a0) / S, cells_b = (b1 - b0) / S;
+    REQUIRE(cells_a > 0);
+    REQUIRE(cells_b > 0);
+    vertex_t attr[4];
+    for (int c = 0; c < 4; c++) {
+      attr[c] = corner[c];
+      attr[c].x = attr[c].y = attr[c].z = attr[c].u = attr[c].v = attr[c].face = 0;
+    }
+    // the attributes at a corner of a cell: inside the quad, the quad corners
+    // on both sides must agree, since interpolating would blend them
+    auto attr_at = [&attr, cells_a, cells_b] (int ia, int ib, bool& exact) -> vertex_t {
+      const int sa0 = (ia == cells_a) ? 1 : 0, sa1 = (ia == 0) ? 0 : 1;
+      const int sb0 = (ib == cells_b) ? 1 : 0, sb1 = (ib == 0) ? 0 : 1;
+      for (int sa = sa0; sa <= sa1; sa++)
+      for (int sb = sb0; sb <= sb1; sb++)
+        if (memcmp(&attr[sa | sb << 1], &attr[sa0 | sb0 << 1], sizeof(vertex_t)) != 0)
+            exact = false;
+      return attr[sa0 | sb0 << 1];
+    };
+
+    for (int cb = 0; cb < cells_b; cb++)
+    for (int ca = 0; ca < cells_a; ca++)
+    {
+      const raster_key_t key {n * 2 + (sign < 0), axis_coord(*q, n), a0 / S + ca, b0 / S + cb};
+      auto& cell = result[key];
+      bool exact = true;
+      for (int c = 0; c < 4; c++)
+        cell.attr[c] = attr_at(ca + (c & 1), cb + (c >> 1), exact);
+      // a blended corner never matches a unit quad
+      if (!exact) cell.coverage += 1000;
+      cell.u = wrap_tile(v00->u + ca * (v10->u - v00->u) / cells_a + cb * (v01->u - v00->u) / cells_b);
+      cell.v = wrap_tile(v00->v + ca * (v10->v - v00->v) / cells_a + cb * (v01->v - v00->v) / cells_b);
+      cell.coverage++;
+    }
+  }
+  return result;
+}
+
+// the number of unit cells that look different, optionally ignoring the texture
+static int coverage_mismatches(const std::vector<vertex_t>& plain,
+                               const std::vector<vertex_t>& merged, bool texcoords)
+{
+  const auto before = rasterize(plain);
+  const auto after  = rasterize(merged);
+  REQUIRE(before.size() == after.size());
+  int mismatches = 0;
+  for (const auto& it : before)
+  {
+    auto found = after.find(it.first);
+    if (found == after.end()) { mismatches++; continue; }
+    const auto& a = it.second;
+    const auto& b = found->second;
+    if (b.coverage != a.coverage || (texcoords && (b.u != a.u || b.v != a.v))
+     || memcmp(a.attr, b.attr, sizeof(a.attr)) != 0) mismatches++;
+  }
+  return mismatches;
+}
+
+static void compare_greedy(const char* name)
+{
+  auto& center = sectors(MX, MZ);
+  gameconf.greedy_meshing = false;
+  const auto plain = mesh_sector(center);
+  gameconf.greedy_meshing = true;
+  const auto greedy = mesh_sector(center);
+
+  INFO("Greedy meshing: " << name);
+  REQUIRE(greedy.size() % 4 == 0);
+  REQUIRE(greedy.size() < plain.size());
+  REQUIRE(coverage_mismatches(plain, greedy, true) == 0);
+}
+
+TEST_CASE("Greedy meshing keeps the rasterized coverage")
+{
+  mesher_settings_t settings;
+  generate_terrain();
+  compare_greedy("rough terrain");
+  generate_terrain(terrace_height);
+  compare_greedy("terraces");
+}
+
+// the mesher before face masks: every block tests its own neighbors
+static std::vector<vertex_t> mesh_sector_per_block(Sector& sector)
+{
+  std::vector<vertex_t> mesh;
+  for (int m = 0; m < Sector::MESHES; m++)
+  {
+    std::unique_ptr<Precomp> pc(new Precomp(sector, m));
+    std::unique_ptr<PrecompThread> pt(new PrecompThread);
+    pt->ptd.sector = &pc->sector;
+    for (int bx = 0; bx < BLOCKS_XZ; bx++)
+    for (int bz = 0; bz < BLOCKS_XZ; bz++)
+    for (int by = pc->y0(); by < std::min(pc->y1(), (int) pc->sector(bx, bz).skyLevel); by++)
+    {
+      const Block& block = pc->sector(bx, by, bz);
+      if (block.getID() != _AIR) pt->ptd.process_block(block, bx, by, bz);
+    }
+    for (const auto& vec : pt->ptd.vertices)
+      pc->datadump.insert(pc->datadump.end(), vec.begin(), vec.end());
+    pt->ambientOcclusion(*pc);
+    mesh.insert(mesh.end(), pc->datadump.begin(), pc->datadump.end());
+  }
+  return mesh;
+}
+
+// a clump of special blocks in the middle of the center sector
+static void plant_leaves()
+{
+  auto& center = sectors(MX, MZ);
+  for (int x = 6; x < 10; x++)
+  for (int z = 6; z < 10; z++)
+  for (int y = 46; y < 50; y++)
+    center(x, y, z) = Block(test_blocks().leaf);
+  for (int x = 6; x < 10; x++)
+  for (int z = 6; z < 10; z++)
+    center.flat()(x, z).skyLevel = 50;
+}
+
+TEST_CASE("Face masks agree with the per-block visibility test")
+{
+  mesher_settings_t settings;
+  generate_terrain();
+  plant_leaves();
+  auto& center = sectors(MX, MZ);
+  std::unique_ptr<Precomp> pc(new Precomp(center, 0));
+  std::unique_ptr<facemask_t> masks(new facemask_t);
+  auto& bsb = pc->sector;
+
+  // with the whole height scanned, with only what the mesher scans,
+  // and with the layers of a sub-mesh (which includes the leaves)
+  const int ranges[3][2] = {{0, BLOCKS_Y}, {0, 51}, {40, 51}};
+  for (const auto& range : ranges)
+  {
+    const int bottom = range[0], height = range[1];
+    masks->build(bsb, bottom, height);
+    int cubes = 0, special = 0;
+    for (int bx = 0; bx < BLOCKS_XZ; bx++)
+    for (int bz = 0; bz < BLOCKS_XZ; bz++)
+    {
+      facemask_t::column_t visible;
+      masks->visible(bx, bz, visible);
+      // the top scanned row sees air above it
+      const int top = (height == BLOCKS_Y) ? BLOCKS_Y : height - 1;
+      for (int by = bottom; by < top; by++)
+      {
+        const Block& block = bsb(bx, by, bz);
+        const bool is_visible = (visible[by / 64] >> (by % 64)) & 1;
+        const bool is_special = (masks->special(bx, bz)[by / 64] >> (by % 64)) & 1;
+        if (block.getID() == _AIR) {
+          REQUIRE(!is_visible);
+          REQUIRE(!is_special);
+        }
+        else if (block.db().visibilityComp != nullptr) {
+          REQUIRE(is_special);
+          REQUIRE(!is_visible);
+          special++;
+        }
+        else {
+          const uint16_t sides = block.visibleFaces(bsb, bx, by, bz);
+          REQUIRE(is_visible == (sides != 0));
+          if (is_visible) REQUIRE(masks->visibleFaces(bx, by, bz) == sides);
+          cubes += is_visible;
+        }
+      }
+    }
+    REQUIRE(cubes > 0);
+    REQUIRE(special == 64);
+  }
+
+  // and the meshes are the exact same bytes
+  gameconf.greedy_meshing = false;
+  const auto masked = mesh_sector(center);
+  const auto reference = mesh_sector_per_block(center);
+  REQUIRE(masked.size() == reference.size());
+  REQUIRE(memcmp(masked.data(), reference.data(), masked.size() * sizeof(vertex_t)) == 0);
+}
+
+// a lake over the terrain, with a stone island sticking out of it
+static const int LAKE_LEVEL = 47;
+static void flood_terrain()
+{
+  const auto& mb = test_blocks();
+  for (int sx = MX-1; sx <= MX+1; sx++)
+  for (int sz = MZ-1; sz <= MZ+1; sz++)
+  {
+    auto& sector = sectors(sx, sz);
+    const bool center = (sx == MX && sz == MZ);
+    for (int x = 0; x < BLOCKS_XZ; x++)
+    for (int z = 0; z < BLOCKS_XZ; z++)
+    {
+      for (int y = sector.flat()(x, z).skyLevel; y < LAKE_LEVEL; y++)
+        sector(x, y, z) = Block(mb.water);
+      if (center && x >= 3 && x < 6 && z >= 9 && z < 13)
+        for (int y = 40; y <= LAKE_LEVEL; y++) sector(x, y, z) = Block(mb.stone);
+      int top = BLOCKS_Y;
+      while (top > 0 && sector(x, top-1, z).isAir()) top--;
+      sector.flat()(x, z).skyLevel = top;
+      for (int y = 0; y < top; y++) sector(x, y, z).setLight(0, 0);
+    }
+  }
+  sectors(MX, MZ).getBlocks().addLight(CAVE_X0, CAVE_Y0, CAVE_X0);
+  flood_sectors(MX-1, MZ-1, MX+1, MZ+1);
+}
+
+TEST_CASE("Fluid surfaces merge into large quads of equal light")
+{
+  mesher_settings_t settings;
+  generate_terrain();
+  flood_terrain();
+  auto& center = sectors(MX, MZ);
+  const int m = LAKE_LEVEL / Sector::MESH_LAYERS;
+
+  // the water of the sub-mesh, one quad per block face
+  std::unique_ptr<Precomp> pc(new Precomp(center, m));
+  std::unique_ptr<PrecompThread> pt(new PrecompThread);
+  pt->ptd.sector = &pc->sector;
+  for (int bx = 0; bx < BLOCKS_XZ; bx++)
+  for (int bz = 0; bz < BLOCKS_XZ; bz++)
+  for (int by = pc->y0(); by < pc->y1(); by++)
+  {
+    const Block& block = pc->sector(bx, by, bz);
+    if (block.isLiquid()) pt->ptd.process_block(block, bx, by, bz);
+  }
+  const auto plain = pt->ptd.vertices[RenderConst::TX_WATER];
+  REQUIRE(plain.size() >= (BLOCKS_XZ * BLOCKS_XZ - 12) * 4);
+
+  // and as the mesher leaves it, without greedy meshing for the rest
+  gameconf.greedy_meshing = false;
+  pt->precompile(*pc);
+  const auto begin = pc->datadump.begin() + pc->bufferoffset[RenderConst::TX_WATER];
+  const std::vector<vertex_t> merged(begin, begin + pc->vertices[RenderConst::TX_WATER]);
+  REQUIRE(merged.size() % 4 == 0);
+  REQUIRE(merged.size() * 8 < plain.size());
+  // the fluid shaders have no use for the texture coordinates
+  REQUIRE(coverage_mismatches(plain, merged, false) == 0);
+}
+
+TEST_CASE("Connected textures are looked up from the neighbor mask")
+{
+  generate_terrain();
+  const auto& mb = test_blocks();
+  auto& center = sectors(MX, MZ);
+  // a jagged lump of glass on the surface, reaching into the neighbors
+  for (int x = -1; x <= BLOCKS_XZ; x++)
+  for (int z = 4; z < 12; z++)
+  for (int y = 46; y < 52; y++)
+  {
+    if ((x * 7 + y * 3 + z * 5) % 4 == 0) continue;
+    auto& sector = sectors(MX + (x >> 4), MZ);
+    sector(x & (BLOCKS_XZ-1), y, z) = Block(mb.glass);
+  }
+  std::unique_ptr<Precomp> pc(new Precomp(center, 46 / Sector::MESH_LAYERS));
+  std::unique_ptr<PrecompThread> pt(new PrecompThread);
+  pt->ptd.sector = &pc->sector;
+
+  // the same as the function called with the 3x3 blocks in the plane of the face
+  static const int AXES[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+  int lookups = 0;
+  for (int x = 0; x < BLOCKS_XZ; x++)
+  for (int z = 4; z < 12; z++)
+  for (int y = 46; y < 52; y++)
+  {
+    const Block& block = pc->sector(x, y, z);
+    if (block.getID() != mb.glass) continue;
+    for (int face = 0; face < 6; face++)
+    {
+      connected_textures_t ct;
+      const int* axes = AXES[face / 2];
+      for (int j = -1; j <= 1; j++)
+      for (int i = -1; i <= 1; i++)
+      {
+        int pos[3] = {x, y, z};
+        pos[axes[0]] += i;
+        pos[axes[1]] += j;
+        ct.blocks[(j+1) * 3 + (i+1)] = pc->sector.get(pos[0], pos[1], pos[2]);
+      }
+      REQUIRE(pt->ptd.getConnectedTexture(block, x, y, z, face) == connected_tile(ct, face));
+      lookups++;
+    }
+  }
+  REQUIRE(lookups > 6 * 100);
+  // without neighbors, eg. as an item
+  connected_textures_t alone;
+  alone.self() = Block(mb.glass);
+  REQUIRE(Block(mb.glass).getTexture(2) == connected_tile(alone, 2));
+}
+
+TEST_CASE("Face lighting from light samples matches the per-corner average")
+{
+  mesher_settings_t settings;
+  // with an orange torch, and transparent blocks on the surface
+  auto& torch = db::BlockDB::get()[test_blocks().torch];
+  torch.setLightColor(TORCH_LEVEL, 7, 2);
+  Lighting::setColoredTorchlight(true);
+  generate_terrain();
+  plant_leaves();
+  auto& center = sectors(MX, MZ);
+  gameconf.greedy_meshing = false;
+  const auto sampled = mesh_sector(center);
+  const auto reference = mesh_sector_per_block(center);
+
+  int colored = 0;
+  for (const auto& v : sampled)
+    colored += (v.lightcolor & 0xFF) != ((v.lightcolor >> 8) & 0xFF);
+  REQUIRE(colored > 0);
+  REQUIRE(sampled.size() == reference.size());
+  REQUIRE(memcmp(sampled.data(), reference.data(), sampled.size() * sizeof(vertex_t)) == 0);
+}
+
+TEST_CASE("Face lighting throughput", "[.][benchmark]")
+{
+  generate_terrain();
+  auto& center = sectors(MX, MZ);
+  std::unique_ptr<Precomp> pc(new Precomp(center, SURFACE_MESH));
+  std::unique_ptr<PrecompThread> pt(new PrecompThread);
+  auto& ptd = pt->ptd;
+  ptd.sector = &pc->sector;
+  std::vector<vertex_t> quad(4);
+  static const int ROUNDS = 2000;
+
+  // every face of the sub-mesh, lit one corner at a time or from the samples
+  auto light_faces = [&] (bool samples) -> double {
+    library::Timer timer;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+      if (samples) ptd.prepareLighting(pc->y0() - 1, pc->y1() + 1);
+      else ptd.resetLighting();
+      for (int bx = 0; bx < BLOCKS_XZ; bx++)
+      for (int bz = 0; bz < BLOCKS_XZ; bz++)
+      for (int by = pc->y0(); by < pc->y1(); by++)
+      {
+        const Block& block = pc->sector(bx, by, bz);
+        if (block.isAir()) continue;
+        const uint16_t faces = block.visibleFaces(pc->sector, bx, by, bz);
+        if (faces & 1)  ptd.faceLighting_PZ(block, quad.begin(), bx, by, bz+1);
+        if (faces & 2)  ptd.faceLighting_NZ(block, quad.begin(), bx, by, bz-1);
+        if (faces & 4)  ptd.faceLighting_PY(block, quad.begin(), bx, by+1, bz);
+        if (faces & 8)  ptd.faceLighting_NY(block, quad.begin(), bx, by-1, bz);
+        if (faces & 16) ptd.faceLighting_PX(block, quad.begin(), bx+1, by, bz);
+        if (faces & 32) ptd.faceLighting_NX(block, quad.begin(), bx-1, by, bz);
+      }
+    }
+    return timer.getTime();
+  };
+  const double t_corner  = light_faces(false);
+  const double t_samples = light_faces(true);
+  printf("Face lighting, %d rounds: per corner %.1f ms, from light samples %.1f ms (%.2fx)\n",
+         ROUNDS, t_corner * 1e3, t_samples * 1e3, t_corner / t_samples);
+}
+
+TEST_CASE("Mesh jobs see the blocks as they were when queued")
+{
+  generate_terrain();
+  auto& center = sectors(MX, MZ);
+  const auto expected = mesh_sector(center);
+
+  // the job is created, then the world changes before it runs
+  std::vector<std::unique_ptr<Precomp>> jobs;
+  for (int m = 0; m < Sector::MESHES; m++)
+    jobs.emplace_back(new Precomp(center, m));
+  const auto& mb = test_blocks();
+  for (int x = CAVE_X0; x <= CAVE_X1; x++)
+  for (int z = CAVE_X0; z <= CAVE_X1; z++)
+    center(x, CAVE_Y0 + 2, z) = Block(mb.stone);
+  // and a hole into the neighbor, next to the cave
+  sectors(MX+1, MZ)(0, 30, 0) = Block(_AIR);
+
+  std::unique_ptr<PrecompThread> pt(new PrecompThread);
+  std::vector<vertex_t> meshed;
+  for (auto& pc : jobs)
+  {
+    mesh_job(*pt, *pc);
+    pc->sector.release();
+    meshed.insert(meshed.end(), pc->datadump.begin(), pc->datadump.end());
+  }
+  REQUIRE(meshed.size() == expected.size());
+  REQUIRE(memcmp(meshed.data(), expected.data(), expected.size() * sizeof(vertex_t)) == 0);
+  // while the world has moved on
+  const auto now = mesh_sector(center);
+  REQUIRE((now.size() != expected.size() ||
+           memcmp(now.data(), expected.data(), expected.size() * sizeof(vertex_t)) != 0));
+}
+
+static void fill_stone(int height)
+{
+  const auto& mb = test_blocks();
+  for (int sx = MX-1; sx <= MX+1; sx++)
+  for (int sz = MZ-1; sz <= MZ+1; sz++)
+  {
+    auto& sector = sectors(sx, sz);
+    for (int x = 0; x < BLOCKS_XZ; x++)
+    for (int z = 0; z < BLOCKS_XZ; z++)
+    {
+      for (int y = 0; y < BLOCKS_Y; y++)
+        sector(x, y, z) = Block((y < height) ? mb.stone : _AIR);
+      sector.flat()(x, z).skyLevel = height;
+    }
+  }
+}
+
+TEST_CASE("Face mask meshing throughput", "[.][benchmark]")
+{
+  static const int ROUNDS = 20;
+  mesher_settings_t settings;
+  gameconf.greedy_meshing = false;
+  auto& center = sectors(MX, MZ);
+  auto measure = [&center] (const char* name)
+  {
+    size_t verts = 0;
+    library::Timer timer;
+    for (int i = 0; i < ROUNDS; i++) verts += mesh_sector_per_block(center).size();
+    const double t_block = timer.getTime();
+    timer.restart();
+    for (int i = 0; i < ROUNDS; i++) verts -= mesh_sector(center).size();
+    const double t_masks = timer.getTime();
+    REQUIRE(verts == 0);
+    printf("%s: per-block %.3f ms/sector, face masks %.3f ms/sector (%.2fx)\n",
+           name, t_block * 1e3 / ROUNDS, t_masks * 1e3 / ROUNDS, t_block / t_masks);
+  };
+  generate_terrain();
+  measure("terrain");
+  fill_stone(BLOCKS_Y - 20);
+  measure("stone-heavy");
+  fill_stone(4);
+  measure("air-heavy");
+}
+
+TEST_CASE("Packed terrain vertices decode to the faces they replaced")
+{
+  mesher_settings_t settings;
+  generate_terrain();
+  for (bool greedy : {false, true})
+  {
+    INFO("greedy meshing " << greedy);
+    gameconf.greedy_meshing = greedy;
+    std::unique_ptr<Precomp> pc(new Precomp(sectors(MX, MZ), SURFACE_MESH));
+    std::unique_ptr<PrecompThread> pt(new PrecompThread);
+    pt->precompile(*pc);
+    pt->ambientOcclusion(*pc);
+    const auto original = pc->datadump;
+    uint32_t offsets[RenderConst::MAX_UNIQUE_SHADERS];
+    std::copy(pc->bufferoffset, pc->bufferoffset + RenderConst::MAX_UNIQUE_SHADERS, offsets);
+    pt->packTerrain(*pc);
+
+    size_t packed = 0;
+    for (int i = 0; i < RenderConst::MAX_UNIQUE_SHADERS; i++)
+    {
+      // every quad of the line is either packed or left as it was, in order
+      size_t full = pc->bufferoffset[i];
+      size_t pack = pc->packedoffset[i];
+      const size_t count = pc->vertices[i] + pc->packed[i];
+      for (size_t v = offsets[i]; v < offsets[i] + count; v += 4)
+      {
+        if (full < pc->bufferoffset[i] + pc->vertices[i]
+         && memcmp(&pc->datadump[full], &original[v], 4 * sizeof(vertex_t)) == 0)
+        {
+          full += 4;
+          continue;
+        }
+        REQUIRE(pack < pc->packedoffset[i] + pc->packed[i]);
+        for (int c = 0; c < 4; c++)
+        {
+          vertex_t expected = original[v + c];
+          expected.face = 0;
+          const vertex_t decoded = pc->packeddump[pack + c].unpack();
+          REQUIRE(memcmp(&decoded, &expected, sizeof(vertex_t)) == 0);
+        }
+        pack += 4;
+      }
+      REQUIRE(full == pc->bufferoffset[i] + pc->vertices[i]);
+      REQUIRE(pack == pc->packedoffset[i] + pc->packed[i]);
+      packed += pc->packed[i];
+    }
+    REQUIRE(packed > 0);
+    REQUIRE(pc->datadump.size() + pc->packeddump.size() == original.size());
+  }
+}
+
+// expands the indexed draws of a shader line back into triangle vertex ids
+static std::vector<uint32_t> expand_draws(const std::vector<indice_t>& ibo, uint32_t first, uint32_t count)
+{
+  std::vector<uint32_t> result;
+  quad_indices::draws(first, count,
+  [&] (uint32_t n, uint32_t basevertex) {
+    REQUIRE(n <= ibo.size());
+    for (uint32_t i = 0; i < n; i++) result.push_back(basevertex + ibo[i]);
+  });
+  return result;
+}
+
+TEST_CASE("Cross instances expand to the vertices they replaced")
+{
+  mesher_settings_t settings;
+  // grass all over the center sector, with an orange torch in it
+  const auto& mb = test_blocks();
+  auto& torch = db::BlockDB::get()[mb.torch];
+  torch.setLightColor(TORCH_LEVEL, 7, 2);
+  Lighting::setColoredTorchlight(true);
+  generate_terrain();
+  // a different terrain color at every corner
+  for (int sx = MX-1; sx <= MX+1; sx++)
+  for (int sz = MZ-1; sz <= MZ+1; sz++)
+  for (int x = 0; x < BLOCKS_XZ; x++)
+  for (int z = 0; z < BLOCKS_XZ; z++)
+    sectors(sx, sz).flat()(x, z).fcolor[Biomes::CL_GRASS] = (sx * BLOCKS_XZ + x) << 8 | (sz * BLOCKS_XZ + z);
+  auto& center = sectors(MX, MZ);
+  for (int x = 0; x < BLOCKS_XZ; x++)
+  for (int z = 0; z < BLOCKS_XZ; z++)
+  {
+    const int h = center.flat()(x, z).skyLevel;
+    center(x, h, z) = Block((x == 3 && z == 3) ? mb.torch : mb.grass);
+    center.flat()(x, z).skyLevel = h + 1;
+  }
+  center.getBlocks().addLight(3, center.flat()(3, 3).skyLevel - 1, 3);
+  Lighting::atmosphericFlood(center);
+
+  // the crosses of every sub-mesh, as vertices moved to their blocks
+  auto crosses = [&center] (bool instanced, size_t& instances)
+  {
+    gameconf.instanced_models = instanced;
+    std::vector<vertex_t> result;
+    std::unique_ptr<PrecompThread> pt(new PrecompThread);
+    for (int m = 0; m < Sector::MESHES; m++)
+    {
+      std::unique_ptr<Precomp> pc(new Precomp(center, m));
+      pt->precompile(*pc);
+      pt->ambientOcclusion(*pc);
+      const auto line = RenderConst::TX_TRANS_2SIDED;
+      const auto first = pc->datadump.begin() + pc->bufferoffset[line];
+      result.insert(result.end(), first, first + pc->vertices[line]);
+      for (const auto& inst : pc->instancedump)
+      {
+        vertex_t* vtx = expandCross(inst, result);
+        for (int i = 0; i < 8; i++) {
+          vtx[i].x += inst.x() * RenderConst::VERTEX_SCALE;
+          vtx[i].y += inst.y() * RenderConst::VERTEX_SCALE;
+          vtx[i].z += inst.z() * RenderConst::VERTEX_SCALE;
+        }
+      }
+      instances += pc->instancedump.size();
+    }
+    gameconf.instanced_models = false;
+    // in the same order, whole crosses at a time
+    std::vector<std::vector<vertex_t>> sorted;
+    for (size_t i = 0; i < result.size(); i += 8)
+      sorted.emplace_back(result.begin() + i, result.begin() + i + 8);
+    std::sort(sorted.begin(), sorted.end(),
+      [] (const std::vector<vertex_t>& a, const std::vector<vertex_t>& b) {
+        return memcmp(a.data(), b.data(), 8 * sizeof(vertex_t)) < 0;
+      });
+    return sorted;
+  };
+  size_t none = 0, instances = 0;
+  const auto plain = crosses(false, none);
+  const auto instanced = crosses(true, instances);
+
+  REQUIRE(none == 0);
+  REQUIRE(plain.size() == BLOCKS_XZ * BLOCKS_XZ - 1);
+  // the crosses near the torch stay as vertices, with their colored light
+  REQUIRE(instances > plain.size() / 2);
+  REQUIRE(instances < plain.size());
+  REQUIRE(instanced.size() == plain.size());
+  for (size_t i = 0; i < plain.size(); i++)
+    REQUIRE(memcmp(plain[i].data(), instanced[i].data(), 8 * sizeof(vertex_t)) == 0);
+}
+
+TEST_CASE("Shared quad indices cover the quad stream of each shader line")
+{
+  std::vector<indice_t> ibo(quad_indices::MAX_INDICES);
+  quad_indices::generate(ibo.data(), quad_indices::MAX_QUADS);
+  // a quad (a, b, c, d) becomes the triangles (a, b, c) and (a, c, d)
+  auto check_line = [] (const std::vector<uint32_t>& tris, uint32_t first, uint32_t quads)
+  {
+    REQUIRE(tris.size() == quads * 6);
+    for (uint32_t q = 0; q < quads; q++)
+    {
+      const uint32_t v = first + q * 4;
+      const uint32_t expected[6] = { v, v+1, v+2, v, v+2, v+3 };
+      REQUIRE(std::equal(expected, expected + 6, &tris[q * 6]));
+    }
+  };
+  // lines larger than the 16-bit indices can address are split
+  const uint32_t LARGE = quad_indices::MAX_QUADS * 2 + 123;
+  check_line(expand_draws(ibo, 1000, LARGE * 6), 1000, LARGE);
+
+  generate_terrain();
+  mesher_settings_t settings;
+  gameconf.packed_vertices = true;
+  std::unique_ptr<Precomp> pc(new Precomp(sectors(MX, MZ), SURFACE_MESH));
+  std::unique_ptr<PrecompThread> pt(new PrecompThread);
+  mesh_job(*pt, *pc);
+
+  size_t total = 0;
+  for (int i = 0; i < RenderConst::MAX_UNIQUE_SHADERS; i++)
+  {
+    REQUIRE(pc->indices[i] == pc->vertices[i] / 4 * 6);
+    REQUIRE(pc->packedindices[i] == pc->packed[i] / 4 * 6);
+    check_line(expand_draws(ibo, pc->bufferoffset[i], pc->indices[i]),
+               pc->bufferoffset[i], pc->vertices[i] / 4);
+    check_line(expand_draws(ibo, pc->packedoffset[i], pc->packedindices[i]),
+               pc->packedoffset[i], pc->packed[i] / 4);
+    // and every index stays inside the buffers
+    if (pc->vertices[i]) REQUIRE(pc->bufferoffset[i] + pc->vertices[i] <= pc->datadump.size());
+    if (pc->packed[i]) REQUIRE(pc->packedoffset[i] + pc->packed[i] <= pc->packeddump.size());
+    total += pc->vertices[i] + pc->packed[i];
+  }
+  REQUIRE(total == pc->datadump.size() + pc->packeddump.size());
+  REQUIRE(total > 0);
+}
+
+TEST_CASE("Distant sectors are meshed with fewer, larger cubes")
+{
+  generate_terrain();
+  auto& center = sectors(MX, MZ);
+  const int S = RenderConst::VERTEX_SCALE;
+  std::vector<vertex_t> meshes[Sector::LOD_LEVELS];
+  for (int lod = 0; lod < Sector::LOD_LEVELS; lod++)
+  {
+    meshes[lod] = mesh_sector(center, lod);
+    const int cell = S << lod;
+    bool covered[BLOCKS_XZ][BLOCKS_XZ] = {};
+    int skirts[6] = {0};
+    for (size_t q = 0; q < meshes[lod].size(); q += 4)
+    {
+      const vertex_t* quad = &meshes[lod][q];
+      const int face = terrain_vertex_t::faceOf(*quad);
+      REQUIRE(face >= 0);
+      int lo[3] = {1 << 30, 1 << 30, 1 << 30}, hi[3] = {-1, -1, -1};
+      for (int i = 0; i < 4; i++)
+      {
+        const int p[3] = { quad[i].x, quad[i].y, quad[i].z };
+        for (int a = 0; a < 3; a++) {
+          lo[a] = std::min(lo[a], p[a]);
+          hi[a] = std::max(hi[a], p[a]);
+          // every corner is on the grid of the cells
+          REQUIRE(p[a] % cell == 0);
+        }
+      }
+      // the faces on top cover the whole sector, with no holes
+      if (face == 2)
+        for (int x = lo[0] / S; x < hi[0] / S; x++)
+        for (int z = lo[2] / S; z < hi[2] / S; z++) covered[x][z] = true;
+      // and the faces on the sides of the sector hide the cracks
+      if ((face == 0 && lo[2] == BLOCKS_XZ * S) || (face == 1 && lo[2] == 0) ||
+          (face == 4 && lo[0] == BLOCKS_XZ * S) || (face == 5 && lo[0] == 0)) skirts[face]++;
+    }
+    for (int x = 0; x < BLOCKS_XZ; x++)
+    for (int z = 0; z < BLOCKS_XZ; z++) REQUIRE(covered[x][z]);
+    if (lod > 0)
+    {
+      for (int face : {0, 1, 4, 5}) REQUIRE(skirts[face] >= BLOCKS_XZ >> lod);
+      REQUIRE(meshes[lod].size() < meshes[lod-1].size());
+    }
+  }
+}
+
+// counts the heap allocations made by the whole test program, while enabled
+static std::atomic<bool> count_allocations {false};
+static std::atomic<size_t> allocations {0};
+
+void* operator new(size_t size)
+{
+  if (count_allocations) allocations++;
+  if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+TEST_CASE("Remeshing with warm buffers does not allocate")
+{
+  mesher_settings_t settings;
+  gameconf.greedy_meshing = true;
+  gameconf.packed_vertices = true;
+  generate_terrain();
+  auto& center = sectors(MX, MZ);
+  std::unique_ptr<PrecompThread> pt(new PrecompThread);
+  std::unique_ptr<Precomp> pc(new Precomp(center, 0));
+  // every sub-mesh as a mesh job, reusing one precomp
+  auto remesh = [&] () {
+    size_t verts = 0;
+    for (int m = 0; m < Sector::MESHES; m++)
+    {
+      pc->reset(center, m);
+      mesh_job(*pt, *pc);
+      verts += pc->datadump.size() + pc->packeddump.size();
+    }
+    return verts;
+  };
+  // the first round grows the buffers, after that they are big enough
+  const size_t warm = remesh();
+  REQUIRE(warm > 0);
+
+  allocations = 0;
+  count_allocations = true;
+  const size_t verts = remesh();
+  count_allocations = false;
+  REQUIRE(verts == warm);
+  REQUIRE(allocations == 0);
+}
+
+TEST_CASE("Sub-mesh rebuild latency", "[.][benchmark]")
+{
+  static const int ROUNDS = 50;
+  mesher_settings_t settings;
+  gameconf.greedy_meshing = true;
+  gameconf.packed_vertices = true;
+  generate_terrain();
+  auto& center = sectors(MX, MZ);
+  std::unique_ptr<PrecompThread> pt(new PrecompThread);
+  auto rebuild = [&] (int m) {
+    std::unique_ptr<Precomp> pc(new Precomp(center, m));
+    mesh_job(*pt, *pc);
+    return pc->datadump.size() + pc->packeddump.size();
+  };
+  // caves all the way down, so that every sub-mesh below the surface has faces
+  for (int y = 2; y < 36; y += 6)
+  for (int x = 1; x < BLOCKS_XZ-1; x += 4)
+  for (int z = 1; z < BLOCKS_XZ-1; z += 4)
+  for (int i = 0; i < 8; i++)
+    center(x + (i & 1), y + (i >> 2), z + ((i >> 1) & 1)) = Block(_AIR);
+  // an edit at the surface dirties one sub-mesh, instead of the whole sector
+  library::Timer timer;
+  size_t verts = 0;
+  for (int i = 0; i < ROUNDS; i++)
+    for (int m = 0; m < Sector::MESHES; m++) verts += rebuild(m);
+  const double t_all = timer.getTime();
+  timer.restart();
+  for (int i = 0; i < ROUNDS; i++) verts -= rebuild(SURFACE_MESH);
+  const double t_one = timer.getTime();
+  REQUIRE(verts > 0);
+  printf("Rebuild after an edit: whole sector %.3f ms, one sub-mesh %.3f ms (%.2fx)\n",
+         t_all * 1e3 / ROUNDS, t_one * 1e3 / ROUNDS, t_all / t_one);
+}
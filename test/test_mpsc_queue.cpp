@@ -0,0 +1,73 @@
+#include "mpsc_queue.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <catch.hpp>
+using namespace cppcraft;
+
+TEST_CASE("MPSC queue is bounded, and drains in order")
+{
+  MPSCQueue<std::unique_ptr<int>, 4> queue;
+  for (int i = 0; i < 4; i++)
+    REQUIRE(queue.try_push(std::make_unique<int> (i)));
+  // full, and the item stays with the caller
+  auto extra = std::make_unique<int> (4);
+  REQUIRE(queue.try_push(std::move(extra)) == false);
+  REQUIRE(extra != nullptr);
+  REQUIRE(queue.size() == 4);
+  REQUIRE(queue.stats().full == 1);
+
+  // in batches
+  std::vector<int> drained;
+  auto take = [&drained] (std::unique_ptr<int> value) { drained.push_back(*value); };
+  REQUIRE(queue.drain(take, 3) == 3);
+  REQUIRE(queue.try_push(std::move(extra)));
+  REQUIRE(queue.drain(take) == 2);
+  REQUIRE(queue.drain(take) == 0);
+  REQUIRE(drained == std::vector<int>({0, 1, 2, 3, 4}));
+  REQUIRE(queue.size() == 0);
+  REQUIRE(queue.stats().count == 5);
+}
+
+TEST_CASE("MPSC queue stress, many producers and one consumer")
+{
+  static const int PRODUCERS = 4;
+  static const int ITEMS = 50000;
+  // small enough that the producers keep finding it full
+  MPSCQueue<int, 64> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < PRODUCERS; p++)
+  {
+    producers.emplace_back(
+    [&queue, p] {
+      for (int i = 0; i < ITEMS; i++) queue.push(p * ITEMS + i);
+    });
+  }
+
+  // the items of each producer arrive in the order they were pushed
+  std::vector<int> next(PRODUCERS, 0);
+  int total = 0;
+  bool in_order = true;
+  while (total < PRODUCERS * ITEMS)
+  {
+    const size_t count = queue.drain(
+    [&] (int value) {
+      const int p = value / ITEMS;
+      if (value % ITEMS != next[p]) in_order = false;
+      next[p]++;
+    }, 16);
+    total += count;
+    if (count == 0) std::this_thread::yield();
+  }
+  for (auto& thread : producers) thread.join();
+
+  REQUIRE(in_order);
+  REQUIRE(queue.drain([] (int) {}) == 0);
+  for (int p = 0; p < PRODUCERS; p++) REQUIRE(next[p] == ITEMS);
+  const auto st = queue.stats();
+  REQUIRE(st.count == PRODUCERS * ITEMS);
+  REQUIRE(st.worst_ms >= st.avg_ms);
+}
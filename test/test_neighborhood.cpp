@@ -0,0 +1,126 @@
+#include "neighborhood.hpp"
+#include "spiders.hpp"
+#include <library/timing/timer.hpp>
+#include <cstdio>
+
+#include <catch.hpp>
+using namespace cppcraft;
+
+TEST_CASE("Neighborhood view addresses the same blocks as Spiders")
+{
+  auto& center = sectors(10, 10);
+  const NeighborhoodView<> view(center);
+  REQUIRE(&view.center() == &center);
+
+  for (int x = -BLOCKS_XZ; x < 2 * BLOCKS_XZ; x++)
+  for (int z = -BLOCKS_XZ; z < 2 * BLOCKS_XZ; z++)
+  {
+    REQUIRE(view.valid(x, 0, z));
+    const int gx = view.toGridX(x);
+    const int gz = view.toGridZ(z);
+    REQUIRE(view.fromGridX(gx) == x);
+    REQUIRE(view.fromGridZ(gz) == z);
+    for (int y : {0, 1, 64, BLOCKS_Y-1})
+    {
+      REQUIRE(&view.get(x, y, z) == &Spiders::getBlock(gx, y, gz));
+    }
+    int wx = gx, wy = 0, wz = gz;
+    REQUIRE(&view.sector(x, z) == Spiders::wrap(wx, wy, wz));
+  }
+  // outside the view, and above or below the world
+  REQUIRE(!view.valid(-BLOCKS_XZ-1, 0, 0));
+  REQUIRE(!view.valid(0, 0, 2 * BLOCKS_XZ));
+  REQUIRE(!view.valid(0, -1, 0));
+  REQUIRE(!view.valid(0, BLOCKS_Y, 0));
+
+  // sectors outside the world are not part of the view
+  const NeighborhoodView<> corner(sectors(0, 0));
+  REQUIRE(corner.valid(0, 1, 0));
+  REQUIRE(!corner.valid(-1, 1, 0));
+  REQUIRE(!corner.valid(0, 1, -1));
+  REQUIRE(corner.valid(BLOCKS_XZ, 1, BLOCKS_XZ));
+
+  // a wider view reaches two sectors away
+  const NeighborhoodView<2> wide(center);
+  REQUIRE(&wide.get(-2 * BLOCKS_XZ, 1, 3 * BLOCKS_XZ - 1)
+       == &Spiders::getBlock(view.toGridX(-2 * BLOCKS_XZ), 1, view.toGridZ(3 * BLOCKS_XZ - 1)));
+}
+
+// the walk removeSkylight used to do, resolving the sector on every step
+static inline bool step_lookup(int& x, int& y, int& z, int dir)
+{
+  switch (dir) {
+  case 0: x++; break;
+  case 1: x--; break;
+  case 2: y++; break;
+  case 3: y--; break;
+  case 4: z++; break;
+  case 5: z--; break;
+  }
+  return !(x < 0 || y < 0 || z < 0 ||
+           x >= sectors.getXZ() * BLOCKS_XZ ||
+           z >= sectors.getXZ() * BLOCKS_XZ || y >= BLOCKS_Y);
+}
+static inline bool step_view(const NeighborhoodView<>& view, int& x, int& y, int& z, int dir)
+{
+  switch (dir) {
+  case 0: return view.valid(++x, z);
+  case 1: return view.valid(--x, z);
+  case 2: return ++y < BLOCKS_Y;
+  case 3: return --y >= 0;
+  case 4: return view.valid(x, ++z);
+  case 5: return view.valid(x, --z);
+  }
+  return false;
+}
+
+TEST_CASE("Neighborhood view per-step cost", "[.][benchmark]")
+{
+  static const int ROUNDS = 64;
+  auto& center = sectors(10, 10);
+  const int bx = center.getX() * BLOCKS_XZ;
+  const int bz = center.getZ() * BLOCKS_XZ;
+  long steps = 0;
+  unsigned sum_lookup = 0, sum_view = 0;
+
+  // rays of length 15 out of every block in a slab of the center sector
+  library::Timer timer;
+  for (int round = 0; round < ROUNDS; round++)
+  for (int x = 0; x < BLOCKS_XZ; x++)
+  for (int z = 0; z < BLOCKS_XZ; z++)
+  for (int y = 32; y < 96; y++)
+  for (int dir = 0; dir < 6; dir++)
+  {
+    int rx = bx + x, ry = y, rz = bz + z;
+    for (int i = 0; i < 15 && step_lookup(rx, ry, rz, dir); i++)
+    {
+      Sector& sector = sectors(rx / BLOCKS_XZ, rz / BLOCKS_XZ);
+      sum_lookup += sector(rx & (BLOCKS_XZ-1), ry, rz & (BLOCKS_XZ-1)).getID() + 1;
+      steps++;
+    }
+  }
+  const double t_lookup = timer.getTime();
+
+  timer.restart();
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    // the view is pinned once per operation, same as the lighting code
+    const NeighborhoodView<> view(center);
+    for (int x = 0; x < BLOCKS_XZ; x++)
+    for (int z = 0; z < BLOCKS_XZ; z++)
+    for (int y = 32; y < 96; y++)
+    for (int dir = 0; dir < 6; dir++)
+    {
+      int rx = x, ry = y, rz = z;
+      for (int i = 0; i < 15 && step_view(view, rx, ry, rz, dir); i++)
+      {
+        sum_view += view.get(rx, ry, rz).getID() + 1;
+      }
+    }
+  }
+  const double t_view = timer.getTime();
+  REQUIRE(sum_lookup == sum_view);
+
+  printf("%ld steps: sector lookup %.2f ns/step, view %.2f ns/step (%.2fx)\n",
+         steps, t_lookup * 1e9 / steps, t_view * 1e9 / steps, t_lookup / t_view);
+}
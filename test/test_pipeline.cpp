@@ -0,0 +1,117 @@
+#include "pipeline.hpp"
+#include "precompq.hpp"
+#include "sectors.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <catch.hpp>
+using namespace cppcraft;
+
+static void finish_terrain(Sector& sector)
+{
+  sector.clear();
+  sector.flat().assign_new();
+  Pipeline::terrainDone(sector);
+}
+
+TEST_CASE("Sectors move through the pipeline as their neighbors finish")
+{
+  // the center is meshed once the 3x3 around it is lit,
+  // and each of those once the 3x3 around them has its terrain
+  const int CX = 20, CZ = 20;
+  for (int x = -2; x <= 2; x++)
+  for (int z = -2; z <= 2; z++)
+  {
+    auto& sector = sectors(CX + x, CZ + z);
+    sector.regenerate();
+    sector.dirtyMeshes = 0;
+  }
+  auto& center = sectors(CX, CZ);
+  auto& corner = sectors(CX + 2, CZ + 2);
+  REQUIRE(Pipeline::stage(center) == Pipeline::GENERATE);
+  REQUIRE(Pipeline::waitingOn(center) == "nothing");
+
+  // everything but the corner
+  for (int x = -2; x <= 2; x++)
+  for (int z = -2; z <= 2; z++)
+  {
+    if (x == 2 && z == 2) continue;
+    finish_terrain(sectors(CX + x, CZ + z));
+  }
+  REQUIRE(Pipeline::stage(center) == Pipeline::LIGHT);
+  REQUIRE(Pipeline::waitingOn(center) == "light queue");
+  REQUIRE(Pipeline::waitingOn(sectors(CX + 1, CZ + 1)) == corner.to_string() + " generate");
+
+  while (Pipeline::size()) Pipeline::run();
+  REQUIRE(center.atmospherics);
+  REQUIRE(sectors(CX + 1, CZ + 1).atmospherics == false);
+  REQUIRE(Pipeline::stage(center) == Pipeline::MESH);
+  REQUIRE(Pipeline::meshReady(center) == false);
+  REQUIRE(Pipeline::waitingOn(center) == sectors(CX + 1, CZ + 1).to_string() + " light");
+
+  // objects hold back the neighbors, until the last one is done
+  corner.clear();
+  corner.flat().assign_new();
+  corner.objects = 1;
+  REQUIRE(Pipeline::stage(corner) == Pipeline::OBJECTS);
+  REQUIRE(Pipeline::waitingOn(corner) == "1 objects");
+  REQUIRE(Pipeline::waitingOn(sectors(CX + 1, CZ + 1)) == corner.to_string() + " objects");
+  corner.objects = 0;
+  Pipeline::terrainDone(corner);
+
+  while (Pipeline::size()) Pipeline::run();
+  REQUIRE(sectors(CX + 1, CZ + 1).atmospherics);
+  REQUIRE(Pipeline::meshReady(center));
+  REQUIRE(center.dirtyMeshes == (1 << Sector::MESHES) - 1);
+  // the outer ring is missing neighbors of its own
+  REQUIRE(Pipeline::stage(corner) == Pipeline::LIGHT);
+  REQUIRE(Pipeline::waitingOn(corner) == sectors(CX + 1, CZ + 3).to_string() + " generate");
+}
+
+TEST_CASE("The mesh queue puts edits first, then the view, distance and age")
+{
+  typedef PrecompQ::job_t job_t;
+  const auto t0 = PrecompQ::clock::now();
+  const auto t1 = t0 + std::chrono::milliseconds(10);
+  Sector* sector = &sectors(20, 20);
+  // each job loses to the one before it on exactly one key
+  const std::vector<job_t> expected {
+    { sector, true,  false, 9, t1 }, // edited, even far away and out of view
+    { sector, false, true,  5, t0 }, // in view, even further away
+    { sector, false, true,  6, t0 },
+    { sector, false, false, 1, t1 }, // nearest of those out of view
+    { sector, false, false, 2, t0 }, // waited longest at the same distance
+    { sector, false, false, 2, t1 },
+  };
+  std::vector<job_t> heap;
+  for (size_t i : {4, 1, 5, 0, 3, 2})
+  {
+    heap.push_back(expected[i]);
+    std::push_heap(heap.begin(), heap.end(), PrecompQ::later);
+  }
+  for (const auto& job : expected)
+  {
+    std::pop_heap(heap.begin(), heap.end(), PrecompQ::later);
+    const job_t& next = heap.back();
+    REQUIRE(next.edited == job.edited);
+    REQUIRE(next.inview == job.inview);
+    REQUIRE(next.distance == job.distance);
+    REQUIRE(next.queued == job.queued);
+    heap.pop_back();
+  }
+}
+
+TEST_CASE("The mesh queue measures turning the shortest way around")
+{
+  const float PI = 4 * atan(1);
+  REQUIRE(PrecompQ::turned(0.2f, 0.0f, 0.17f));
+  REQUIRE(PrecompQ::turned(0.0f, 0.2f, 0.17f));
+  REQUIRE(PrecompQ::turned(0.1f, 0.0f, 0.17f) == false);
+  // across the wrap, in either direction and over several turns
+  REQUIRE(PrecompQ::turned(PI - 0.05f, -PI + 0.05f, 0.17f) == false);
+  REQUIRE(PrecompQ::turned(-PI + 0.05f, PI - 0.05f, 0.17f) == false);
+  REQUIRE(PrecompQ::turned(2 * PI - 0.05f, 0.0f, 0.17f) == false);
+  REQUIRE(PrecompQ::turned(4 * PI + 0.05f, 0.0f, 0.17f) == false);
+  REQUIRE(PrecompQ::turned(PI, 0.0f, 0.17f));
+}
@@ -0,0 +1,78 @@
+#include "threadpool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <catch.hpp>
+using namespace cppcraft;
+
+TEST_CASE("Scheduled jobs run by priority, then in order")
+{
+  AsyncPool::init(1);
+  // hold the only worker, while the jobs queue up behind it
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool open = false;
+  AsyncPool::sched(AsyncPool::BACKGROUND, [&] {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [&] { return open; });
+  });
+  while (AsyncPool::stats(AsyncPool::BACKGROUND).queued > 0) std::this_thread::yield();
+
+  std::vector<int> order;
+  auto record = [&order] (int id) { return [&order, id] { order.push_back(id); }; };
+  AsyncPool::sched(AsyncPool::BACKGROUND, record(4));
+  AsyncPool::sched(AsyncPool::GENERATION, record(2));
+  AsyncPool::sched(AsyncPool::GENERATION, record(3));
+  AsyncPool::sched(AsyncPool::EDIT, record(0));
+  AsyncPool::sched(AsyncPool::VISIBLE, record(1));
+  REQUIRE(AsyncPool::accepts(AsyncPool::GENERATION) == false);
+  REQUIRE(AsyncPool::accepts(AsyncPool::EDIT) == false);
+  REQUIRE(AsyncPool::stats(AsyncPool::GENERATION).queued == 2);
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    open = true;
+  }
+  cv.notify_one();
+  AsyncPool::stop();
+
+  REQUIRE(order == std::vector<int>({0, 1, 2, 3, 4}));
+  REQUIRE(AsyncPool::stats(AsyncPool::GENERATION).completed == 2);
+  REQUIRE(AsyncPool::stats(AsyncPool::BACKGROUND).completed == 2);
+  REQUIRE(AsyncPool::stats(AsyncPool::VISIBLE).completed == 1);
+  REQUIRE(AsyncPool::stats(AsyncPool::VISIBLE).wait_ms > 0.0);
+}
+
+TEST_CASE("Jobs scheduled by a worker are stolen by idle workers")
+{
+  static const int JOBS = 64;
+  AsyncPool::init(4);
+  std::mutex mtx;
+  std::set<std::thread::id> threads;
+  std::atomic<int> done {0};
+
+  // one job fans out into its own deque, where the others steal from
+  AsyncPool::sched(AsyncPool::GENERATION, [&] {
+    for (int i = 0; i < JOBS; i++)
+    {
+      AsyncPool::sched(AsyncPool::GENERATION, [&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::lock_guard<std::mutex> lock(mtx);
+        threads.insert(std::this_thread::get_id());
+        done++;
+      });
+    }
+  });
+  AsyncPool::stop();
+
+  REQUIRE(done == JOBS);
+  REQUIRE(threads.size() > 1);
+  const auto st = AsyncPool::stats(AsyncPool::GENERATION);
+  REQUIRE(st.queued == 0);
+  REQUIRE(st.completed == 1 + JOBS);
+}
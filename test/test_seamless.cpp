@@ -0,0 +1,114 @@
+#include "player.hpp"
+#include "seamless.hpp"
+#include "sectors.hpp"
+#include <vector>
+
+#include <catch.hpp>
+using namespace cppcraft;
+
+// every sector knows where it is, and is found there from either side of the grid
+static void check_grid()
+{
+  const int XZ = sectors.getXZ();
+  const auto delta = world.getDelta();
+  REQUIRE(delta.x >= 0);
+  REQUIRE(delta.x < XZ);
+  REQUIRE(delta.z >= 0);
+  REQUIRE(delta.z < XZ);
+  for (int x = 0; x < XZ; x++)
+  for (int z = 0; z < XZ; z++)
+  {
+    Sector& sector = sectors(x, z);
+    REQUIRE(sector.getX() == x);
+    REQUIRE(sector.getZ() == z);
+    REQUIRE(&sectors(x - XZ, z) == &sector);
+    REQUIRE(&sectors(x, z - XZ) == &sector);
+  }
+}
+
+// walks the player past the seam once, towards (dx, dz)
+static void transition(int dx, int dz)
+{
+  const int XZ = sectors.getXZ();
+  const float half = XZ * BLOCKS_XZ / 2;
+  // the row that falls off one edge comes back as the new opposite edge
+  auto leaving = [XZ, dx, dz] (int i) -> Sector& {
+    if (dx) return sectors((dx > 0) ? 0 : XZ-1, i);
+    return sectors(i, (dz > 0) ? 0 : XZ-1);
+  };
+  auto entering = [XZ, dx, dz] (int i) -> Sector& {
+    if (dx) return sectors((dx > 0) ? XZ-1 : 0, i);
+    return sectors(i, (dz > 0) ? XZ-1 : 0);
+  };
+  for (int x = 0; x < XZ; x++)
+  for (int z = 0; z < XZ; z++)
+    sectors(x, z).gen_flags = Sector::GENERATED;
+  std::vector<Sector*> row;
+  std::vector<uint32_t> generations;
+  for (int i = 0; i < XZ; i++) {
+    row.push_back(&leaving(i));
+    generations.push_back(row.back()->generation());
+  }
+  Sector& middle = sectors(XZ/2, XZ/2);
+  const uint32_t inside = middle.generation();
+  const int wx = world.getWX(), wz = world.getWZ();
+
+  player.pos.x = half + dx * Seamless::OFFSET;
+  player.pos.z = half + dz * Seamless::OFFSET;
+  REQUIRE(Seamless::run());
+  REQUIRE(player.pos.x == half + dx * (Seamless::OFFSET - BLOCKS_XZ));
+  REQUIRE(player.pos.z == half + dz * (Seamless::OFFSET - BLOCKS_XZ));
+  REQUIRE(world.getWX() == wx + dx);
+  REQUIRE(world.getWZ() == wz + dz);
+  check_grid();
+
+  for (int i = 0; i < XZ; i++)
+  {
+    Sector& sector = entering(i);
+    REQUIRE(&sector == row[i]);
+    REQUIRE(sector.generation() == generations[i] + 1);
+    // cleared, and queued for its new content
+    REQUIRE((sector.gen_flags & ~Sector::GENERATING) == 0);
+    REQUIRE(sector.generating());
+  }
+  // while the rest keep what they have
+  REQUIRE(&sectors(XZ/2 - dx, XZ/2 - dz) == &middle);
+  REQUIRE(middle.generation() == inside);
+  REQUIRE(middle.generated());
+  REQUIRE(middle.generating() == false);
+}
+
+TEST_CASE("The sector grid wraps around as the world shifts both ways")
+{
+  const int XZ = sectors.getXZ();
+  // the rest of the tests see the sectors as they were
+  std::vector<uint8_t> flags;
+  std::vector<uint16_t> dirty;
+  for (int x = 0; x < XZ; x++)
+  for (int z = 0; z < XZ; z++) {
+    flags.push_back(sectors(x, z).gen_flags);
+    dirty.push_back(sectors(x, z).dirtyMeshes);
+  }
+  const auto pos = player.pos;
+  const auto snap_pos = player.snap_pos;
+  check_grid();
+
+  // past the wrap of the delta, and back again, on both axes
+  for (int i = 0; i < XZ + 2; i++) transition(1, 0);
+  REQUIRE(world.getDeltaX() == 2);
+  for (int i = 0; i < XZ + 2; i++) transition(-1, 0);
+  REQUIRE(world.getDeltaX() == 0);
+  for (int i = 0; i < 3; i++) transition(0, -1);
+  REQUIRE(world.getDeltaZ() == XZ - 3);
+  for (int i = 0; i < 3; i++) transition(0, 1);
+  REQUIRE(world.getDeltaZ() == 0);
+
+  player.pos = pos;
+  player.snap_pos = snap_pos;
+  size_t i = 0;
+  for (int x = 0; x < XZ; x++)
+  for (int z = 0; z < XZ; z++, i++) {
+    sectors(x, z).gen_flags = flags[i];
+    sectors(x, z).dirtyMeshes = dirty[i];
+  }
+}
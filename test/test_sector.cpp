@@ -1,6 +1,10 @@
+#include "neighborhood.hpp"
+#include "precompiler.hpp"
 #include "sectors.hpp"
 #include "spiders.hpp"
 
+#include <memory>
+
 #include <catch.hpp>
 using namespace cppcraft;
 
@@ -29,3 +33,209 @@ TEST_CASE("Sector blockdata tests")
 
 
 }
+
+TEST_CASE("Sector light emitter index")
+{
+  auto sb = std::make_unique<sectorblock_t> ();
+  REQUIRE(sb->emitterCount() == 0);
+  REQUIRE(!sb->emittersOverflowed());
+
+  sb->addLight(1, 2, 3);
+  sb->addLight(4, 5, 6);
+  sb->addLight(1, 2, 3); // no duplicates
+  REQUIRE(sb->emitterCount() == 2);
+  REQUIRE(sb->getLight(2));
+  REQUIRE(sb->highest_light_y == 5);
+
+  sb->removeLight(1, 2, 3);
+  REQUIRE(sb->emitterCount() == 1);
+  REQUIRE(sb->emitters()[0].x == 4);
+  REQUIRE(sb->emitters()[0].y == 5);
+  REQUIRE(sb->emitters()[0].z == 6);
+
+  // too many lights falls back to the per-y light bits
+  for (int i = 0; i <= sectorblock_t::MAX_EMITTERS; i++)
+    sb->addLight(i & 15, 64 + i / 16, 0);
+  REQUIRE(sb->emittersOverflowed());
+  REQUIRE(sb->emitterCount() == 0);
+  REQUIRE(sb->getLight(64));
+
+  sb->clearLights();
+  REQUIRE(!sb->emittersOverflowed());
+  REQUIRE(sb->emitterCount() == 0);
+  REQUIRE(sb->highest_light_y == 0);
+}
+
+TEST_CASE("Light emitters are saved with the record")
+{
+  auto& db = db::BlockDB::get();
+  const block_t LIGHT = db.create("sector_test_light").getID();
+  db[LIGHT].setLightColor(10, 10, 10);
+
+  auto sb = std::make_unique<sectorblock_t> ();
+  for (auto& blk : sb->b) blk = Block(_AIR);
+  sb->clearLights();
+  (*sb)(1, 2, 3) = Block(LIGHT);
+  sb->addLight(1, 2, 3);
+  (*sb)(4, 70, 6) = Block(LIGHT);
+  sb->addLight(4, 70, 6);
+
+  // only the saved record comes back from disk
+  auto loaded = std::make_unique<sectorblock_t> ();
+  static_cast<sectorblock_record_t&>(*loaded) = *sb;
+  REQUIRE(loaded->emitterCount() == 2);
+  REQUIRE(loaded->emitters()[0].y == 2);
+  REQUIRE(loaded->emitters()[1].x == 4);
+  REQUIRE(loaded->emitters()[1].y == 70);
+}
+
+TEST_CASE("Torch colors are only allocated once written, and never saved")
+{
+  auto sb = std::make_unique<sectorblock_t> ();
+  const sectorblock_t& readonly = *sb;
+  REQUIRE(sb->torchColorsAllocated() == false);
+  REQUIRE(readonly.torchColor(1, 2, 3) == 0);
+  REQUIRE(sb->torchColorsAllocated() == false);
+
+  sb->torchColor(1, 2, 3) = 0x123;
+  REQUIRE(sb->torchColorsAllocated());
+  // copies (as the sector makes while a snapshot is held) have their own
+  sectorblock_t copy(*sb);
+  copy.torchColor(1, 2, 3) = 0x321;
+  REQUIRE(sb->torchColor(1, 2, 3) == 0x123);
+  REQUIRE(copy.torchColor(1, 2, 3) == 0x321);
+
+  sb->clearTorchColors();
+  REQUIRE(sb->torchColorsAllocated() == false);
+  // the saved record is the blocks, their light bits and the emitters, but no colors
+  REQUIRE(sizeof(sectorblock_record_t) < sizeof(sectorblock_record_t::b) + 64
+      + sectorblock_record_t::MAX_EMITTERS * sizeof(sectorblock_record_t::emitter_t));
+}
+
+TEST_CASE("Sector snapshots are copy-on-write")
+{
+  auto& sector = sectors(3, 3);
+  sector.clear();
+  const auto* before = &sector.getBlocks();
+  // no snapshot, no copies
+  sector(1, 2, 3) = Block(1);
+  REQUIRE(&sector.getBlocks() == before);
+
+  auto snapshot = sector.snapshot();
+  REQUIRE(snapshot.get() == before);
+  const auto version = snapshot->version();
+  // writing while a snapshot is held moves the sector to a copy
+  sector(1, 2, 3) = Block(2);
+  REQUIRE(&sector.getBlocks() != before);
+  REQUIRE(sector.getBlocks().version() != version);
+  REQUIRE(sector(1, 2, 3).getID() == 2);
+  // ... and the snapshot is left as it was
+  REQUIRE((*snapshot)(1, 2, 3).getID() == 1);
+  REQUIRE(snapshot->version() == version);
+
+  // once released, writes stay in place again
+  snapshot = nullptr;
+  const auto* after = &sector.getBlocks();
+  sector(1, 2, 3) = Block(3);
+  REQUIRE(&sector.getBlocks() == after);
+}
+
+TEST_CASE("Reading blocks does not copy them while a snapshot is held")
+{
+  auto& sector = sectors(3, 3);
+  auto& neighbor = sectors(4, 3);
+  sector.clear();
+  neighbor.clear();
+  auto snapshot = sector.snapshot();
+  auto other = neighbor.snapshot();
+
+  // the const accessors, Spiders and the reads of a view leave them shared
+  const Sector& readonly = sector;
+  REQUIRE(readonly(1, 2, 3).getID() == _AIR);
+  REQUIRE(&sector.blocks() == snapshot.get());
+  REQUIRE(&Spiders::getBlock(sector, 1, 2, 3) == &(*snapshot)(1, 2, 3));
+  const NeighborhoodView<> view(sector);
+  REQUIRE(&view.get(BLOCKS_XZ + 1, 2, 3) == &(*other)(1, 2, 3));
+  REQUIRE(view.getTorchColor(BLOCKS_XZ + 1, 2, 3) == 0);
+  REQUIRE(&sector.blocks() == snapshot.get());
+  REQUIRE(&neighbor.blocks() == other.get());
+
+  // only the sector that is written to moves on to a copy
+  view(BLOCKS_XZ + 1, 2, 3).setSkyLight(7);
+  REQUIRE(&neighbor.blocks() != other.get());
+  REQUIRE(view.get(BLOCKS_XZ + 1, 2, 3).getSkyLight() == 7);
+  REQUIRE((*other)(1, 2, 3).getSkyLight() != 7);
+  REQUIRE(&sector.blocks() == snapshot.get());
+}
+
+TEST_CASE("Block changes only dirty the sub-meshes that can see them")
+{
+  auto& sector = sectors(5, 5);
+  auto dirty = [&sector] (int y0, int y1) {
+    sector.dirtyMeshes = 0;
+    sector.updateMeshes(y0, y1);
+    return sector.dirtyMeshes;
+  };
+  const int L = Sector::MESH_LAYERS;
+  // inside a sub-mesh, and next to the one below or above
+  REQUIRE(dirty(L + 5, L + 5) == 1 << 1);
+  REQUIRE(dirty(L, L) == (1 << 0 | 1 << 1));
+  REQUIRE(dirty(2*L - 1, 2*L - 1) == (1 << 1 | 1 << 2));
+  // the bottom and top of the world
+  REQUIRE(dirty(0, 0) == 1 << 0);
+  REQUIRE(dirty(BLOCKS_Y-1, BLOCKS_Y-1) == 1 << (Sector::MESHES-1));
+  // ranges
+  REQUIRE(dirty(L + 5, 3*L + 5) == (1 << 1 | 1 << 2 | 1 << 3));
+  sector.updateAllMeshes();
+  REQUIRE(sector.dirtyMeshes == (1 << Sector::MESHES) - 1);
+  sector.dirtyMeshes = 0;
+}
+
+TEST_CASE("A view sends each changed sector to be remeshed once it is done")
+{
+  auto& sector = sectors(5, 5);
+  auto& neighbor = sectors(6, 5);
+  sector.clear();
+  neighbor.clear();
+  sector.dirtyMeshes = 0;
+  neighbor.dirtyMeshes = 0;
+  {
+    const NeighborhoodView<> view(sector);
+    view.changed(1, 5, 1);
+    view.changed(2, 100, 3);
+    view.changed(BLOCKS_XZ, 40, 0);
+    REQUIRE(sector.dirtyMeshes == 0);
+    REQUIRE(neighbor.dirtyMeshes == 0);
+    // a copy starts out without changes, so nothing is sent twice
+    const NeighborhoodView<> copy(view);
+  }
+  REQUIRE(sector.dirtyMeshes == (Sector::meshMask(5, 5) | Sector::meshMask(100, 100)));
+  REQUIRE(neighbor.dirtyMeshes == Sector::meshMask(40, 40));
+  sector.dirtyMeshes = 0;
+  neighbor.dirtyMeshes = 0;
+}
+
+TEST_CASE("Jobs are stale once their sector has new content")
+{
+  for (int x = 8; x <= 10; x++)
+  for (int z = 8; z <= 10; z++)
+  {
+    sectors(x, z).flat().assign_new();
+    sectors(x, z).clear();
+  }
+  auto& sector = sectors(9, 9);
+  auto pc = std::make_unique<Precomp> (sector, 0);
+  REQUIRE(pc->stale() == false);
+  // writing blocks only makes for a newer mesh
+  sector(1, 2, 3) = Block(1);
+  REQUIRE(pc->stale() == false);
+
+  const auto generation = sector.generation();
+  sector.regenerate();
+  REQUIRE(sector.generation() != generation);
+  REQUIRE(pc->stale());
+  // a job started now is for the new content
+  sector.clear();
+  pc->reset(sector, 1);
+  REQUIRE(pc->stale() == false);
+}